@@ -0,0 +1,119 @@
+#include "benchmarks.h"
+
+#include "algorithm.h"
+
+using namespace afk;
+using namespace std;
+
+namespace vparser {
+
+  // An instance connected to two nets, as in a flattened CGRA netlist
+  class bench_instance {
+  public:
+    unsigned in;
+    unsigned out;
+  };
+
+  static vector<bench_instance> bench_instances(const int n, const unsigned num_nets) {
+    vector<bench_instance> insts;
+    unsigned state = 1;
+    auto next = [&state]() {
+      state = state*1103515245u + 12345u;
+      return state >> 8;
+    };
+
+    for (int i = 0; i < n; i++) {
+      insts.push_back({next() % num_nets, next() % num_nets});
+    }
+    return insts;
+  }
+
+  static bool share_net(const bench_instance& x, const bench_instance& y) {
+    return (x.in == y.in) || (x.in == y.out) || (x.out == y.in) || (x.out == y.out);
+  }
+
+  // connected_components_by as it was before union_find: a depth first
+  // search over the unvisited indexes, removing each node's neighbors
+  // from them with a linear search per neighbor
+  static vector<vector<unsigned> >
+  dfs_components(const vector<bench_instance>& insts) {
+    vector<vector<unsigned> > comps;
+    vector<unsigned> inds(insts.size());
+    iota(begin(inds), end(inds), 0);
+
+    while (inds.size() > 0) {
+      vector<unsigned> comp;
+      vector<unsigned> buf{inds.back()};
+      inds.pop_back();
+
+      while (buf.size() > 0) {
+        unsigned next = buf.back();
+        comp.push_back(next);
+        buf.pop_back();
+
+        vector<unsigned> neighbors;
+        for (auto u : inds) {
+          if (u != next && share_net(insts[u], insts[next])) {
+            buf.push_back(u);
+            neighbors.push_back(u);
+          }
+        }
+        delete_if(inds, [&neighbors](const unsigned i) {
+            return std::find(begin(neighbors), end(neighbors), i) != end(neighbors);
+          });
+      }
+      comps.push_back(comp);
+    }
+    return comps;
+  }
+
+  // Instances grouped through the nets they share, the way a netlist
+  // pass would build its graph
+  static vector<vector<unsigned> >
+  net_components(const vector<bench_instance>& insts, const unsigned num_nets) {
+    vector<unsigned> first_on_net(num_nets, insts.size());
+    vector<vector<unsigned> > adjacency(insts.size());
+    for (unsigned i = 0; i < insts.size(); i++) {
+      for (unsigned net : {insts[i].in, insts[i].out}) {
+        if (first_on_net[net] == insts.size()) {
+          first_on_net[net] = i;
+        } else {
+          adjacency[i].push_back(first_on_net[net]);
+        }
+      }
+    }
+    return connected_components(adjacency);
+  }
+
+  void run_algorithm_benchmarks(bench_suite& suite) {
+    // Slightly more nets than instances gives many components of every
+    // size, a few nets one component of nearly everything
+    for (string shape : {"sparse", "dense"}) {
+      for (int n : {1000, 4000}) {
+        unsigned num_nets = shape == "sparse" ? n + n / 4 : 20;
+        vector<bench_instance> insts = bench_instances(n, num_nets);
+        bench_work work(0, 0, n);
+        string name = "/" + shape + "_" + std::to_string(n);
+
+        suite.run("connected_components_old_dfs" + name, work, [&insts]() {
+            dfs_components(insts);
+          });
+
+        suite.run("connected_components_by" + name, work, [&insts]() {
+            connected_components_by(insts, share_net);
+          });
+
+        suite.run("connected_components_adjacency" + name, work, [&insts, num_nets]() {
+            net_components(insts, num_nets);
+          });
+      }
+    }
+
+    int n = 100000;
+    vector<bench_instance> insts = bench_instances(n, n + n / 4);
+    suite.run("connected_components_adjacency/sparse_" + std::to_string(n),
+              bench_work(0, 0, n),
+              [&insts, n]() { net_components(insts, n + n / 4); });
+  }
+
+}
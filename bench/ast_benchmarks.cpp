@@ -0,0 +1,270 @@
+#include "benchmarks.h"
+
+#include "expression_interner.h"
+#include "flat_ast.h"
+#include "parse.h"
+#include "skim.h"
+#include "visitor.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+using namespace std;
+
+namespace vparser {
+
+  // Sums identifier lengths and counts nodes, the same result from every
+  // traversal so they can be compared
+  class traversal_sum {
+  public:
+    uint64_t nodes;
+    uint64_t id_chars;
+
+    traversal_sum() : nodes(0), id_chars(0) {}
+  };
+
+  class crtp_summer : public ast_visitor<crtp_summer> {
+  public:
+    traversal_sum sum;
+
+    visit_result pre_expression(const expression*) {
+      sum.nodes++;
+      return VISIT_CONTINUE;
+    }
+
+    visit_result pre_statement(const statement*) {
+      sum.nodes++;
+      return VISIT_CONTINUE;
+    }
+
+    visit_result pre_id(const id_expr* e) {
+      sum.id_chars += e->get_name().size();
+      return pre_expression(e);
+    }
+  };
+
+  // The classic visitor: every hook is a virtual call
+  class virtual_visitor {
+  public:
+    virtual void visit_expression(const expression* e) = 0;
+    virtual void visit_statement(const statement* s) = 0;
+    virtual void visit_id(const id_expr* e) = 0;
+
+    virtual ~virtual_visitor() {}
+  };
+
+  class virtual_summer : public virtual_visitor {
+  public:
+    traversal_sum sum;
+
+    virtual void visit_expression(const expression*) { sum.nodes++; }
+    virtual void visit_statement(const statement*) { sum.nodes++; }
+
+    virtual void visit_id(const id_expr* e) {
+      sum.id_chars += e->get_name().size();
+      sum.nodes++;
+    }
+  };
+
+  // Only here so the compiler cannot tell which visitor it calls
+  class virtual_counter : public virtual_visitor {
+  public:
+    traversal_sum sum;
+
+    virtual void visit_expression(const expression*) { sum.nodes++; }
+    virtual void visit_statement(const statement*) { sum.nodes++; }
+    virtual void visit_id(const id_expr*) { sum.nodes++; }
+  };
+
+  static volatile bool count_only = false;
+
+  // Where the walks leave their sums, so they are not optimized away
+  static volatile uint64_t walk_sink = 0;
+
+  // Walks with the CRTP traversal but forwards each node through a
+  // virtual_visitor pointer, so only the dispatch differs
+  class virtual_dispatch_walker : public ast_visitor<virtual_dispatch_walker> {
+  public:
+    virtual_visitor* vis;
+
+    virtual_dispatch_walker(virtual_visitor* vis_) : vis(vis_) {}
+
+    visit_result pre_expression(const expression* e) {
+      vis->visit_expression(e);
+      return VISIT_CONTINUE;
+    }
+
+    visit_result pre_statement(const statement* s) {
+      vis->visit_statement(s);
+      return VISIT_CONTINUE;
+    }
+
+    visit_result pre_id(const id_expr* e) {
+      vis->visit_id(e);
+      return VISIT_CONTINUE;
+    }
+  };
+
+  template<typename T>
+  void add_nodes(traversal_sum& sum, const array_view<T>& arr) {
+    sum.nodes += arr.size();
+  }
+
+  // The flat AST needs no traversal to visit every node: it scans each
+  // kind's array
+  traversal_sum scan_flat(const flat_ast_view& v) {
+    traversal_sum sum;
+
+    for (auto& e : v.id_exprs) {
+      sum.id_chars += v.string_offsets[e.name + 1] - v.string_offsets[e.name];
+    }
+
+    add_nodes(sum, v.id_exprs);
+    add_nodes(sum, v.num_exprs);
+    add_nodes(sum, v.slice_exprs);
+    add_nodes(sum, v.string_literal_exprs);
+    add_nodes(sum, v.unop_exprs);
+    add_nodes(sum, v.binop_exprs);
+    add_nodes(sum, v.trinop_exprs);
+    add_nodes(sum, v.concat_exprs);
+    add_nodes(sum, v.float_exprs);
+
+    add_nodes(sum, v.decl_stmts);
+    add_nodes(sum, v.always_stmts);
+    add_nodes(sum, v.begin_stmts);
+    add_nodes(sum, v.if_stmts);
+    add_nodes(sum, v.assign_stmts);
+    add_nodes(sum, v.case_stmts);
+    add_nodes(sum, v.empty_stmts);
+    add_nodes(sum, v.module_instantiation_stmts);
+    add_nodes(sum, v.blocking_assign_stmts);
+    add_nodes(sum, v.non_blocking_assign_stmts);
+    add_nodes(sum, v.call_stmts);
+
+    return sum;
+  }
+
+  // The walks are only comparable if they visit the same nodes
+  static void check_sums_agree(const char* name,
+                               const traversal_sum& sum,
+                               const traversal_sum& expected) {
+    if ((sum.nodes != expected.nodes) || (sum.id_chars != expected.id_chars)) {
+      fprintf(stderr,
+              "%s found %llu nodes and %llu id chars, the flat scan %llu and %llu\n",
+              name,
+              (unsigned long long) sum.nodes,
+              (unsigned long long) sum.id_chars,
+              (unsigned long long) expected.nodes,
+              (unsigned long long) expected.id_chars);
+      exit(1);
+    }
+  }
+
+  void run_ast_benchmarks(bench_suite& suite,
+                          const std::vector<bench_file>& files) {
+    bench_work parse_total;
+    for (auto& file : files) {
+      parse_total.bytes += file.preprocessed.size();
+      parse_total.tokens += file.tokens.size();
+      parse_total.nodes += file.nodes;
+    }
+
+    // Skimming only finds the module hierarchy, compare with
+    // parse_module/corpus
+    suite.run("skim/corpus", parse_total, [&files]() {
+        hierarchy_graph graph;
+        for (auto& file : files) {
+          skim_hierarchy(file.tokens, graph);
+        }
+      });
+
+    // Hash-consed parsing, compare with parse_module/corpus
+    bench_result* res =
+      suite.run("parse_module_interned/corpus", parse_total, [&files]() {
+          expression_interner interner;
+          for (auto& file : files) {
+            token_stream ts(file.tokens);
+            ts.set_interner(&interner);
+            parse_module(ts);
+          }
+        });
+    if (res != nullptr) {
+      expression_interner interner;
+      for (auto& file : files) {
+        token_stream ts(file.tokens);
+        ts.set_interner(&interner);
+        parse_module(ts);
+      }
+      suite.add_extra(res, "expression_bytes", interner.requested_memory_bytes());
+      suite.add_extra(res, "interned_expression_bytes", interner.memory_bytes());
+    }
+
+    if (!suite.selected("flat") && !suite.selected("walk")) {
+      return;
+    }
+
+    // Heap bytes held by the pointer ASTs of the corpus
+    heap_counters before = get_heap_counters();
+    vector<unique_ptr<verilog_module> > modules;
+    for (auto& file : files) {
+      token_stream ts(file.tokens);
+      modules.emplace_back(new verilog_module(parse_module(ts)));
+    }
+    uint64_t pointer_ast_bytes = get_heap_counters().live_bytes - before.live_bytes;
+
+    bench_work nodes_total(0, 0, parse_total.nodes);
+
+    flat_ast flat;
+    res = suite.run("flatten/corpus", nodes_total, [&modules]() {
+        flat_ast f;
+        for (auto& mod : modules) {
+          f.add_module(*mod);
+        }
+      });
+    for (auto& mod : modules) {
+      flat.add_module(*mod);
+    }
+    suite.add_extra(res, "pointer_ast_bytes", pointer_ast_bytes);
+    suite.add_extra(res, "flat_ast_bytes", flat.memory_bytes());
+
+    traversal_sum expected = scan_flat(flat.view());
+
+    crtp_summer crtp_check;
+    virtual_summer virtual_check;
+    virtual_dispatch_walker virtual_check_walker(&virtual_check);
+    for (auto& mod : modules) {
+      crtp_check.walk(*mod);
+      virtual_check_walker.walk(*mod);
+    }
+    check_sums_agree("walk_crtp", crtp_check.sum, expected);
+    check_sums_agree("walk_virtual", virtual_check.sum, expected);
+
+    suite.run("walk_crtp/corpus", nodes_total, [&modules]() {
+        crtp_summer summer;
+        for (auto& mod : modules) {
+          summer.walk(*mod);
+        }
+        walk_sink = summer.sum.id_chars;
+      });
+
+    suite.run("walk_virtual/corpus", nodes_total, [&modules]() {
+        virtual_summer summer;
+        virtual_counter counter;
+        virtual_visitor* vis = count_only ?
+          static_cast<virtual_visitor*>(&counter) : &summer;
+
+        virtual_dispatch_walker walker(vis);
+        for (auto& mod : modules) {
+          walker.walk(*mod);
+        }
+        walk_sink = summer.sum.id_chars + counter.sum.nodes;
+      });
+
+    flat_ast_view view = flat.view();
+    suite.run("walk_flat_scan/corpus", nodes_total, [&view]() {
+        walk_sink = scan_flat(view).id_chars;
+      });
+  }
+
+}
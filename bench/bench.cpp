@@ -0,0 +1,188 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+
+using namespace std;
+
+namespace vparser {
+
+  void bench_suite::record_times(bench_result& res, std::vector<double>& times) {
+    sort(times.begin(), times.end());
+    res.iterations = times.size();
+    res.min_ns = times.front();
+    res.median_ns = times[times.size() / 2];
+  }
+
+  std::string format_time(const double ns) {
+    char buf[32];
+    if (ns < 1e3) {
+      snprintf(buf, sizeof(buf), "%.0f ns", ns);
+    } else if (ns < 1e6) {
+      snprintf(buf, sizeof(buf), "%.2f us", ns / 1e3);
+    } else if (ns < 1e9) {
+      snprintf(buf, sizeof(buf), "%.2f ms", ns / 1e6);
+    } else {
+      snprintf(buf, sizeof(buf), "%.2f s", ns / 1e9);
+    }
+    return buf;
+  }
+
+  void bench_suite::report(const bench_result& res) {
+    printf("%-40s %8d iters %12s", res.name.c_str(), res.iterations,
+           format_time(res.median_ns).c_str());
+    if (res.work.bytes > 0) {
+      printf(" %9.1f MB/s", res.mb_per_s());
+    }
+    if (res.work.tokens > 0) {
+      printf(" %8.2f Mtok/s", res.tokens_per_s() / 1e6);
+    }
+    if (res.work.nodes > 0) {
+      printf(" %8.2f Mnode/s", res.nodes_per_s() / 1e6);
+    }
+    printf(" %9llu allocs %9.1f KB heap peak\n",
+           (unsigned long long) res.allocations,
+           res.peak_heap_bytes / 1024.0);
+    fflush(stdout);
+  }
+
+  void bench_suite::add_extra(bench_result* res,
+                              const std::string& key,
+                              const double val) {
+    if (res == nullptr) {
+      return;
+    }
+
+    res->extra[key] = val;
+    printf("%-40s   %s = %.6g\n", "", key.c_str(), val);
+  }
+
+  std::string json_string(const std::string& str) {
+    string res = "\"";
+    for (char c : str) {
+      if ((c == '"') || (c == '\\')) {
+        res += '\\';
+      }
+      res += c;
+    }
+    return res + "\"";
+  }
+
+  // One benchmark per line, which load_baseline relies on
+  std::string results_to_json(const std::vector<bench_result>& results) {
+    ostringstream out;
+    out.precision(17);
+
+    out << "{\n  \"peak_rss_kb\": " << peak_rss_kb() << ",\n";
+    out << "  \"benchmarks\": [\n";
+    for (unsigned i = 0; i < results.size(); i++) {
+      auto& res = results[i];
+      out << "    {\"name\": " << json_string(res.name)
+          << ", \"iterations\": " << res.iterations
+          << ", \"median_ns\": " << res.median_ns
+          << ", \"min_ns\": " << res.min_ns
+          << ", \"bytes\": " << res.work.bytes
+          << ", \"tokens\": " << res.work.tokens
+          << ", \"nodes\": " << res.work.nodes
+          << ", \"mb_per_s\": " << res.mb_per_s()
+          << ", \"tokens_per_s\": " << res.tokens_per_s()
+          << ", \"nodes_per_s\": " << res.nodes_per_s()
+          << ", \"allocations\": " << res.allocations
+          << ", \"allocated_bytes\": " << res.allocated_bytes
+          << ", \"peak_heap_bytes\": " << res.peak_heap_bytes
+          << ", \"peak_rss_kb\": " << res.peak_rss_kb
+          << ", \"extra\": {";
+
+      bool first = true;
+      for (auto& ent : res.extra) {
+        out << (first ? "" : ", ") << json_string(ent.first) << ": " << ent.second;
+        first = false;
+      }
+      out << "}}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.str();
+  }
+
+  // The value after "key": on line, which must be there
+  bool json_field(const std::string& line, const std::string& key, std::string& val) {
+    string pattern = "\"" + key + "\": ";
+    size_t start = line.find(pattern);
+    if (start == string::npos) {
+      return false;
+    }
+    start += pattern.size();
+
+    size_t end = start;
+    if (line[start] == '"') {
+      start++;
+      end = start;
+      while ((end < line.size()) && (line[end] != '"')) {
+        end += line[end] == '\\' ? 2 : 1;
+      }
+    } else {
+      end = line.find_first_of(",}", start);
+    }
+
+    if (end == string::npos) {
+      return false;
+    }
+
+    val = line.substr(start, end - start);
+    return true;
+  }
+
+  bool load_baseline(const std::string& path,
+                     std::map<std::string, double>& median_ns) {
+    ifstream in(path);
+    if (!in) {
+      return false;
+    }
+
+    string line;
+    while (getline(in, line)) {
+      string name, ns;
+      if (json_field(line, "name", name) &&
+          json_field(line, "median_ns", ns)) {
+        median_ns[name] = atof(ns.c_str());
+      }
+    }
+
+    return true;
+  }
+
+  int compare_to_baseline(const std::vector<bench_result>& results,
+                          const std::map<std::string, double>& baseline,
+                          const double threshold) {
+    printf("\n%-40s %12s %12s %9s\n", "benchmark", "baseline", "current", "change");
+
+    int regressions = 0;
+    for (auto& res : results) {
+      auto it = baseline.find(res.name);
+      if ((it == baseline.end()) || (it->second <= 0)) {
+        continue;
+      }
+
+      double change = res.median_ns / it->second - 1.0;
+      bool regressed = change > threshold;
+      if (regressed) {
+        regressions++;
+      }
+
+      printf("%-40s %12s %12s %+8.1f%%%s\n",
+             res.name.c_str(),
+             format_time(it->second).c_str(),
+             format_time(res.median_ns).c_str(),
+             100*change,
+             regressed ? "  REGRESSION" : "");
+    }
+
+    return regressions;
+  }
+
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "heap_counters.h"
+
+namespace vparser {
+
+  // Work done by one iteration of a benchmark, used for the rates
+  class bench_work {
+  public:
+    uint64_t bytes;
+    uint64_t tokens;
+    uint64_t nodes;
+
+    bench_work() : bytes(0), tokens(0), nodes(0) {}
+
+    bench_work(const uint64_t bytes_,
+               const uint64_t tokens_,
+               const uint64_t nodes_) :
+      bytes(bytes_), tokens(tokens_), nodes(nodes_) {}
+  };
+
+  class bench_result {
+  public:
+    std::string name;
+    int iterations;
+
+    // Per iteration: the fastest and the median
+    double min_ns;
+    double median_ns;
+
+    bench_work work;
+
+    // Per iteration, from the first (untimed) run
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+    uint64_t peak_heap_bytes;
+
+    uint64_t peak_rss_kb;
+
+    // Benchmark specific numbers, such as memory use of a structure
+    std::map<std::string, double> extra;
+
+    double mb_per_s() const { return rate(work.bytes) / 1e6; }
+    double tokens_per_s() const { return rate(work.tokens); }
+    double nodes_per_s() const { return rate(work.nodes); }
+
+    double rate(const uint64_t per_iteration) const {
+      return median_ns > 0 ? per_iteration / (median_ns * 1e-9) : 0;
+    }
+  };
+
+  class bench_options {
+  public:
+    // Only benchmarks whose name contains filter are run
+    std::string filter;
+
+    // Each benchmark runs until it has used min_time seconds, at least
+    // once after the untimed first run
+    double min_time;
+    int max_iterations;
+
+    bool per_file;
+
+    bench_options() :
+      filter(""), min_time(0.25), max_iterations(1000000), per_file(false) {}
+  };
+
+  class bench_suite {
+    bench_options options;
+    std::vector<bench_result> results;
+
+    template<typename F>
+    void time_iterations(bench_result& res, F& f) {
+      std::vector<double> times;
+      double total = 0;
+      while ((times.empty() || (total < options.min_time * 1e9)) &&
+             ((int) times.size() < options.max_iterations)) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        times.push_back(ns);
+        total += ns;
+      }
+
+      record_times(res, times);
+    }
+
+    void record_times(bench_result& res, std::vector<double>& times);
+
+    void report(const bench_result& res);
+
+  public:
+
+    bench_suite(const bench_options& options_) : options(options_) {}
+
+    const bench_options& get_options() const { return options; }
+
+    bool selected(const std::string& name) const {
+      return name.find(options.filter) != std::string::npos;
+    }
+
+    // Runs f once untimed to count its allocations and warm up, then
+    // times it. Returns the result so callers can add extra numbers.
+    template<typename F>
+    bench_result* run(const std::string& name, const bench_work& work, F f) {
+      if (!selected(name)) {
+        return nullptr;
+      }
+
+      bench_result res;
+      res.name = name;
+      res.work = work;
+
+      reset_heap_peak();
+      heap_counters before = get_heap_counters();
+      f();
+      heap_counters after = get_heap_counters();
+
+      res.allocations = after.allocations - before.allocations;
+      res.allocated_bytes = after.allocated_bytes - before.allocated_bytes;
+      res.peak_heap_bytes = after.peak_live_bytes - before.live_bytes;
+
+      time_iterations(res, f);
+      res.peak_rss_kb = peak_rss_kb();
+
+      report(res);
+      results.push_back(res);
+      return &results.back();
+    }
+
+    // Records and prints a benchmark specific number for res, which
+    // must be the result of the latest run
+    void add_extra(bench_result* res, const std::string& key, const double val);
+
+    const std::vector<bench_result>& get_results() const { return results; }
+  };
+
+  std::string results_to_json(const std::vector<bench_result>& results);
+
+  // Reads name and median_ns back from a file written by
+  // results_to_json, false if the file cannot be read
+  bool load_baseline(const std::string& path,
+                     std::map<std::string, double>& median_ns);
+
+  // Prints the change against the baseline for every benchmark in both
+  // and returns the number that got slower by more than threshold
+  int compare_to_baseline(const std::vector<bench_result>& results,
+                          const std::map<std::string, double>& baseline,
+                          const double threshold);
+
+}
@@ -0,0 +1,168 @@
+#include "bench.h"
+#include "benchmarks.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include <dirent.h>
+
+using namespace std;
+using namespace vparser;
+
+// Set by CMake: build type, LTO and PGO stage
+#ifndef VPARSER_BUILD_CONFIG
+#define VPARSER_BUILD_CONFIG ""
+#endif
+
+static void usage() {
+  printf("usage: vparser-bench [options] [file.v ...]\n"
+         "  --samples DIR     corpus directory, default ./test/samples\n"
+         "  --no-samples      only benchmark the files given\n"
+         "  --filter STR      run benchmarks whose name contains STR\n"
+         "  --min-time SEC    time each benchmark for at least SEC seconds\n"
+         "  --per-file        also run each phase on each file\n"
+         "  --json FILE       write the results as JSON\n"
+         "  --baseline FILE   compare with JSON from an earlier run\n"
+         "  --threshold PCT   slowdown that counts as a regression, default 10\n"
+         "  --trace FILE      write a Chrome trace of a parallel parse of the corpus\n"
+         "  --threads N       threads for --trace, default one per hardware thread\n");
+}
+
+static vector<string> verilog_files(const string& dir) {
+  vector<string> paths;
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) {
+    return paths;
+  }
+
+  while (struct dirent* ent = readdir(d)) {
+    string name = ent->d_name;
+    if ((name.size() > 2) && (name.compare(name.size() - 2, 2, ".v") == 0)) {
+      paths.push_back(dir + "/" + name);
+    }
+  }
+  closedir(d);
+
+  sort(paths.begin(), paths.end());
+  return paths;
+}
+
+int main(int argc, char** argv) {
+  bench_options options;
+  string samples_dir = "./test/samples";
+  bool use_samples = true;
+  string json_path, baseline_path, trace_path;
+  double threshold = 10;
+  int trace_threads = 0;
+  vector<string> paths;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--samples" && has_value) {
+      samples_dir = argv[++i];
+    } else if (arg == "--no-samples") {
+      use_samples = false;
+    } else if (arg == "--filter" && has_value) {
+      options.filter = argv[++i];
+    } else if (arg == "--min-time" && has_value) {
+      options.min_time = atof(argv[++i]);
+    } else if (arg == "--per-file") {
+      options.per_file = true;
+    } else if (arg == "--json" && has_value) {
+      json_path = argv[++i];
+    } else if (arg == "--baseline" && has_value) {
+      baseline_path = argv[++i];
+    } else if (arg == "--threshold" && has_value) {
+      threshold = atof(argv[++i]);
+    } else if (arg == "--trace" && has_value) {
+      trace_path = argv[++i];
+    } else if (arg == "--threads" && has_value) {
+      trace_threads = atoi(argv[++i]);
+    } else if ((arg.size() > 0) && (arg[0] != '-')) {
+      paths.push_back(arg);
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  if (use_samples) {
+    vector<string> samples = verilog_files(samples_dir);
+    paths.insert(paths.begin(), samples.begin(), samples.end());
+  }
+
+  // The parser logs to cout, which would be timed along with it
+  streambuf* cout_buf = cout.rdbuf(nullptr);
+
+  vector<bench_file> files;
+  uint64_t corpus_bytes = 0;
+  for (auto& path : paths) {
+    bench_file file;
+    if (!load_bench_file(path, file)) {
+      fprintf(stderr, "Skipping %s, it could not be read or parsed\n", path.c_str());
+      continue;
+    }
+    corpus_bytes += file.text.size();
+    files.push_back(std::move(file));
+  }
+
+  if (files.empty()) {
+    fprintf(stderr, "No benchmark input, see --samples\n");
+    return 2;
+  }
+
+  if (string(VPARSER_BUILD_CONFIG) != "") {
+    printf("build: %s\n", VPARSER_BUILD_CONFIG);
+  }
+  printf("%d files, %.1f KB\n\n", (int) files.size(), corpus_bytes / 1024.0);
+
+  bench_suite suite(options);
+  run_parse_benchmarks(suite, files);
+  run_ast_benchmarks(suite, files);
+  run_driver_benchmarks(suite, files);
+  run_algorithm_benchmarks(suite);
+
+  bool trace_ok =
+    trace_path.empty() || write_driver_trace(files, trace_threads, trace_path);
+
+  cout.rdbuf(cout_buf);
+
+  if (!trace_ok) {
+    fprintf(stderr, "Could not write %s\n", trace_path.c_str());
+    return 2;
+  }
+
+  printf("\npeak RSS %llu KB\n", (unsigned long long) peak_rss_kb());
+
+  if (!json_path.empty()) {
+    ofstream out(json_path);
+    out << results_to_json(suite.get_results());
+    if (!out) {
+      fprintf(stderr, "Could not write %s\n", json_path.c_str());
+      return 2;
+    }
+  }
+
+  if (!baseline_path.empty()) {
+    map<string, double> baseline;
+    if (!load_baseline(baseline_path, baseline)) {
+      fprintf(stderr, "Could not read baseline %s\n", baseline_path.c_str());
+      return 2;
+    }
+
+    int regressions =
+      compare_to_baseline(suite.get_results(), baseline, threshold / 100.0);
+    if (regressions > 0) {
+      printf("\n%d benchmarks slower than the baseline by more than %.0f%%\n",
+             regressions, threshold);
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "token.h"
+
+namespace vparser {
+
+  // A corpus file with the inputs every phase starts from
+  class bench_file {
+  public:
+    std::string name;
+    std::string path;
+    std::string text;
+    std::string preprocessed;
+    std::vector<token> tokens;
+
+    // AST nodes in the parsed module and the length of its to_string
+    uint64_t nodes;
+    uint64_t printed_bytes;
+  };
+
+  bool load_bench_file(const std::string& path, bench_file& file);
+
+  // tokenize, preprocess_code, parse_module, parse_statement,
+  // parse_expression and printing
+  void run_parse_benchmarks(bench_suite& suite,
+                            const std::vector<bench_file>& files);
+
+  // Flat AST, visitor dispatch, hash-consing and skim parsing
+  void run_ast_benchmarks(bench_suite& suite,
+                          const std::vector<bench_file>& files);
+
+  // parse_files on one thread and on every hardware thread, with and
+  // without tracing
+  void run_driver_benchmarks(bench_suite& suite,
+                             const std::vector<bench_file>& files);
+
+  // afk connected components: the old depth first search, union-find
+  // by predicate, sequential and parallel, and by adjacency list
+  void run_algorithm_benchmarks(bench_suite& suite);
+
+  // One traced parse_files run over the corpus on num_threads threads
+  bool write_driver_trace(const std::vector<bench_file>& files,
+                          const int num_threads,
+                          const std::string& path);
+
+}
@@ -0,0 +1,484 @@
+#include "cgra_gen.h"
+
+#include <cstdarg>
+
+using namespace std;
+
+namespace vparser {
+
+  cgra_output::~cgra_output() {
+    if (!dir.empty() && (out != nullptr)) {
+      fclose(out);
+    }
+  }
+
+  bool cgra_output::begin_module(const std::string& name) {
+    if (dir.empty()) {
+      return true;
+    }
+
+    if (out != nullptr) {
+      failed = failed || ferror(out) || (fclose(out) != 0);
+    }
+
+    string path = dir + "/" + name + ".v";
+    out = fopen(path.c_str(), "w");
+    if (out == nullptr) {
+      failed = true;
+      return false;
+    }
+
+    paths.push_back(path);
+    return true;
+  }
+
+  void cgra_output::printf(const char* fmt, ...) {
+    if (out == nullptr) {
+      return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    int len = vfprintf(out, fmt, args);
+    va_end(args);
+
+    if (len > 0) {
+      bytes += len;
+    }
+  }
+
+  // splitmix64, so the output does not depend on the standard library's
+  // distributions
+  class cgra_random {
+    uint64_t state;
+
+  public:
+
+    cgra_random(const uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+      uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+
+    // In [lo, hi]
+    int range(const int lo, const int hi) {
+      return lo + (int) (next() % (uint64_t) (hi - lo + 1));
+    }
+  };
+
+  static const int data_width = 16;
+  static const int num_sides = 4;
+
+  // Operators the tokenizer supports
+  static const char* alu_ops[] = {"+", "-", "&", "|", "<<", ">>"};
+  static const int num_alu_ops = sizeof(alu_ops) / sizeof(alu_ops[0]);
+
+  int select_bits(const int n) {
+    int bits = 1;
+    while ((1 << bits) < n) {
+      bits++;
+    }
+    return bits;
+  }
+
+  class cgra_generator {
+    const cgra_options& options;
+    cgra_output& out;
+    cgra_random rng;
+
+    // Block modules waiting to be instantiated, by hierarchy level
+    vector<vector<string> > pending;
+    int num_arrays;
+
+    void header(const string& name) {
+      out.printf("//\n"
+                 "// %s, generated by vparser-gen with seed %llu\n"
+                 "//\n\n",
+                 name.c_str(),
+                 (unsigned long long) options.seed);
+    }
+
+    void config_ports() {
+      out.printf("config_addr,\n"
+                 "config_data,\n"
+                 "config_en\n"
+                 ");\n\n"
+                 "  input  clk;\n"
+                 "  input  reset;\n"
+                 "  input  config_en;\n"
+                 "  input [31:0] config_data;\n\n"
+                 "  /* verilator lint_off UNUSED */\n"
+                 "  input [31:0] config_addr;\n"
+                 "  /* verilator lint_on UNUSED */\n\n");
+    }
+
+    // A config register loaded from config_data, one 32 bit word per
+    // address
+    void config_register(const string& name, const int words) {
+      out.printf("  reg [%d:0] %s;\n\n", 32*words - 1, name.c_str());
+      out.printf("  always @(posedge clk) begin\n"
+                 "    if (reset==1'b1) begin\n"
+                 "      %s <= %d'd0;\n"
+                 "    end else begin\n"
+                 "      if (config_en==1'b1) begin\n"
+                 "         case (config_addr[31:24])\n",
+                 name.c_str(), 32*words);
+      for (int w = 0; w < words; w++) {
+        out.printf("           8'd%d: %s[%d:%d] <= config_data;\n",
+                   w, name.c_str(), 32*w + 31, 32*w);
+      }
+      out.printf("           default: ;\n"
+                 "         endcase\n"
+                 "      end\n"
+                 "    end\n"
+                 "  end\n\n");
+    }
+
+    // Modules with the block interface: 4 data inputs and outputs
+    void block_ports(const string& name) {
+      out.printf("module %s (\nclk, reset,\n", name.c_str());
+      for (int s = 0; s < num_sides; s++) {
+        out.printf("in_%d,\nout_%d,\n", s, s);
+      }
+      config_ports();
+      for (int s = 0; s < num_sides; s++) {
+        out.printf("  input [%d:0] in_%d;\n", data_width - 1, s);
+        out.printf("  output [%d:0] out_%d;\n", data_width - 1, s);
+      }
+      out.printf("\n");
+    }
+
+    void instance_start(const string& module_type, const string& name) {
+      out.printf("    %s  %s \n"
+                 "    (\n"
+                 "      .clk(clk),\n"
+                 "      .reset(reset),\n"
+                 "      .config_addr(config_addr),\n"
+                 "      .config_data(config_data),\n"
+                 "      .config_en(config_en)",
+                 module_type.c_str(), name.c_str());
+    }
+
+    void port(const string& formal, const string& actual) {
+      out.printf(",\n      .%s(%s)", formal.c_str(), actual.c_str());
+    }
+
+    void instance_end() {
+      out.printf("\n    );\n\n");
+    }
+
+    string cb(const int id, const int num_inputs) {
+      string name = "cb_unq" + to_string(id);
+      out.begin_module(name);
+      header(name);
+
+      out.printf("module %s (\nclk, reset,\n", name.c_str());
+      for (int i = 0; i < num_inputs; i++) {
+        out.printf("in_%d,\n", i);
+      }
+      out.printf("out,\n");
+      config_ports();
+      out.printf("  output reg [%d:0] out;\n", data_width - 1);
+      for (int i = 0; i < num_inputs; i++) {
+        out.printf("  input [%d:0] in_%d;\n", data_width - 1, i);
+      }
+      out.printf("\n");
+
+      config_register("config_cb", 1);
+
+      int bits = select_bits(num_inputs);
+      out.printf("  always @(*) begin\n"
+                 "    case (config_cb[%d:0])\n", bits - 1);
+      for (int i = 0; i < num_inputs; i++) {
+        out.printf("        %d'd%d: out = in_%d;\n", bits, i, i);
+      }
+      out.printf("        default: out = config_cb[%d:%d];\n"
+                 "    endcase\n"
+                 "  end\n"
+                 "endmodule\n\n",
+                 bits + data_width - 1, bits);
+      return name;
+    }
+
+    string sb(const int id, const int tracks) {
+      string name = "sb_unq" + to_string(id);
+      out.begin_module(name);
+      header(name);
+
+      out.printf("module %s (\nclk, reset,\npe_output_0,\n", name.c_str());
+      for (int s = 0; s < num_sides; s++) {
+        for (int t = 0; t < tracks; t++) {
+          out.printf("out_%d_%d,\nin_%d_%d,\n", s, t, s, t);
+        }
+      }
+      config_ports();
+      out.printf("  input [%d:0] pe_output_0;\n\n", data_width - 1);
+      for (int s = 0; s < num_sides; s++) {
+        for (int t = 0; t < tracks; t++) {
+          out.printf("  output [%d:0] out_%d_%d;\n", data_width - 1, s, t);
+          out.printf("  input [%d:0] in_%d_%d;\n", data_width - 1, s, t);
+        }
+      }
+      out.printf("\n");
+
+      config_register("config_sb", 2);
+
+      // Two select bits per output, then one delay bit per output
+      int num_outputs = num_sides*tracks;
+      for (int s = 0; s < num_sides; s++) {
+        for (int t = 0; t < tracks; t++) {
+          int k = s*tracks + t;
+          out.printf("  reg [%d:0] out_%d_%d_i;\n"
+                     "  always @(*) begin\n"
+                     "    case (config_sb[%d:%d])\n",
+                     data_width - 1, s, t, 2*k + 1, 2*k);
+          for (int j = 1; j < num_sides; j++) {
+            out.printf("        2'd%d: out_%d_%d_i = in_%d_%d;\n",
+                       j - 1, s, t, (s + j) % num_sides, t);
+          }
+          out.printf("        2'd3: out_%d_%d_i = pe_output_0;\n"
+                     "    endcase\n"
+                     "  end\n"
+                     "  reg [%d:0] out_%d_%d_id1;\n"
+                     "  always @(posedge clk) begin\n"
+                     "    out_%d_%d_id1 <= out_%d_%d_i;\n"
+                     "  end\n"
+                     "  assign out_%d_%d = config_sb[%d]?out_%d_%d_id1:out_%d_%d_i; \n",
+                     s, t,
+                     data_width - 1, s, t,
+                     s, t, s, t,
+                     s, t, 2*num_outputs + k, s, t, s, t);
+        }
+      }
+      out.printf("endmodule\n\n");
+      return name;
+    }
+
+    string stress(const int id) {
+      string name = "stress_unq" + to_string(id);
+      out.begin_module(name);
+      header(name);
+
+      out.printf("module %s (\n", name.c_str());
+      for (int s = 0; s < num_sides; s++) {
+        out.printf("in_%d,\n", s);
+      }
+      out.printf("out\n);\n\n");
+      for (int s = 0; s < num_sides; s++) {
+        out.printf("  input [%d:0] in_%d;\n", data_width - 1, s);
+      }
+      out.printf("  output [%d:0] out;\n\n", data_width - 1);
+
+      string result = "16'd0";
+
+      if (options.long_expression > 0) {
+        out.printf("  wire [%d:0] out_long;\n"
+                   "  assign out_long = in_0", data_width - 1);
+        for (int i = 1; i < options.long_expression; i++) {
+          out.printf(" %s in_%d[%d:0]",
+                     alu_ops[rng.range(0, 3)],
+                     rng.range(0, num_sides - 1),
+                     rng.range(0, data_width - 1));
+        }
+        out.printf(";\n\n");
+        result += " | out_long";
+      }
+
+      if (options.if_chain > 0) {
+        out.printf("  reg [%d:0] out_if;\n"
+                   "  always @(*) begin\n"
+                   "    if (in_3 == 16'd0)\n"
+                   "      out_if = in_0;\n",
+                   data_width - 1);
+        for (int i = 1; i < options.if_chain; i++) {
+          out.printf("    else if (in_3 == 16'd%d)\n"
+                     "      out_if = in_%d + 16'd%d;\n",
+                     i, rng.range(0, num_sides - 1), i);
+        }
+        out.printf("    else\n"
+                   "      out_if = 16'd0;\n"
+                   "  end\n\n");
+        result += " | out_if";
+      }
+
+      if (options.concat > 0) {
+        out.printf("  wire [%d:0] out_cat;\n"
+                   "  assign out_cat = { in_0[0]", options.concat - 1);
+        for (int i = 1; i < options.concat; i++) {
+          out.printf(", in_%d[%d]",
+                     rng.range(0, num_sides - 1),
+                     rng.range(0, data_width - 1));
+        }
+        out.printf(" };\n\n");
+        result += " | out_cat[0]";
+      }
+
+      out.printf("  assign out = %s;\n"
+                 "endmodule\n\n",
+                 result.c_str());
+      return name;
+    }
+
+    bool stress_enabled() const {
+      return (options.long_expression > 0) ||
+        (options.if_chain > 0) ||
+        (options.concat > 0);
+    }
+
+    string pe_tile(const int id) {
+      int tracks = rng.range(2, 5);
+      int cb_inputs = rng.range(4, 2*tracks + 2);
+      int num_ops = rng.range(4, 12);
+
+      string cb_name = cb(id, cb_inputs);
+      string sb_name = sb(id, tracks);
+      string stress_name = stress_enabled() ? stress(id) : "";
+
+      string name = "pe_tile_new_unq" + to_string(id);
+      out.begin_module(name);
+      header(name);
+      block_ports(name);
+
+      for (int s = 0; s < num_sides; s++) {
+        for (int t = 0; t < tracks; t++) {
+          out.printf("  wire [%d:0] sb_out_%d_%d;\n", data_width - 1, s, t);
+        }
+      }
+      out.printf("  wire [%d:0] cb_a_out;\n"
+                 "  wire [%d:0] cb_b_out;\n"
+                 "  wire [%d:0] stress_out;\n"
+                 "  wire [%d:0] pe_res;\n\n",
+                 data_width - 1, data_width - 1, data_width - 1, data_width - 1);
+
+      config_register("config_pe", 1);
+
+      instance_start(sb_name, "sb_wide");
+      port("pe_output_0", "pe_res");
+      for (int s = 0; s < num_sides; s++) {
+        for (int t = 0; t < tracks; t++) {
+          string out_wire = "sb_out_" + to_string(s) + "_" + to_string(t);
+          string in_wire = t == 0 ? "in_" + to_string(s) :
+            "sb_out_" + to_string((s + 2) % num_sides) + "_" + to_string(t);
+          port("out_" + to_string(s) + "_" + to_string(t), out_wire);
+          port("in_" + to_string(s) + "_" + to_string(t), in_wire);
+        }
+      }
+      instance_end();
+
+      const char* cbs[] = {"cb_a", "cb_b"};
+      for (int c = 0; c < 2; c++) {
+        instance_start(cb_name, cbs[c]);
+        port("out", string(cbs[c]) + "_out");
+        for (int i = 0; i < cb_inputs; i++) {
+          port("in_" + to_string(i),
+               "sb_out_" + to_string((i + c) % num_sides) + "_" + to_string(i % tracks));
+        }
+        instance_end();
+      }
+
+      if (stress_enabled()) {
+        out.printf("    %s  stress \n    (\n      .out(stress_out)", stress_name.c_str());
+        for (int s = 0; s < num_sides; s++) {
+          port("in_" + to_string(s), "in_" + to_string(s));
+        }
+        instance_end();
+      } else {
+        out.printf("  assign stress_out = 16'd0;\n\n");
+      }
+
+      // The ALU: a wide mux over the configured operation
+      out.printf("  assign pe_res = ");
+      for (int i = 0; i < num_ops; i++) {
+        out.printf("(config_pe[3:0] == 4'd%d) ? (cb_a_out %s cb_b_out) :\n                  ",
+                   i, alu_ops[rng.range(0, num_alu_ops - 1)]);
+      }
+      out.printf("stress_out;\n\n");
+
+      for (int s = 0; s < num_sides; s++) {
+        out.printf("  assign out_%d = sb_out_%d_0;\n", s, s);
+      }
+      out.printf("endmodule\n\n");
+      return name;
+    }
+
+    // A block that chains four child blocks
+    string block_array(const vector<string>& children, const string& name) {
+      out.begin_module(name);
+      header(name);
+      block_ports(name);
+
+      for (unsigned c = 0; c < children.size(); c++) {
+        for (int s = 0; s < num_sides; s++) {
+          out.printf("  wire [%d:0] c%u_out_%d;\n", data_width - 1, c, s);
+        }
+      }
+      out.printf("\n");
+
+      for (unsigned c = 0; c < children.size(); c++) {
+        instance_start(children[c], "c" + to_string(c));
+        for (int s = 0; s < num_sides; s++) {
+          port("in_" + to_string(s),
+               c == 0 ? "in_" + to_string(s) :
+               "c" + to_string(c - 1) + "_out_" + to_string(s));
+          port("out_" + to_string(s), "c" + to_string(c) + "_out_" + to_string(s));
+        }
+        instance_end();
+      }
+
+      for (int s = 0; s < num_sides; s++) {
+        out.printf("  assign out_%d = c%u_out_%d;\n", s, (unsigned) children.size() - 1, s);
+      }
+      out.printf("endmodule\n\n");
+      return name;
+    }
+
+    // Groups every four blocks at a level into an array at the next
+    void add_block(const string& name, const unsigned level) {
+      if (pending.size() <= level) {
+        pending.resize(level + 1);
+      }
+
+      pending[level].push_back(name);
+      if (pending[level].size() == 4) {
+        vector<string> children;
+        children.swap(pending[level]);
+
+        string array_name =
+          "array_l" + to_string(level + 1) + "_" + to_string(num_arrays++);
+        add_block(block_array(children, array_name), level + 1);
+      }
+    }
+
+  public:
+
+    cgra_generator(const cgra_options& options_, cgra_output& out_) :
+      options(options_), out(out_), rng(options_.seed), num_arrays(0) {}
+
+    void generate() {
+      int id = 1;
+      do {
+        add_block(pe_tile(id), 0);
+        id++;
+      } while (out.good() && (out.bytes_written() < options.target_bytes));
+
+      // Whatever is left, highest level first
+      vector<string> top_children;
+      for (int level = pending.size() - 1; level >= 0; level--) {
+        for (auto& name : pending[level]) {
+          top_children.push_back(name);
+        }
+      }
+      block_array(top_children, "top");
+    }
+  };
+
+  bool generate_cgra(const cgra_options& options, cgra_output& out) {
+    cgra_generator gen(options, out);
+    gen.generate();
+    return out.good();
+  }
+
+}
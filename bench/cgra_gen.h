@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace vparser {
+
+  // Settings for generate_cgra. The same settings always produce the
+  // same text.
+  class cgra_options {
+  public:
+    uint64_t seed;
+
+    // Generation stops adding tiles once this much has been written,
+    // the closing hierarchy adds a little more
+    uint64_t target_bytes;
+
+    // Pathological shapes, each off when 0. Every tile gets a stress
+    // module with:
+    //   long_expression: an assign whose right hand side chains this
+    //   many operands
+    //   if_chain: an if / else if chain this deep
+    //   concat: a concatenation of this many signals
+    int long_expression;
+    int if_chain;
+    int concat;
+
+    cgra_options() :
+      seed(1), target_bytes(1 << 20), long_expression(0), if_chain(0), concat(0) {}
+  };
+
+  // Where generated modules go: a single stream, or one file per module
+  class cgra_output {
+    FILE* out;
+    std::string dir;
+    uint64_t bytes;
+    bool failed;
+    std::vector<std::string> paths;
+
+  public:
+
+    // Writes everything to out, which stays open
+    cgra_output(FILE* out_) : out(out_), bytes(0), failed(false) {}
+
+    // Writes each module to dir/<module name>.v
+    cgra_output(const std::string& dir_) :
+      out(nullptr), dir(dir_), bytes(0), failed(false) {}
+
+    ~cgra_output();
+
+    cgra_output(const cgra_output&) = delete;
+    cgra_output& operator=(const cgra_output&) = delete;
+
+    bool begin_module(const std::string& name);
+
+    void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    uint64_t bytes_written() const { return bytes; }
+
+    // False once a file could not be opened or written
+    bool good() const { return !failed && ((out == nullptr) || !ferror(out)); }
+
+    // Files written in the one file per module mode
+    const std::vector<std::string>& get_paths() const { return paths; }
+  };
+
+  // Emits Verilog shaped like the CGRA samples: cb, sb and pe_tile
+  // modules, wide assign muxes, posedge config registers, and array
+  // modules that instantiate four blocks each, nested until one top
+  // module is left. Every module parses with parse_module. False if the
+  // output could not be written.
+  bool generate_cgra(const cgra_options& options, cgra_output& out);
+
+}
@@ -0,0 +1,101 @@
+#include "cgra_gen.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <sys/stat.h>
+
+using namespace std;
+using namespace vparser;
+
+static void usage() {
+  printf("usage: vparser-gen [options]\n"
+         "  --seed N              random seed, default 1\n"
+         "  --size BYTES          approximate output size, K, M and G suffixes allowed\n"
+         "  --out FILE            write all modules to FILE instead of stdout\n"
+         "  --out-dir DIR         write each module to DIR/<module>.v\n"
+         "  --long-expression N   add an assign chaining N operands to every tile\n"
+         "  --if-chain N          add an if / else if chain N deep to every tile\n"
+         "  --concat N            add an N signal concatenation to every tile\n");
+}
+
+static bool parse_size(const string& str, uint64_t& bytes) {
+  char* end = nullptr;
+  double val = strtod(str.c_str(), &end);
+  string suffix = end;
+
+  double scale = 1;
+  if ((suffix == "K") || (suffix == "k")) {
+    scale = 1024.0;
+  } else if ((suffix == "M") || (suffix == "m")) {
+    scale = 1024.0*1024.0;
+  } else if ((suffix == "G") || (suffix == "g")) {
+    scale = 1024.0*1024.0*1024.0;
+  } else if (!suffix.empty()) {
+    return false;
+  }
+
+  bytes = (uint64_t) (val*scale);
+  return val > 0;
+}
+
+int main(int argc, char** argv) {
+  cgra_options options;
+  string out_path, out_dir;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (i + 1 >= argc) {
+      usage();
+      return 2;
+    }
+    string val = argv[++i];
+
+    if (arg == "--seed") {
+      options.seed = strtoull(val.c_str(), nullptr, 10);
+    } else if (arg == "--size") {
+      if (!parse_size(val, options.target_bytes)) {
+        usage();
+        return 2;
+      }
+    } else if (arg == "--out") {
+      out_path = val;
+    } else if (arg == "--out-dir") {
+      out_dir = val;
+    } else if (arg == "--long-expression") {
+      options.long_expression = atoi(val.c_str());
+    } else if (arg == "--if-chain") {
+      options.if_chain = atoi(val.c_str());
+    } else if (arg == "--concat") {
+      options.concat = atoi(val.c_str());
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  bool ok = false;
+  if (!out_dir.empty()) {
+    mkdir(out_dir.c_str(), 0777);
+    cgra_output out(out_dir);
+    ok = generate_cgra(options, out);
+  } else if (!out_path.empty()) {
+    FILE* f = fopen(out_path.c_str(), "w");
+    if (f != nullptr) {
+      cgra_output out(f);
+      ok = generate_cgra(options, out);
+      ok = (fclose(f) == 0) && ok;
+    }
+  } else {
+    cgra_output out(stdout);
+    ok = generate_cgra(options, out);
+  }
+
+  if (!ok) {
+    fprintf(stderr, "Could not write the generated Verilog\n");
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,68 @@
+#include "benchmarks.h"
+
+#include "driver.h"
+
+#include <thread>
+
+using namespace std;
+
+namespace vparser {
+
+  static vector<string> bench_paths(const std::vector<bench_file>& files) {
+    vector<string> paths;
+    for (auto& file : files) {
+      paths.push_back(file.path);
+    }
+    return paths;
+  }
+
+  void run_driver_benchmarks(bench_suite& suite,
+                             const std::vector<bench_file>& files) {
+    bench_work total;
+    for (auto& file : files) {
+      total.bytes += file.text.size();
+      total.tokens += file.tokens.size();
+      total.nodes += file.nodes;
+    }
+
+    vector<string> paths = bench_paths(files);
+    int max_threads = max(1u, std::thread::hardware_concurrency());
+
+    vector<int> thread_counts{1};
+    if (max_threads > 1) {
+      thread_counts.push_back(max_threads);
+    }
+
+    for (int num_threads : thread_counts) {
+      string threads =
+        std::to_string(num_threads) + (num_threads == 1 ? "_thread" : "_threads");
+
+      suite.run("parse_files/" + threads, total, [&paths, num_threads]() {
+          driver_options options;
+          options.num_threads = num_threads;
+          parse_files(paths, options);
+        });
+
+      // Compare with parse_files to see the cost of tracing
+      suite.run("parse_files_traced/" + threads, total, [&paths, num_threads]() {
+          trace_recorder trace;
+          driver_options options;
+          options.num_threads = num_threads;
+          options.trace = &trace;
+          parse_files(paths, options);
+        });
+    }
+  }
+
+  bool write_driver_trace(const std::vector<bench_file>& files,
+                          const int num_threads,
+                          const std::string& path) {
+    trace_recorder trace;
+    driver_options options;
+    options.num_threads = num_threads;
+    options.trace = &trace;
+    parse_files(bench_paths(files), options);
+    return trace.write(path);
+  }
+
+}
@@ -0,0 +1,85 @@
+#include "heap_counters.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include <sys/resource.h>
+
+// Every heap allocation in a binary linking this file goes through here
+static std::atomic<uint64_t> num_allocations(0);
+static std::atomic<uint64_t> num_allocated_bytes(0);
+static std::atomic<uint64_t> num_live_bytes(0);
+static std::atomic<uint64_t> num_peak_live_bytes(0);
+
+// Each block starts with the size asked for, so operator delete knows
+// what it frees on any libc. A max_align_t keeps the rest aligned.
+static const size_t header_bytes = alignof(std::max_align_t);
+
+void* operator new(std::size_t size) {
+  void* block = std::malloc(header_bytes + size);
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  *static_cast<size_t*>(block) = size;
+
+  num_allocations++;
+  num_allocated_bytes += size;
+
+  uint64_t live = num_live_bytes += size;
+  uint64_t peak = num_peak_live_bytes;
+  while ((live > peak) &&
+         !num_peak_live_bytes.compare_exchange_weak(peak, live)) {}
+
+  return static_cast<char*>(block) + header_bytes;
+}
+
+void operator delete(void* p) noexcept {
+  if (p == nullptr) {
+    return;
+  }
+  void* block = static_cast<char*>(p) - header_bytes;
+  num_live_bytes -= *static_cast<size_t*>(block);
+  std::free(block);
+}
+
+// The library's own versions of these may not go through the two
+// above, and must not see blocks without a header
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete[](void* p) noexcept { operator delete(p); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return operator new(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept { operator delete(p); }
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept { operator delete(p); }
+
+namespace vparser {
+
+  heap_counters get_heap_counters() {
+    return {num_allocations, num_allocated_bytes, num_live_bytes, num_peak_live_bytes};
+  }
+
+  void reset_heap_peak() {
+    num_peak_live_bytes = num_live_bytes.load();
+  }
+
+  uint64_t peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+  }
+
+}
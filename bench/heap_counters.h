@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+namespace vparser {
+
+  // Heap statistics from the counting operator new in heap_counters.cpp.
+  // Linking that file into a binary replaces its global operator new and
+  // delete, the benchmarks and the allocation tests both do.
+  class heap_counters {
+  public:
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+    uint64_t live_bytes;
+    uint64_t peak_live_bytes;
+  };
+
+  heap_counters get_heap_counters();
+
+  // Restarts peak_live_bytes from the current live bytes
+  void reset_heap_peak();
+
+  // Peak resident set size of the process so far
+  uint64_t peak_rss_kb();
+
+}
@@ -0,0 +1,277 @@
+#include "benchmarks.h"
+
+#include "macro_def.h"
+#include "parse.h"
+#include "printer.h"
+#include "tokenize.h"
+#include "visitor.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+using namespace std;
+
+namespace vparser {
+
+  class node_counter : public ast_visitor<node_counter> {
+  public:
+    uint64_t nodes;
+
+    node_counter() : nodes(0) {}
+
+    visit_result pre_expression(const expression*) {
+      nodes++;
+      return VISIT_CONTINUE;
+    }
+
+    visit_result pre_statement(const statement*) {
+      nodes++;
+      return VISIT_CONTINUE;
+    }
+  };
+
+  template<typename T>
+  uint64_t count_nodes(const T& node) {
+    node_counter counter;
+    counter.walk(node);
+    return counter.nodes;
+  }
+
+  // Frees a parsed tree, which no node's destructor does. `a[i]` shares
+  // i as both ends of its slice, so nodes are collected and each is
+  // deleted once. The vectors keep their capacity between trees.
+  class ast_deleter : public ast_visitor<ast_deleter> {
+    vector<const expression*> exprs;
+    vector<const statement*> stmts;
+
+  public:
+
+    visit_result post_expression(const expression* e) {
+      exprs.push_back(e);
+      return VISIT_CONTINUE;
+    }
+
+    visit_result post_statement(const statement* s) {
+      stmts.push_back(s);
+      return VISIT_CONTINUE;
+    }
+
+    template<typename T>
+    void free_tree(const T* root) {
+      walk(root);
+
+      sort(begin(exprs), end(exprs));
+      exprs.erase(unique(begin(exprs), end(exprs)), end(exprs));
+      for (auto e : exprs) {
+        delete e;
+      }
+      for (auto s : stmts) {
+        delete s;
+      }
+
+      exprs.clear();
+      stmts.clear();
+    }
+  };
+
+  bool load_bench_file(const std::string& path, bench_file& file) {
+    ifstream in(path);
+    if (!in) {
+      return false;
+    }
+
+    stringstream ss;
+    ss << in.rdbuf();
+
+    file.name = path.substr(path.rfind('/') + 1);
+    file.path = path;
+    file.text = ss.str();
+    file.preprocessed = preprocess_code(file.text).text;
+    file.tokens = tokenize(file.preprocessed);
+
+    diagnostic_engine diags;
+    verilog_module vm = parse_module(file.preprocessed, diags);
+    file.nodes = count_nodes(vm);
+    file.printed_bytes = vm.to_string().size();
+    return !diags.has_errors();
+  }
+
+  // Runs f over the whole corpus as one benchmark and, with per_file,
+  // over each file on its own
+  template<typename W, typename F>
+  void run_phase(bench_suite& suite,
+                 const std::string& phase,
+                 const std::vector<bench_file>& files,
+                 W work_for,
+                 F f) {
+    bench_work total;
+    for (auto& file : files) {
+      bench_work w = work_for(file);
+      total.bytes += w.bytes;
+      total.tokens += w.tokens;
+      total.nodes += w.nodes;
+    }
+
+    suite.run(phase + "/corpus", total, [&files, &f]() {
+        for (auto& file : files) {
+          f(file);
+        }
+      });
+
+    if (suite.get_options().per_file) {
+      for (auto& file : files) {
+        suite.run(phase + "/" + file.name, work_for(file), [&file, &f]() {
+            f(file);
+          });
+      }
+    }
+  }
+
+  bench_work text_work(const bench_file& file) {
+    return bench_work(file.text.size(), file.tokens.size(), 0);
+  }
+
+  bench_work lex_work(const bench_file& file) {
+    return bench_work(file.preprocessed.size(), file.tokens.size(), 0);
+  }
+
+  bench_work parse_work(const bench_file& file) {
+    return bench_work(file.preprocessed.size(), file.tokens.size(), file.nodes);
+  }
+
+  bench_work pipeline_work(const bench_file& file) {
+    return bench_work(file.text.size(), file.tokens.size(), file.nodes);
+  }
+
+  bench_work print_work(const bench_file& file) {
+    return bench_work(file.printed_bytes, 0, file.nodes);
+  }
+
+  // Statements and right hand sides printed from the corpus, kept only
+  // if they parse back on their own
+  class snippet_corpus {
+  public:
+    vector<string> snippets;
+    bench_work work;
+  };
+
+  template<typename P>
+  void add_snippet(snippet_corpus& corpus, const std::string& text, P parse) {
+    diagnostic_engine diags;
+    auto parsed = parse(text, diags);
+    if (diags.has_errors() || (parsed == nullptr)) {
+      return;
+    }
+
+    corpus.snippets.push_back(text);
+    corpus.work.bytes += text.size();
+    corpus.work.tokens += tokenize(text).size();
+    corpus.work.nodes += count_nodes(parsed);
+  }
+
+  void collect_snippets(const std::vector<bench_file>& files,
+                        snippet_corpus& stmts,
+                        snippet_corpus& exprs) {
+    for (auto& file : files) {
+      verilog_module vm = parse_module(file.preprocessed);
+      for (auto stmt : vm.get_statements()) {
+        if ((stmt->get_type() != STATEMENT_ASSIGN) &&
+            (stmt->get_type() != STATEMENT_MODULE_INSTANTIATION)) {
+          continue;
+        }
+
+        add_snippet(stmts, stmt->to_string(0),
+                    [](const string& text, diagnostic_engine& diags) {
+                      return parse_statement(text, diags);
+                    });
+
+        if (stmt->get_type() == STATEMENT_ASSIGN) {
+          auto rhs = static_cast<const assign_stmt*>(stmt)->get_rhs();
+          add_snippet(exprs, rhs->to_string(),
+                      [](const string& text, diagnostic_engine& diags) {
+                        return parse_expression(text, diags);
+                      });
+        }
+      }
+    }
+  }
+
+  void run_parse_benchmarks(bench_suite& suite,
+                            const std::vector<bench_file>& files) {
+    run_phase(suite, "preprocess", files, text_work,
+              [](const bench_file& file) {
+                preprocess_code(file.text);
+              });
+
+    run_phase(suite, "tokenize", files, lex_work,
+              [](const bench_file& file) {
+                tokenize(file.preprocessed);
+              });
+
+    run_phase(suite, "parse_module", files, parse_work,
+              [](const bench_file& file) {
+                token_stream ts(file.tokens);
+                parse_module(ts);
+              });
+
+    // The same parse recording parse_stats, the difference is the cost
+    // of leaving stats on
+    run_phase(suite, "parse_module_stats", files, parse_work,
+              [](const bench_file& file) {
+                parse_stats stats;
+                token_stream ts(file.tokens);
+                ts.set_stats(&stats);
+                parse_module(ts);
+              });
+
+    run_phase(suite, "parse_module_text", files, pipeline_work,
+              [](const bench_file& file) {
+                parse_module(preprocess_code(file.text).text);
+              });
+
+    snippet_corpus stmts, exprs;
+    if (suite.selected("parse_statement") || suite.selected("parse_expression")) {
+      collect_snippets(files, stmts, exprs);
+    }
+
+    ast_deleter deleter;
+    suite.run("parse_statement/corpus", stmts.work, [&stmts, &deleter]() {
+        for (auto& text : stmts.snippets) {
+          deleter.free_tree(parse_statement(text));
+        }
+      });
+
+    suite.run("parse_expression/corpus", exprs.work, [&exprs, &deleter]() {
+        for (auto& text : exprs.snippets) {
+          deleter.free_tree(parse_expression(text));
+        }
+      });
+
+    if (!suite.selected("to_string") && !suite.selected("print")) {
+      return;
+    }
+
+    // Modules are move only, so they are kept by pointer to look them
+    // up by file
+    map<string, unique_ptr<verilog_module> > modules;
+    for (auto& file : files) {
+      modules[file.name].reset(new verilog_module(parse_module(file.preprocessed)));
+    }
+
+    run_phase(suite, "to_string", files, print_work,
+              [&modules](const bench_file& file) {
+                modules[file.name]->to_string();
+              });
+
+    output_buffer out;
+    ast_printer printer(out);
+    run_phase(suite, "print", files, print_work,
+              [&modules, &out, &printer](const bench_file& file) {
+                out.clear();
+                printer.print(*modules[file.name]);
+              });
+  }
+
+}
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Builds vparser with LTO, then with LTO and two-stage PGO, and has
+# vparser-bench report the PGO build's speedup over the LTO one.
+#
+#   bench/pgo_build.sh [BUILD_DIR]
+#
+# BUILD_DIR defaults to ./build-pgo. The LTO build goes in BUILD_DIR/lto
+# and the PGO build in BUILD_DIR/pgo, whose vparser-bench is the one to
+# ship. Run from the repository root.
+
+set -e
+
+BUILD_DIR=${1:-./build-pgo}
+JOBS=$(nproc 2>/dev/null || echo 4)
+
+LTO_DIR=$BUILD_DIR/lto
+PGO_DIR=$BUILD_DIR/pgo
+
+echo "== LTO build"
+cmake -S . -B "$LTO_DIR" -DCMAKE_BUILD_TYPE=Release -DVPARSER_LTO=ON
+cmake --build "$LTO_DIR" -j"$JOBS"
+
+echo "== PGO stage 1: instrumented build and training run"
+rm -rf "$PGO_DIR/pgo-profile"
+cmake -S . -B "$PGO_DIR" -DCMAKE_BUILD_TYPE=Release -DVPARSER_LTO=ON -DVPARSER_PGO=GENERATE
+cmake --build "$PGO_DIR" -j"$JOBS"
+cmake --build "$PGO_DIR" --target pgo-train
+
+echo "== PGO stage 2: rebuild with the profile"
+cmake -S . -B "$PGO_DIR" -DVPARSER_PGO=USE
+cmake --build "$PGO_DIR" -j"$JOBS"
+
+echo "== Speedup of PGO over LTO alone"
+"$LTO_DIR/vparser-bench" --json "$BUILD_DIR/lto.json"
+# Slower rows are only reported here, not treated as a failure
+"$PGO_DIR/vparser-bench" --json "$BUILD_DIR/pgo.json" \
+                         --baseline "$BUILD_DIR/lto.json" --threshold 1000
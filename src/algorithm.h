@@ -17,14 +17,16 @@
 #include <utility>
 #include <vector>
 
+#include "range.h"
+
 #define DBG_ASSERT(x) assert(x)
 
 namespace afk {
 
   template<typename T>
-  int num_elems(std::vector<std::vector<T>>& v) {
+  int num_elems(const std::vector<std::vector<T>>& v) {
     int i = 0;
-    for (auto t : v) {
+    for (auto& t : v) {
       i += t.size();
     }
     return i;
@@ -43,27 +45,27 @@ namespace afk {
   }
 
   template<typename E, typename T>
-  void remove(E e, T& t) {
+  void remove(const E& e, T& t) {
     t.erase(std::remove(begin(t), end(t), e), end(t));
   }
 
   template<typename E, typename T>
-  bool elem(E e, std::vector<T> t) {
+  bool elem(const E& e, const std::vector<T>& t) {
     return std::find(begin(t), end(t), e) != end(t);
   }
 
   template<typename T>
-  bool elem(T e, const std::unordered_set<T>& t) {
+  bool elem(const T& e, const std::unordered_set<T>& t) {
     return t.find(e) != end(t);
   }
 
   template<typename T>
-  bool elem(T e, const std::deque<T>& t) {
+  bool elem(const T& e, const std::deque<T>& t) {
     return std::find(begin(t), end(t), e) != end(t);
   }
   
   template<typename T>
-  bool elem(T e, const std::set<T>& t) {
+  bool elem(const T& e, const std::set<T>& t) {
     return t.find(e) != end(t);
   }
   
@@ -174,6 +176,21 @@ namespace afk {
 	      { return std::find(begin(b), end(b), i) != end(b); });
   }
 
+  // Index lists, as in dfs_by, can be searched in log time once sorted
+  inline void subtract(std::vector<unsigned>& a,
+		       const std::vector<unsigned>& b) {
+    if (b.size() < 16) {
+      delete_if(a, [&b](const unsigned i)
+		{ return std::find(begin(b), end(b), i) != end(b); });
+      return;
+    }
+
+    std::vector<unsigned> sorted_b = b;
+    std::sort(begin(sorted_b), end(sorted_b));
+    delete_if(a, [&sorted_b](const unsigned i)
+	      { return std::binary_search(begin(sorted_b), end(sorted_b), i); });
+  }
+
   template<typename T, typename Q>
   std::pair<T, Q>
   mk_pair(T t, Q q) { return std::pair<T, Q>(t, q); }
@@ -209,13 +226,7 @@ namespace afk {
 
   template<typename T, typename F>
   std::vector<T> select(const std::vector<T>& v, F f) {
-    std::vector<T> selected;
-    for (auto e : v) {
-      if (f(e)) {
-	selected.push_back(e);
-      }
-    }
-    return selected;
+    return view::to_vector(view::filter(v, f));
   }
 
   template<typename I, typename P>
@@ -278,27 +289,141 @@ namespace afk {
     return dfs_by_neighbors(inds, elems, neighbors);
   }
 
+  // Disjoint sets of the indexes [0, n), with union by size and path
+  // halving, so any sequence of operations is near linear
+  class union_find {
+    std::vector<unsigned> parent;
+    std::vector<unsigned> set_size;
+
+  public:
+
+    explicit union_find(const unsigned n) : parent(n), set_size(n, 1) {
+      std::iota(begin(parent), end(parent), 0);
+    }
+
+    unsigned size() const { return parent.size(); }
+
+    unsigned find(unsigned i) {
+      while (parent[i] != i) {
+	parent[i] = parent[parent[i]];
+	i = parent[i];
+      }
+      return i;
+    }
+
+    // False if i and j were already in one set
+    bool unite(const unsigned i, const unsigned j) {
+      unsigned a = find(i);
+      unsigned b = find(j);
+      if (a == b) { return false; }
+
+      if (set_size[a] < set_size[b]) { std::swap(a, b); }
+      parent[b] = a;
+      set_size[a] += set_size[b];
+      return true;
+    }
+
+    bool same_set(const unsigned i, const unsigned j) {
+      return find(i) == find(j);
+    }
+
+    // Each set in increasing order, sets ordered by their smallest index
+    std::vector<std::vector<unsigned>> sets() {
+      std::vector<std::vector<unsigned>> res;
+      std::vector<unsigned> set_index(parent.size(), parent.size());
+      for (unsigned i = 0; i < parent.size(); i++) {
+	unsigned root = find(i);
+	if (set_index[root] == parent.size()) {
+	  set_index[root] = res.size();
+	  res.push_back({});
+	  res.back().reserve(set_size[root]);
+	}
+	res[set_index[root]].push_back(i);
+      }
+      return res;
+    }
+  };
+
+  // Components of the symmetric relation p over elems, as indexes, in
+  // the order of union_find::sets. A depth first search that only calls
+  // p against elements not yet in a component, dropping each visited
+  // element's neighbors from them in the same pass. That is close to
+  // linear only for dense relations, where most elements are directly
+  // related to each other. Sparse ones take O(n^2) calls, whether the
+  // components are chains or unrelated elements; when the relation comes
+  // from shared keys (nets, instances) build an adjacency list and use
+  // connected_components. There is no parallel version: splitting the
+  // pairs between threads loses the skipping of elements already in a
+  // component, and measured slower than this on every shape.
   template<typename I, typename P>
   std::vector<std::vector<unsigned>>
   connected_components_by(const std::vector<I>& elems, P p) {
     std::vector<std::vector<unsigned>> components;
-    std::vector<unsigned> inds(elems.size());
-    std::iota(begin(inds), end(inds), 0);
+    std::vector<unsigned> unvisited(elems.size());
+    std::iota(begin(unvisited), end(unvisited), 0);
+
+    std::vector<unsigned> buf;
+    while (unvisited.size() > 0) {
+      std::vector<unsigned> comp;
+      buf.push_back(unvisited.front());
+      unvisited.erase(begin(unvisited));
+
+      while (buf.size() > 0) {
+	unsigned next = buf.back();
+	buf.pop_back();
+	comp.push_back(next);
+
+	unsigned kept = 0;
+	for (unsigned k = 0; k < unvisited.size(); k++) {
+	  unsigned u = unvisited[k];
+	  if (p(elems[u], elems[next])) {
+	    buf.push_back(u);
+	  } else {
+	    unvisited[kept++] = u;
+	  }
+	}
+	unvisited.resize(kept);
+      }
 
-    while (inds.size() > 0) {
-      components.push_back(dfs_by(inds, elems, p));
+      std::sort(begin(comp), end(comp));
+      components.push_back(comp);
     }
 
     return components;
   }
 
+  // Components of the graph whose node i has edges to adjacency[i], in
+  // time linear in nodes and edges. Edges need only be listed in one
+  // direction.
+  inline std::vector<std::vector<unsigned>>
+  connected_components(const std::vector<std::vector<unsigned>>& adjacency) {
+    union_find sets(adjacency.size());
+    for (unsigned i = 0; i < adjacency.size(); i++) {
+      for (auto j : adjacency[i]) {
+	sets.unite(i, j);
+      }
+    }
+    return sets.sets();
+  }
+
+  inline std::vector<std::vector<unsigned>>
+  connected_components(const unsigned num_nodes,
+		       const std::vector<std::pair<unsigned, unsigned>>& edges) {
+    union_find sets(num_nodes);
+    for (auto& e : edges) {
+      sets.unite(e.first, e.second);
+    }
+    return sets.sets();
+  }
+
   template<typename I, typename P>
   std::vector<std::vector<I>>
   connected_components_by_elems(const std::vector<I>& elems, P p) {
     auto ccs = connected_components_by(elems, p);
     std::vector<std::vector<I>> res;
-    for (auto cc : ccs) {
+    for (auto& cc : ccs) {
       std::vector<I> cc_elems;
+      cc_elems.reserve(cc.size());
       for (auto i : cc) {
 	cc_elems.push_back(elems[i]);
       }
@@ -329,32 +454,41 @@ namespace afk {
   }
 
 
+  // The elements of elems whose index is (or with keep false, is not)
+  // in inds, in their order in elems
+  template<typename I>
+  std::vector<I>
+  filter_indexes(const std::vector<I>& elems,
+		 const std::vector<unsigned>& inds,
+		 const bool keep) {
+    std::vector<unsigned> sorted;
+    const std::vector<unsigned>* search = &inds;
+    if (!std::is_sorted(begin(inds), end(inds))) {
+      sorted = inds;
+      std::sort(begin(sorted), end(sorted));
+      search = &sorted;
+    }
+
+    auto in_inds = [search, keep](const std::pair<std::size_t, const I&>& e) {
+      return std::binary_search(begin(*search), end(*search), e.first) == keep;
+    };
+    auto element = [](const std::pair<std::size_t, const I&>& e) { return e.second; };
+    return view::to_vector(view::map(view::filter(view::enumerate(elems), in_inds),
+				     element));
+  }
+
   template<typename I>
   std::vector<I>
   copy_not_indexes(const std::vector<I>& elems,
-		   std::vector<unsigned>& inds) {
-    std::sort(begin(inds), end(inds));
-    std::vector<I> cp_elems;
-    for (unsigned i = 0; i < elems.size(); i++) {
-      if (!(std::binary_search(begin(inds), end(inds), i))) {
-    	cp_elems.push_back(elems[i]);
-      }
-    }
-    return cp_elems;
+		   const std::vector<unsigned>& inds) {
+    return filter_indexes(elems, inds, false);
   }
 
   template<typename I>
   std::vector<I>
   select_indexes(const std::vector<I>& elems,
-		 std::vector<unsigned>& inds) {
-    std::sort(begin(inds), end(inds));
-    std::vector<I> cp_elems;
-    for (unsigned i = 0; i < elems.size(); i++) {
-      if (std::binary_search(begin(inds), end(inds), i)) {
-    	cp_elems.push_back(elems[i]);
-      }
-    }
-    return cp_elems;
+		 const std::vector<unsigned>& inds) {
+    return filter_indexes(elems, inds, true);
   }
 
   // Set Operations
@@ -383,13 +517,7 @@ namespace afk {
   template<typename A>
   std::vector<A>
   intersection(const std::vector<A>& l, const std::vector<A>& r) {
-    std::vector<A> it;
-    for (auto& e : l) {
-      if (elem(e, r)) {
-	it.push_back(e);
-      }
-    }
-    return it;
+    return view::to_vector(view::filter(l, [&r](const A& e) { return elem(e, r); }));
   }  
   
   template<typename A>
@@ -411,10 +539,7 @@ namespace afk {
   template<typename T>
   std::vector<T> difference(const std::vector<T>& a,
 			    const std::vector<T>& b) {
-    std::vector<T> diff = a;
-    subtract(diff, b);
-
-    return diff;
+    return view::to_vector(view::filter(a, [&b](const T& e) { return !elem(e, b); }));
   }
 
   template<typename T>
@@ -461,7 +586,7 @@ namespace afk {
   template<typename I>
   std::vector<I> concat_all(const std::vector<std::vector<I>>& vs) {
     std::vector<I> all_vs;
-    for (auto v : vs) {
+    for (auto& v : vs) {
       concat(all_vs, v);
     }
     return all_vs;
@@ -514,10 +639,10 @@ namespace afk {
   partial_order_maxima(const std::vector<T>& elems, F f) {
     std::vector<T> maxima;
     for (unsigned i = 0; i < elems.size(); i++) {
-      auto e = elems[i];
+      const T& e = elems[i];
       bool gt_all = true;
       for (unsigned j = 0; j < elems.size(); j++) {
-	auto a = elems[j];
+	const T& a = elems[j];
 	if (i != j && !f(a, e)) {
 	  gt_all = false;
 	}
@@ -539,9 +664,9 @@ namespace afk {
     if (to_check.size() == 0) { return to_return_from.front(); }
 
     for (unsigned i = 0; i < to_return_from.size(); i++) {
-      Elem q = to_return_from[i];
+      const Elem& q = to_return_from[i];
       if (all_of(begin(to_check), end(to_check),
-		 [q, orthogonal](const Elem& r)
+		 [&q, &orthogonal](const Elem& r)
 		 { return orthogonal(q, r); })) {
 	return to_return_from[i];
       }
@@ -758,12 +883,12 @@ namespace afk {
 
   template<typename A, typename F>
   bool any_of(const A& container, F f) {
-    return any_of(begin(container), end(container), f);
+    return std::any_of(std::begin(container), std::end(container), f);
   }
 
   template<typename A, typename F>
   bool all_of(const A& container, F f) {
-    return all_of(begin(container), end(container), f);
+    return std::all_of(std::begin(container), std::end(container), f);
   }
 
   template<typename T, typename EqualityTest>
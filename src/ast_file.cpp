@@ -0,0 +1,285 @@
+#include "ast_file.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "hash.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace vparser {
+
+  static const char ast_file_magic[8] = {'V', 'P', 'A', 'R', 'S', 'A', 'S', 'T'};
+  static const uint32_t ast_file_byte_order = 0x01020304;
+  static const uint64_t ast_file_alignment = 8;
+
+  // Calls f on every array of the view, in file section order
+  template<typename F>
+  void for_each_section(flat_ast_view& v, F& f) {
+    f(v.id_exprs);
+    f(v.num_exprs);
+    f(v.slice_exprs);
+    f(v.string_literal_exprs);
+    f(v.unop_exprs);
+    f(v.binop_exprs);
+    f(v.trinop_exprs);
+    f(v.concat_exprs);
+    f(v.float_exprs);
+
+    f(v.decl_stmts);
+    f(v.always_stmts);
+    f(v.begin_stmts);
+    f(v.if_stmts);
+    f(v.assign_stmts);
+    f(v.case_stmts);
+    f(v.empty_stmts);
+    f(v.module_instantiation_stmts);
+    f(v.blocking_assign_stmts);
+    f(v.non_blocking_assign_stmts);
+    f(v.call_stmts);
+
+    f(v.modules);
+    f(v.index_pool);
+    f(v.chars);
+    f(v.string_offsets);
+  }
+
+  class section_counter {
+  public:
+    uint32_t num_sections;
+
+    section_counter() : num_sections(0) {}
+
+    template<typename T>
+    void operator()(array_view<T>&) { num_sections++; }
+  };
+
+  uint32_t num_ast_file_sections() {
+    flat_ast_view v;
+    section_counter counter;
+    for_each_section(v, counter);
+    return counter.num_sections;
+  }
+
+  uint64_t align_up(const uint64_t offset) {
+    return (offset + ast_file_alignment - 1) & ~(ast_file_alignment - 1);
+  }
+
+  class section_writer {
+  public:
+    vector<ast_file_section> sections;
+    string data;
+    uint64_t data_start;
+
+    section_writer(const uint64_t data_start_) : data_start(data_start_) {}
+
+    template<typename T>
+    void operator()(array_view<T>& arr) {
+      data.resize(align_up(data_start + data.size()) - data_start, '\0');
+      sections.push_back({data_start + data.size(), arr.size(), sizeof(T)});
+      if (arr.size() > 0) {
+        data.append((const char*) arr.data, arr.size()*sizeof(T));
+      }
+    }
+  };
+
+  std::string serialize_flat_ast(const flat_ast_view& view) {
+    uint32_t num_sections = num_ast_file_sections();
+    uint64_t data_start =
+      align_up(sizeof(ast_file_header) + num_sections*sizeof(ast_file_section));
+
+    flat_ast_view v = view;
+    section_writer writer(data_start);
+    for_each_section(v, writer);
+
+    ast_file_header header;
+    memcpy(header.magic, ast_file_magic, sizeof(header.magic));
+    header.version = ast_file_version;
+    header.byte_order = ast_file_byte_order;
+    header.file_size = data_start + writer.data.size();
+    header.num_sections = num_sections;
+    header.reserved = 0;
+    header.content_hash = 0;
+
+    string out;
+    out.reserve(header.file_size);
+    out.append((const char*) &header, sizeof(header));
+    out.append((const char*) writer.sections.data(),
+               num_sections*sizeof(ast_file_section));
+    out.resize(data_start, '\0');
+    out += writer.data;
+
+    header.content_hash = hash64::hash(out.data() + sizeof(header),
+                                       out.size() - sizeof(header));
+    memcpy(&out[0], &header, sizeof(header));
+    return out;
+  }
+
+  bool write_ast_file(const std::string& path, const flat_ast_view& view) {
+    static atomic<unsigned> tmp_count(0);
+
+    string tmp_path =
+      path + ".tmp." + std::to_string(getpid()) + "." +
+      std::to_string(tmp_count++);
+
+    string contents = serialize_flat_ast(view);
+    {
+      ofstream out(tmp_path, ios::out | ios::binary | ios::trunc);
+      out.write(contents.data(), contents.size());
+      if (!out) {
+        remove(tmp_path.c_str());
+        return false;
+      }
+    }
+
+    if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+      remove(tmp_path.c_str());
+      return false;
+    }
+
+    return true;
+  }
+
+  class section_loader {
+  public:
+    const char* data;
+    size_t size;
+    const ast_file_section* sections;
+    uint32_t next;
+    bool ok;
+
+    section_loader(const char* data_,
+                   const size_t size_,
+                   const ast_file_section* sections_) :
+      data(data_), size(size_), sections(sections_), next(0), ok(true) {}
+
+    template<typename T>
+    void operator()(array_view<T>& arr) {
+      const ast_file_section& sec = sections[next];
+      next++;
+
+      if (!ok ||
+          (sec.elem_size != sizeof(T)) ||
+          (sec.offset % ast_file_alignment != 0) ||
+          (sec.offset > size) ||
+          (((uint64_t) sec.count)*sizeof(T) > size - sec.offset)) {
+        ok = false;
+        return;
+      }
+
+      arr = array_view<T>((const T*) (data + sec.offset), sec.count);
+    }
+  };
+
+  bool load_flat_ast_view(const char* data,
+                          const size_t size,
+                          flat_ast_view& view) {
+    if (size < sizeof(ast_file_header) ||
+        ((uintptr_t) data) % ast_file_alignment != 0) {
+      return false;
+    }
+
+    const ast_file_header* header = (const ast_file_header*) data;
+    uint32_t num_sections = num_ast_file_sections();
+    if ((memcmp(header->magic, ast_file_magic, sizeof(header->magic)) != 0) ||
+        (header->version != ast_file_version) ||
+        (header->byte_order != ast_file_byte_order) ||
+        (header->file_size != size) ||
+        (header->num_sections != num_sections) ||
+        (size < sizeof(ast_file_header) + num_sections*sizeof(ast_file_section))) {
+      return false;
+    }
+
+    // A truncated or bit flipped file could otherwise hold node ids and
+    // spans that point outside their arrays
+    if (header->content_hash != hash64::hash(data + sizeof(ast_file_header),
+                                             size - sizeof(ast_file_header))) {
+      return false;
+    }
+
+    flat_ast_view v;
+    section_loader loader(data,
+                          size,
+                          (const ast_file_section*) (data + sizeof(ast_file_header)));
+    for_each_section(v, loader);
+    if (!loader.ok) {
+      return false;
+    }
+
+    // The string table always has its leading 0 offset
+    if ((v.string_offsets.size() == 0) ||
+        (v.string_offsets[v.string_offsets.size() - 1] != v.chars.size())) {
+      return false;
+    }
+
+    view = v;
+    return true;
+  }
+
+  void mapped_ast::unmap() {
+    if (data != nullptr) {
+      munmap(data, size);
+    }
+    data = nullptr;
+    size = 0;
+    copy.clear();
+    view = flat_ast_view();
+  }
+
+  bool mapped_ast::open(const std::string& path) {
+    unmap();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size == 0)) {
+      close(fd);
+      return false;
+    }
+
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+      return false;
+    }
+
+    data = mapping;
+    size = st.st_size;
+    if (!load_flat_ast_view((const char*) data, size, view)) {
+      unmap();
+      return false;
+    }
+
+    return true;
+  }
+
+  bool mapped_ast::load(const std::string& contents) {
+    unmap();
+
+    if (contents.empty()) {
+      return false;
+    }
+
+    // Stored as words so the sections keep their alignment
+    copy.resize((contents.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    memcpy(copy.data(), contents.data(), contents.size());
+    if (!load_flat_ast_view((const char*) copy.data(), contents.size(), view)) {
+      unmap();
+      return false;
+    }
+
+    return true;
+  }
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "flat_ast.h"
+
+namespace vparser {
+
+  // Binary AST files hold the arrays of a flat_ast_view back to back.
+  // Nothing in them is a pointer, so a file is used in place: loading
+  // maps it and checks the header, and the view reads from the mapping.
+  //
+  // Layout: ast_file_header, then num_sections ast_file_section
+  // entries in flat_ast_view member order, then the section data, each
+  // section 8 byte aligned. Multi-byte values use the writer's byte
+  // order; files from a machine with the other byte order are rejected.
+  // content_hash is the xxHash64 of everything after the header.
+
+  // Bump when the header, any flat_* struct or the section order changes
+  static const uint32_t ast_file_version = 2;
+
+  class ast_file_header {
+  public:
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+    uint32_t num_sections;
+    uint32_t reserved;
+    uint64_t content_hash;
+  };
+
+  class ast_file_section {
+  public:
+    uint64_t offset;
+    uint32_t count;
+    uint32_t elem_size;
+  };
+
+  std::string serialize_flat_ast(const flat_ast_view& view);
+
+  // Written to a temporary file and renamed into place
+  bool write_ast_file(const std::string& path, const flat_ast_view& view);
+
+  // Points view at the sections in data, which must stay alive and be 8
+  // byte aligned. Checks the header, the content hash and that every
+  // section lies inside data. Node ids and spans inside the sections are
+  // not checked: with a matching hash they are as the writer left them.
+  bool load_flat_ast_view(const char* data,
+                          const size_t size,
+                          flat_ast_view& view);
+
+  // A read-only mapping of a binary AST file, or a private copy of one
+  class mapped_ast {
+    void* data;
+    size_t size;
+    std::vector<uint64_t> copy;
+    flat_ast_view view;
+
+    void unmap();
+
+  public:
+
+    mapped_ast() : data(nullptr), size(0) {}
+
+    mapped_ast(const mapped_ast&) = delete;
+    mapped_ast& operator=(const mapped_ast&) = delete;
+
+    ~mapped_ast() { unmap(); }
+
+    // False if the file cannot be mapped or is not a valid AST file
+    bool open(const std::string& path);
+
+    // Copies contents, for files that were just written or could not be
+    bool load(const std::string& contents);
+
+    bool is_open() const { return (data != nullptr) || !copy.empty(); }
+
+    const flat_ast_view& get_view() const { return view; }
+  };
+
+}
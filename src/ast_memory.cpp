@@ -0,0 +1,349 @@
+#include "ast_memory.h"
+
+#include "parse.h"
+#include "visitor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <sstream>
+
+using namespace std;
+
+namespace vparser {
+
+  // Strings up to the capacity of an empty one live inside the object,
+  // how many characters that is depends on the standard library
+  size_t payload_bytes(const std::string& str) {
+    static const size_t inline_capacity = std::string().capacity();
+    return str.capacity() > inline_capacity ? str.capacity() + 1 : 0;
+  }
+
+  template<typename T, unsigned N>
+  size_t payload_bytes(const small_vector<T, N>& vec) {
+    return vec.is_inline() ? 0 : vec.capacity() * sizeof(T);
+  }
+
+  template<typename T>
+  size_t payload_bytes(const std::vector<T>& vec) {
+    return vec.capacity() * sizeof(T);
+  }
+
+  size_t expression_object_bytes(const expression_type type) {
+    switch (type) {
+    case EXPRESSION_ID:
+      return sizeof(id_expr);
+    case EXPRESSION_NUM:
+      return sizeof(num_expr);
+    case EXPRESSION_SLICE:
+      return sizeof(slice_expr);
+    case EXPRESSION_STRING_LITERAL:
+      return sizeof(string_literal_expr);
+    case EXPRESSION_UNOP:
+      return sizeof(unop_expr);
+    case EXPRESSION_BINOP:
+      return sizeof(binop_expr);
+    case EXPRESSION_TRINOP:
+      return sizeof(trinop_expr);
+    case EXPRESSION_CONCAT:
+      return sizeof(concat_expr);
+    case EXPRESSION_FLOAT:
+      return sizeof(float_expr);
+    }
+    assert(false);
+    return 0;
+  }
+
+  size_t statement_object_bytes(const statement_type type) {
+    switch (type) {
+    case STATEMENT_DECL:
+      return sizeof(decl_stmt);
+    case STATEMENT_ALWAYS:
+      return sizeof(always_stmt);
+    case STATEMENT_BEGIN:
+      return sizeof(begin_stmt);
+    case STATEMENT_IF:
+      return sizeof(if_stmt);
+    case STATEMENT_ASSIGN:
+      return sizeof(assign_stmt);
+    case STATEMENT_CASE:
+      return sizeof(case_stmt);
+    case STATEMENT_EMPTY:
+      return sizeof(empty_stmt);
+    case STATEMENT_MODULE_INSTANTIATION:
+      return sizeof(module_instantiation_stmt);
+    case STATEMENT_BLOCKING_ASSIGN:
+      return sizeof(blocking_assign_stmt);
+    case STATEMENT_NON_BLOCKING_ASSIGN:
+      return sizeof(non_blocking_assign_stmt);
+    case STATEMENT_CALL:
+      return sizeof(call_stmt);
+    }
+    assert(false);
+    return 0;
+  }
+
+  size_t expression_payload_bytes(const expression* expr) {
+    switch (expr->get_type()) {
+    case EXPRESSION_ID:
+      return payload_bytes(static_cast<const id_expr*>(expr)->get_name());
+    case EXPRESSION_NUM:
+      return payload_bytes(static_cast<const num_expr*>(expr)->get_value());
+    case EXPRESSION_STRING_LITERAL:
+      return payload_bytes(static_cast<const string_literal_expr*>(expr)->get_value());
+    case EXPRESSION_CONCAT:
+      return payload_bytes(static_cast<const concat_expr*>(expr)->get_exprs());
+    default:
+      return 0;
+    }
+  }
+
+  size_t statement_payload_bytes(const statement* stmt) {
+    switch (stmt->get_type()) {
+    case STATEMENT_DECL: {
+      auto s = static_cast<const decl_stmt*>(stmt);
+      return payload_bytes(s->get_category()) +
+        payload_bytes(s->get_storage_type()) +
+        payload_bytes(s->get_name());
+    }
+    case STATEMENT_ALWAYS: {
+      auto& sens = static_cast<const always_stmt*>(stmt)->get_sensitivity_list();
+      size_t bytes = payload_bytes(sens);
+      for (auto& ent : sens) {
+        bytes += payload_bytes(ent.second);
+      }
+      return bytes;
+    }
+    case STATEMENT_BEGIN:
+      return payload_bytes(static_cast<const begin_stmt*>(stmt)->get_statements());
+    case STATEMENT_CASE:
+      return payload_bytes(static_cast<const case_stmt*>(stmt)->get_cases());
+    case STATEMENT_CALL: {
+      auto s = static_cast<const call_stmt*>(stmt);
+      return payload_bytes(s->get_name()) + payload_bytes(s->get_args());
+    }
+    case STATEMENT_MODULE_INSTANTIATION: {
+      auto s = static_cast<const module_instantiation_stmt*>(stmt);
+      size_t bytes = payload_bytes(s->get_module_type()) +
+        payload_bytes(s->get_name()) +
+        payload_bytes(s->get_port_assignments());
+      for (auto& pa : s->get_port_assignments()) {
+        bytes += payload_bytes(pa.first);
+      }
+      return bytes;
+    }
+    default:
+      return 0;
+    }
+  }
+
+  size_t expression_node_bytes(const expression* expr) {
+    return expression_object_bytes(expr->get_type()) + expression_payload_bytes(expr);
+  }
+
+  size_t statement_node_bytes(const statement* stmt) {
+    return statement_object_bytes(stmt->get_type()) + statement_payload_bytes(stmt);
+  }
+
+  const char* expression_class_name(const expression_type type) {
+    switch (type) {
+    case EXPRESSION_ID:
+      return "id_expr";
+    case EXPRESSION_NUM:
+      return "num_expr";
+    case EXPRESSION_SLICE:
+      return "slice_expr";
+    case EXPRESSION_STRING_LITERAL:
+      return "string_literal_expr";
+    case EXPRESSION_UNOP:
+      return "unop_expr";
+    case EXPRESSION_BINOP:
+      return "binop_expr";
+    case EXPRESSION_TRINOP:
+      return "trinop_expr";
+    case EXPRESSION_CONCAT:
+      return "concat_expr";
+    case EXPRESSION_FLOAT:
+      return "float_expr";
+    }
+    assert(false);
+    return "";
+  }
+
+  const char* statement_class_name(const statement_type type) {
+    switch (type) {
+    case STATEMENT_DECL:
+      return "decl_stmt";
+    case STATEMENT_ALWAYS:
+      return "always_stmt";
+    case STATEMENT_BEGIN:
+      return "begin_stmt";
+    case STATEMENT_IF:
+      return "if_stmt";
+    case STATEMENT_ASSIGN:
+      return "assign_stmt";
+    case STATEMENT_CASE:
+      return "case_stmt";
+    case STATEMENT_EMPTY:
+      return "empty_stmt";
+    case STATEMENT_MODULE_INSTANTIATION:
+      return "module_instantiation_stmt";
+    case STATEMENT_BLOCKING_ASSIGN:
+      return "blocking_assign_stmt";
+    case STATEMENT_NON_BLOCKING_ASSIGN:
+      return "non_blocking_assign_stmt";
+    case STATEMENT_CALL:
+      return "call_stmt";
+    }
+    assert(false);
+    return "";
+  }
+
+  uint64_t ast_memory_report::total_bytes() const {
+    uint64_t bytes = modules.bytes();
+    for (auto& mem : expressions) {
+      bytes += mem.bytes();
+    }
+    for (auto& mem : statements) {
+      bytes += mem.bytes();
+    }
+    return bytes;
+  }
+
+  uint64_t ast_memory_report::num_nodes() const {
+    uint64_t n = 0;
+    for (auto& mem : expressions) {
+      n += mem.count;
+    }
+    for (auto& mem : statements) {
+      n += mem.count;
+    }
+    return n;
+  }
+
+  void ast_memory_report::add(const ast_memory_report& other) {
+    for (int i = 0; i < num_expression_types; i++) {
+      expressions[i].add(other.expressions[i]);
+    }
+    for (int i = 0; i < num_statement_types; i++) {
+      statements[i].add(other.statements[i]);
+    }
+    modules.add(other.modules);
+  }
+
+  // Every row of the report with its class name
+  static vector<pair<string, node_memory> >
+  report_rows(const ast_memory_report& report) {
+    vector<pair<string, node_memory> > rows;
+    for (int i = 0; i < num_expression_types; i++) {
+      rows.push_back({expression_class_name((expression_type) i), report.expressions[i]});
+    }
+    for (int i = 0; i < num_statement_types; i++) {
+      rows.push_back({statement_class_name((statement_type) i), report.statements[i]});
+    }
+    rows.push_back({"verilog_module", report.modules});
+    return rows;
+  }
+
+  std::string ast_memory_report::to_string() const {
+    auto rows = report_rows(*this);
+    stable_sort(rows.begin(), rows.end(),
+                [](const pair<string, node_memory>& a, const pair<string, node_memory>& b) {
+                  return a.second.bytes() > b.second.bytes();
+                });
+
+    ostringstream out;
+    char line[128];
+    snprintf(line, sizeof(line), "%-28s %10s %12s %12s %12s\n",
+             "class", "count", "object", "payload", "total");
+    out << line;
+
+    for (auto& row : rows) {
+      if (row.second.count == 0) {
+        continue;
+      }
+      snprintf(line, sizeof(line), "%-28s %10llu %12llu %12llu %12llu\n",
+               row.first.c_str(),
+               (unsigned long long) row.second.count,
+               (unsigned long long) row.second.object_bytes,
+               (unsigned long long) row.second.payload_bytes,
+               (unsigned long long) row.second.bytes());
+      out << line;
+    }
+
+    snprintf(line, sizeof(line), "%-28s %10llu %12s %12s %12llu\n",
+             "total", (unsigned long long) num_nodes(), "", "",
+             (unsigned long long) total_bytes());
+    out << line;
+    return out.str();
+  }
+
+  std::string ast_memory_report::to_json() const {
+    ostringstream out;
+    out << "{\n";
+    for (auto& row : report_rows(*this)) {
+      out << "  \"" << row.first << "\": {\"count\": " << row.second.count
+          << ", \"object_bytes\": " << row.second.object_bytes
+          << ", \"payload_bytes\": " << row.second.payload_bytes << "},\n";
+    }
+    out << "  \"total_bytes\": " << total_bytes() << "\n";
+    out << "}\n";
+    return out.str();
+  }
+
+  class memory_visitor : public ast_visitor<memory_visitor> {
+  public:
+    unordered_set<const expression*>& seen;
+    ast_memory_report& report;
+
+    memory_visitor(unordered_set<const expression*>& seen_,
+                   ast_memory_report& report_) :
+      seen(seen_), report(report_) {}
+
+    visit_result pre_expression(const expression* expr) {
+      if (!seen.insert(expr).second) {
+        return VISIT_SKIP_CHILDREN;
+      }
+
+      node_memory& mem = report.expressions[expr->get_type()];
+      mem.count++;
+      mem.object_bytes += expression_object_bytes(expr->get_type());
+      mem.payload_bytes += expression_payload_bytes(expr);
+      return VISIT_CONTINUE;
+    }
+
+    visit_result pre_statement(const statement* stmt) {
+      node_memory& mem = report.statements[stmt->get_type()];
+      mem.count++;
+      mem.object_bytes += statement_object_bytes(stmt->get_type());
+      mem.payload_bytes += statement_payload_bytes(stmt);
+      return VISIT_CONTINUE;
+    }
+  };
+
+  void ast_memory_accounting::add(const verilog_module& mod) {
+    auto& stmts = mod.get_statements();
+
+    report.modules.count++;
+    report.modules.object_bytes += sizeof(verilog_module);
+    report.modules.payload_bytes +=
+      payload_bytes(mod.get_name()) +
+      payload_bytes(mod.get_ports()) +
+      payload_bytes(stmts);
+
+    memory_visitor vis(seen, report);
+    for (auto port : mod.get_ports()) {
+      vis.walk(port);
+    }
+    for (auto stmt : stmts) {
+      vis.walk(stmt);
+    }
+  }
+
+  ast_memory_report ast_memory(const verilog_module& mod) {
+    ast_memory_accounting accounting;
+    accounting.add(mod);
+    return accounting.get_report();
+  }
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
+#include "expression.h"
+#include "parse_stats.h"
+#include "statement.h"
+
+namespace vparser {
+
+  class verilog_module;
+
+  // Strings that fit the small string buffer live inside their owner
+  size_t payload_bytes(const std::string& str);
+
+  // Bytes used by a single node (not its children): the object itself
+  // and what it owns out of line, i.e. strings too long for the small
+  // string buffer and spilled child lists
+  size_t expression_node_bytes(const expression* expr);
+  size_t statement_node_bytes(const statement* stmt);
+
+  size_t expression_object_bytes(const expression_type type);
+  size_t statement_object_bytes(const statement_type type);
+
+  // Name of the class for each node type, e.g. "binop_expr"
+  const char* expression_class_name(const expression_type type);
+  const char* statement_class_name(const statement_type type);
+
+  // Live nodes of one class and the bytes they hold
+  class node_memory {
+  public:
+    uint64_t count;
+    uint64_t object_bytes;
+    uint64_t payload_bytes;
+
+    node_memory() : count(0), object_bytes(0), payload_bytes(0) {}
+
+    uint64_t bytes() const { return object_bytes + payload_bytes; }
+
+    void add(const node_memory& other) {
+      count += other.count;
+      object_bytes += other.object_bytes;
+      payload_bytes += other.payload_bytes;
+    }
+  };
+
+  class ast_memory_report {
+  public:
+    node_memory expressions[num_expression_types];
+    node_memory statements[num_statement_types];
+
+    // verilog_module objects, their names and their port and statement
+    // vectors
+    node_memory modules;
+
+    uint64_t total_bytes() const;
+    uint64_t num_nodes() const;
+
+    void add(const ast_memory_report& other);
+
+    // A table with a row per node class, largest first
+    std::string to_string() const;
+
+    std::string to_json() const;
+  };
+
+  // Accounts for the memory of every module passed to add. A node
+  // reachable more than once (the index of an `a[i]` slice, hash-consed
+  // subexpressions, even across modules) is counted the first time only,
+  // so the report is the memory actually live.
+  class ast_memory_accounting {
+    std::unordered_set<const expression*> seen;
+    ast_memory_report report;
+
+  public:
+
+    void add(const verilog_module& mod);
+
+    const ast_memory_report& get_report() const { return report; }
+  };
+
+  ast_memory_report ast_memory(const verilog_module& mod);
+
+}
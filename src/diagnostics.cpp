@@ -0,0 +1,25 @@
+#include "diagnostics.h"
+
+namespace vparser {
+
+  std::string diagnostic::to_string(const std::string& file) const {
+    std::string str = file == "" ? "" : file + ":";
+    str += std::to_string(pos.lineNo) + ":" + std::to_string(pos.linePos) +
+      ": error: " + message;
+
+    if (context != "") {
+      str += "\n  " + context;
+    }
+
+    return str;
+  }
+
+  std::string diagnostic_engine::to_string() const {
+    std::string str = "";
+    for (auto& diag : diags) {
+      str += diag.to_string(file) + "\n";
+    }
+    return str;
+  }
+
+}
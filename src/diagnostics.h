@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "token.h"
+
+namespace vparser {
+
+  class diagnostic {
+  public:
+    source_position pos;
+
+    // Index of the offending token, -1 for errors found by the tokenizer
+    int token;
+    std::string message;
+
+    // A few tokens (or characters) around the error, never the whole input
+    std::string context;
+
+    std::string to_string(const std::string& file) const;
+  };
+
+  // Collects errors instead of aborting, so a driver parsing many files
+  // can keep the partial results and report every failure at the end.
+  class diagnostic_engine {
+    std::string file;
+    std::vector<diagnostic> diags;
+
+  public:
+
+    diagnostic_engine() : file("") {}
+
+    diagnostic_engine(const std::string& file_) : file(file_) {}
+
+    void error(const source_position& pos,
+               const int token,
+               const std::string& message,
+               const std::string& context) {
+      diags.push_back({pos, token, message, context});
+    }
+
+    bool has_errors() const { return diags.size() > 0; }
+
+    int num_errors() const { return diags.size(); }
+
+    const std::vector<diagnostic>& get_diagnostics() const { return diags; }
+
+    std::string get_file() const { return file; }
+
+    std::string to_string() const;
+  };
+
+  // Thrown by the parser after an error has been recorded, and caught at
+  // the nearest recovery point (statement boundaries, `end`, `endmodule`)
+  class parse_error {};
+
+}
@@ -0,0 +1,162 @@
+#include "driver.h"
+
+#include "macro_def.h"
+#include "tokenize.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+namespace vparser {
+
+  static bool read_file(const std::string& path, std::string& contents) {
+    ifstream in(path, ios::in | ios::binary);
+    if (!in) {
+      return false;
+    }
+
+    in.seekg(0, ios::end);
+    streamoff size = in.tellg();
+    if (size < 0) {
+      return false;
+    }
+    in.seekg(0, ios::beg);
+
+    contents.resize(size);
+    in.read(&contents[0], size);
+    return (bool) in;
+  }
+
+  std::vector<std::pair<int, int> >
+  module_token_ranges(const std::vector<token>& toks) {
+    vector<pair<int, int> > ranges;
+    int start = -1;
+    for (int i = 0; i < (int) toks.size(); i++) {
+      const string& text = toks[i].get_text();
+      if ((text == "module") && (start < 0)) {
+        start = i;
+      } else if ((text == "endmodule") && (start >= 0)) {
+        ranges.push_back({start, i});
+        start = -1;
+      }
+    }
+
+    // An unterminated module still gets parsed, for its errors
+    if (start >= 0) {
+      ranges.push_back({start, ((int) toks.size()) - 1});
+    }
+    return ranges;
+  }
+
+  static preprocessed_verilog preprocess_file(const std::string& path,
+                                              const std::string& text,
+                                              const driver_options& options,
+                                              trace_buffer* trace,
+                                              parse_stats& stats) {
+    preprocessed_verilog prep;
+    if (options.cache != nullptr) {
+      trace_span span(trace, "cache lookup", path);
+      if (options.cache->lookup(text, prep)) {
+        return prep;
+      }
+    }
+
+    {
+      trace_span span(trace, "preprocess", path);
+      prep = preprocess_code(text, stats);
+    }
+
+    if (options.cache != nullptr) {
+      trace_span span(trace, "cache store", path);
+      options.cache->store(text, prep);
+    }
+    return prep;
+  }
+
+  static void parse_file(const std::string& path,
+                         const driver_options& options,
+                         trace_buffer* trace,
+                         parsed_file& result) {
+    trace_span file_span(trace, "file", path);
+
+    result.path = path;
+    result.diags = diagnostic_engine(path);
+
+    string text;
+    {
+      trace_span span(trace, "read", path);
+      result.read_ok = read_file(path, text);
+    }
+    if (!result.read_ok) {
+      return;
+    }
+
+    preprocessed_verilog prep =
+      preprocess_file(path, text, options, trace, result.stats);
+
+    vector<token> toks;
+    {
+      trace_span span(trace, "tokenize", path);
+      toks = tokenize(prep.text, result.diags, result.stats);
+    }
+
+    auto ranges = module_token_ranges(toks);
+    if (ranges.empty()) {
+      ranges.push_back({0, ((int) toks.size()) - 1});
+    }
+
+    for (auto& range : ranges) {
+      bool whole_file = (range.first == 0) && (range.second == ((int) toks.size()) - 1);
+      const string& name =
+        range.first + 1 < (int) toks.size() ? toks[range.first + 1].get_text() : path;
+
+      trace_span span(trace, "parse", name);
+
+      vector<token> module_toks;
+      if (!whole_file) {
+        module_toks.assign(toks.begin() + range.first,
+                           toks.begin() + range.second + 1);
+      }
+
+      token_stream ts(whole_file ? toks : module_toks, result.diags);
+      ts.set_stats(&result.stats);
+      result.modules.push_back(parse_module(ts));
+    }
+  }
+
+  std::vector<parsed_file> parse_files(const std::vector<std::string>& paths,
+                                       const driver_options& options) {
+    vector<parsed_file> results(paths.size());
+
+    std::unique_ptr<afk::thread_pool> own_pool;
+    afk::thread_pool* pool = options.pool;
+    if (pool == nullptr) {
+      int num_threads = options.num_threads;
+      if (num_threads <= 0) {
+        num_threads = max(1u, std::thread::hardware_concurrency());
+      }
+      num_threads = min(num_threads, max(1, (int) paths.size()));
+
+      own_pool.reset(new afk::thread_pool(num_threads));
+      pool = own_pool.get();
+    }
+
+    // A task per file, so one slow file does not hold up a fixed share
+    // of the others
+    afk::parallel_for(*pool, paths.size(), [&paths, &options, &results, pool](const size_t i) {
+        trace_buffer* trace = nullptr;
+        if (options.trace != nullptr) {
+          trace = options.trace->thread_buffer();
+          trace->set_thread_name("parse worker " + std::to_string(pool->current_worker()));
+        }
+
+        parse_file(paths[i], options, trace, results[i]);
+      }, nullptr, 1);
+
+    return results;
+  }
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "diagnostics.h"
+#include "parallel.h"
+#include "parse.h"
+#include "parse_stats.h"
+#include "preprocess_cache.h"
+#include "trace.h"
+
+namespace vparser {
+
+  class driver_options {
+  public:
+    // 0 uses one thread per hardware thread
+    int num_threads;
+
+    // Optional: files are parsed on this pool, shared with other work,
+    // and num_threads is ignored
+    afk::thread_pool* pool;
+
+    // Optional: preprocessed text is looked up and stored here
+    preprocess_cache* cache;
+
+    // Optional: each worker records file read, cache lookup, preprocess,
+    // tokenize and per-module parse spans here
+    trace_recorder* trace;
+
+    driver_options() :
+      num_threads(0), pool(nullptr), cache(nullptr), trace(nullptr) {}
+  };
+
+  // The modules of one file, in the order they appear
+  class parsed_file {
+  public:
+    std::string path;
+    bool read_ok;
+    std::vector<verilog_module> modules;
+    diagnostic_engine diags;
+    parse_stats stats;
+
+    parsed_file() : read_ok(false) {}
+
+    bool ok() const { return read_ok && !diags.has_errors(); }
+  };
+
+  // Reads, preprocesses and parses every file on a thread pool.
+  // Errors are collected per file instead of aborting. Results are in
+  // the order of paths whatever the thread count.
+  std::vector<parsed_file> parse_files(const std::vector<std::string>& paths,
+                                       const driver_options& options);
+
+  // Token ranges [start, end] from each module keyword to its
+  // endmodule, so a file with several modules parses as several
+  // parse_module calls
+  std::vector<std::pair<int, int> >
+  module_token_ranges(const std::vector<token>& toks);
+
+}
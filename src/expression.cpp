@@ -1,4 +1,90 @@
 #include "expression.h"
 
+#include <unordered_map>
+
 namespace vparser {
+
+  // Indexed by op_code
+  static const op_info op_table[NUM_OP_CODES] = {
+    {"+", 12, 1},
+    {"-", 12, 1},
+    {"!", 12, 1},
+    {"~", 12, 1},
+    {"&", 12, 1},
+    {"~&", 12, 1},
+    {"|", 12, 1},
+    {"~|", 12, 1},
+    {"^", 12, 1},
+    {"~^", 12, 1},
+
+    {"**", 11, 2},
+    {"*", 10, 2},
+    {"/", 10, 2},
+    {"%", 10, 2},
+    {"+", 9, 2},
+    {"-", 9, 2},
+    {"<<", 8, 2},
+    {">>", 8, 2},
+    {"<<<", 8, 2},
+    {">>>", 8, 2},
+    {"<", 7, 2},
+    {"<=", 7, 2},
+    {">", 7, 2},
+    {">=", 7, 2},
+    {"==", 6, 2},
+    {"!=", 6, 2},
+    {"===", 6, 2},
+    {"!==", 6, 2},
+    {"&", 5, 2},
+    {"~&", 5, 2},
+    {"^", 4, 2},
+    {"~^", 4, 2},
+    {"|", 3, 2},
+    {"~|", 3, 2},
+    {"&&", 2, 2},
+    {"||", 1, 2},
+
+    {"?", 0, 3}
+  };
+
+  const op_info& get_op_info(const op_code op) {
+    assert(op < NUM_OP_CODES);
+    return op_table[op];
+  }
+
+  static std::unordered_map<std::string, op_code>
+  op_codes_with_arity(const int arity) {
+    std::unordered_map<std::string, op_code> codes;
+    for (int i = 0; i < NUM_OP_CODES; i++) {
+      if (op_table[i].arity == arity) {
+        codes.insert({op_table[i].spelling, (op_code) i});
+      }
+    }
+    return codes;
+  }
+
+  static bool find_op_code(const std::unordered_map<std::string, op_code>& codes,
+                           const std::string& str,
+                           op_code& op) {
+    auto it = codes.find(str);
+    if (it == codes.end()) {
+      return false;
+    }
+
+    op = it->second;
+    return true;
+  }
+
+  bool unary_op_code(const std::string& str, op_code& op) {
+    static const std::unordered_map<std::string, op_code> codes =
+      op_codes_with_arity(1);
+    return find_op_code(codes, str, op);
+  }
+
+  bool binary_op_code(const std::string& str, op_code& op) {
+    static const std::unordered_map<std::string, op_code> codes =
+      op_codes_with_arity(2);
+    return find_op_code(codes, str, op);
+  }
+
 }
@@ -2,8 +2,11 @@
 
 #include <cassert>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "small_vector.h"
+
 namespace vparser {
 
   static inline std::string parens(const std::string& str) {
@@ -20,6 +23,74 @@ namespace vparser {
     return ind;
   }
   
+  enum op_code {
+    // Unary
+    OP_PLUS,
+    OP_MINUS,
+    OP_LOGICAL_NOT,
+    OP_BITWISE_NOT,
+    OP_REDUCE_AND,
+    OP_REDUCE_NAND,
+    OP_REDUCE_OR,
+    OP_REDUCE_NOR,
+    OP_REDUCE_XOR,
+    OP_REDUCE_XNOR,
+
+    // Binary
+    OP_POW,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_ADD,
+    OP_SUB,
+    OP_SHL,
+    OP_SHR,
+    OP_ASHL,
+    OP_ASHR,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE,
+    OP_EQ,
+    OP_NEQ,
+    OP_CASE_EQ,
+    OP_CASE_NEQ,
+    OP_BITWISE_AND,
+    OP_BITWISE_NAND,
+    OP_BITWISE_XOR,
+    OP_BITWISE_XNOR,
+    OP_BITWISE_OR,
+    OP_BITWISE_NOR,
+    OP_LOGICAL_AND,
+    OP_LOGICAL_OR,
+
+    // Ternary
+    OP_CONDITIONAL,
+
+    NUM_OP_CODES
+  };
+
+  class op_info {
+  public:
+    const char* spelling;
+
+    // Higher binds tighter, binary operators of equal precedence
+    // associate to the left
+    int precedence;
+    int arity;
+  };
+
+  const op_info& get_op_info(const op_code op);
+
+  static inline std::string op_to_string(const op_code op) {
+    return get_op_info(op).spelling;
+  }
+
+  // Look up the operator spelled str, returning false if there is none
+  // with that arity
+  bool unary_op_code(const std::string& str, op_code& op);
+  bool binary_op_code(const std::string& str, op_code& op);
+
   enum expression_type {
     EXPRESSION_ID,
     EXPRESSION_NUM,
@@ -33,128 +104,104 @@ namespace vparser {
   };
 
   class expression {
+    // Stored rather than virtual so traversals can dispatch on it
+    // without a virtual call
+    expression_type type;
+
+  protected:
+
+    expression(const expression_type type_) : type(type_) {}
+
   public:
 
-    virtual expression_type get_type() const = 0;
+    expression_type get_type() const { return type; }
 
-    virtual std::string to_string() const {
-      return "EXPR PLACEHOLDER";
-    }
+    // Written by ast_printer, see printer.h
+    std::string to_string() const;
+
+    virtual ~expression() {}
   };
 
+  // Concatenations and call arguments in the sample netlists have one or
+  // two entries, so two are kept inline
+  typedef small_vector<expression*, 2> expression_list;
+
   class float_expr : public expression {
     double val;
 
   public:
 
-    float_expr(const double val_) : val(val_) {}
+    float_expr(const double val_) : expression(EXPRESSION_FLOAT), val(val_) {}
 
-    virtual expression_type get_type() const {
-      return EXPRESSION_FLOAT;
-    }
-
-    virtual std::string to_string() const {
-      return std::to_string(val);
-    }
+    double get_value() const { return val; }
   };
   
   class concat_expr : public expression {
-    std::vector<expression*> exprs;
+    expression_list exprs;
 
   public:
-    concat_expr(const std::vector<expression*> exprs_) : exprs(exprs_) {}
+    concat_expr(expression_list exprs_) :
+      expression(EXPRESSION_CONCAT), exprs(std::move(exprs_)) {}
 
-    virtual expression_type get_type() const {
-      return EXPRESSION_CONCAT;
-    }
-
-    virtual std::string to_string() const {
-      std::string str = "{ ";
-
-      for (unsigned i = 0; i < exprs.size(); i++) {
-        str += exprs[i]->to_string();
-        if (i < exprs.size() - 1) {
-          str += ", ";
-        }
-      }
-
-      str += " }";
-      return str;
-    }
+    const expression_list& get_exprs() const { return exprs; }
   };
 
   class unop_expr : public expression {
 
-    std::string op;
+    op_code op;
     expression* operand0;
     
   public:
 
-    unop_expr(const std::string& op_,
-              expression* const operand0_) : op(op_), operand0(operand0_) {}
+    unop_expr(const op_code op_,
+              expression* const operand0_) : expression(EXPRESSION_UNOP), op(op_), operand0(operand0_) {}
 
-    virtual expression_type get_type() const {
-      return EXPRESSION_UNOP;
-    }
+    expression* get_op0() const { return operand0; }
 
-    virtual std::string to_string() const {
-      return parens(op + " " + operand0->to_string());
-    }
+    op_code get_op() const { return op; }
 
   };
   
   class binop_expr : public expression {
 
-    std::string op;
+    op_code op;
     expression* operand0;
     expression* operand1;
     
   public:
 
-    binop_expr(const std::string& op_,
+    binop_expr(const op_code op_,
                expression* const operand0_,
                expression* const operand1_) :
-      op(op_), operand0(operand0_), operand1(operand1_) {}
+      expression(EXPRESSION_BINOP), op(op_), operand0(operand0_), operand1(operand1_) {}
 
     expression* get_op0() const { return operand0; }
     expression* get_op1() const { return operand1; }
 
-    std::string get_op() const { return op; }
-
-    virtual expression_type get_type() const {
-      return EXPRESSION_BINOP;
-    }
-
-    virtual std::string to_string() const {
-      return parens(operand0->to_string() + " " + op + " " + operand1->to_string());
-    }
+    op_code get_op() const { return op; }
 
   };
 
   class trinop_expr : public expression {
 
-    std::string op;
+    op_code op;
     expression* operand0;
     expression* operand1;
     expression* operand2;
     
   public:
 
-    trinop_expr(const std::string& op_,
+    trinop_expr(const op_code op_,
                 expression* const operand0_,
                 expression* const operand1_,
                 expression* const operand2_) :
-      op(op_), operand0(operand0_), operand1(operand1_), operand2(operand2_) {}
+      expression(EXPRESSION_TRINOP), op(op_), operand0(operand0_), operand1(operand1_), operand2(operand2_) {}
 
-    virtual expression_type get_type() const {
-      return EXPRESSION_TRINOP;
-    }
-
-    virtual std::string to_string() const {
-      assert(op == "?");
+    expression* get_op0() const { return operand0; }
+    expression* get_op1() const { return operand1; }
+    expression* get_op2() const { return operand2; }
 
-      return parens(operand0->to_string() + " ? " + operand1->to_string() + " : " + operand2->to_string());
-    }
+    op_code get_op() const { return op; }
     
   };
   
@@ -162,15 +209,10 @@ namespace vparser {
     std::string str;
 
   public:
-    string_literal_expr(const std::string& str_) : str(str_) {}
+    string_literal_expr(std::string str_) :
+      expression(EXPRESSION_STRING_LITERAL), str(std::move(str_)) {}
 
-    virtual std::string to_string() const {
-      return str;
-    }
-    
-    virtual expression_type get_type() const {
-      return EXPRESSION_STRING_LITERAL;
-    }
+    const std::string& get_value() const { return str; }
 
   };
 
@@ -183,23 +225,17 @@ namespace vparser {
     
   public:
 
-    num_expr(const std::string& value_) :
-      size(32), is_signed(false), radix('d'), value(value_) {}
+    num_expr(std::string value_) :
+      expression(EXPRESSION_NUM), size(32), is_signed(false), radix('d'), value(std::move(value_)) {}
 
     num_expr(const int size_,
              const char radix_,
-             const std::string& value_) :
-      size(size_), is_signed(false), radix(radix_), value(value_) {}
-
-    std::string to_string() const {
-      assert(!is_signed);
+             std::string value_) :
+      expression(EXPRESSION_NUM), size(size_), is_signed(false), radix(radix_), value(std::move(value_)) {}
 
-      return std::to_string(size) + "'" + std::string(1, radix) + value;
-    }
-    
-    virtual expression_type get_type() const {
-      return EXPRESSION_NUM;
-    }
+    int get_size() const { return size; }
+    char get_radix() const { return radix; }
+    const std::string& get_value() const { return value; }
   };
 
   class id_expr : public expression {
@@ -207,17 +243,9 @@ namespace vparser {
 
   public:
 
-    id_expr(const std::string& name_) : name(name_) {}
-
-    virtual expression_type get_type() const {
-      return EXPRESSION_ID;
-    }
+    id_expr(std::string name_) : expression(EXPRESSION_ID), name(std::move(name_)) {}
 
-    virtual std::string to_string() const {
-      return name;
-    }
-
-    std::string get_name() const { return name; }
+    const std::string& get_name() const { return name; }
   };
 
   class slice_expr : public expression {
@@ -232,20 +260,12 @@ namespace vparser {
     slice_expr(expression* const arg_,
                expression* const start_,
                expression* const end_) :
-      arg(arg_), start(start_), end(end_) {}
-
-    virtual expression_type get_type() const {
-      return EXPRESSION_SLICE;
-    }
+      expression(EXPRESSION_SLICE), arg(arg_), start(start_), end(end_) {}
 
     expression* get_start() const { return start; }
     expression* get_end() const { return end; }
 
     expression* get_arg() const { return arg; }
-
-    virtual std::string to_string() const {
-      return parens(get_arg()->to_string() + "[ " + get_start()->to_string() + " : " + get_end()->to_string() + " ]");
-    }
     
   };
   
@@ -0,0 +1,128 @@
+#include "expression_interner.h"
+
+#include <cassert>
+
+using namespace std;
+
+namespace vparser {
+
+  template<typename T>
+  void append_bytes(std::string& key, const T& val) {
+    key.append((const char*) &val, sizeof(T));
+  }
+
+  expression_interner::~expression_interner() {
+    for (auto expr : exprs) {
+      delete expr;
+    }
+  }
+
+  std::string expression_interner::key_for(const expression* expr) const {
+    string key;
+    append_bytes(key, (char) expr->get_type());
+
+    switch (expr->get_type()) {
+    case EXPRESSION_ID:
+      key += static_cast<const id_expr*>(expr)->get_name();
+      break;
+
+    case EXPRESSION_NUM: {
+      auto e = static_cast<const num_expr*>(expr);
+      append_bytes(key, e->get_size());
+      append_bytes(key, e->get_radix());
+      key += e->get_value();
+      break;
+    }
+
+    case EXPRESSION_FLOAT:
+      append_bytes(key, static_cast<const float_expr*>(expr)->get_value());
+      break;
+
+    case EXPRESSION_STRING_LITERAL:
+      key += static_cast<const string_literal_expr*>(expr)->get_value();
+      break;
+
+    case EXPRESSION_SLICE: {
+      auto e = static_cast<const slice_expr*>(expr);
+      append_bytes(key, get_id(e->get_arg()));
+      append_bytes(key, get_id(e->get_start()));
+      append_bytes(key, get_id(e->get_end()));
+      break;
+    }
+
+    case EXPRESSION_UNOP: {
+      auto e = static_cast<const unop_expr*>(expr);
+      append_bytes(key, (char) e->get_op());
+      append_bytes(key, get_id(e->get_op0()));
+      break;
+    }
+
+    case EXPRESSION_BINOP: {
+      auto e = static_cast<const binop_expr*>(expr);
+      append_bytes(key, (char) e->get_op());
+      append_bytes(key, get_id(e->get_op0()));
+      append_bytes(key, get_id(e->get_op1()));
+      break;
+    }
+
+    case EXPRESSION_TRINOP: {
+      auto e = static_cast<const trinop_expr*>(expr);
+      append_bytes(key, (char) e->get_op());
+      append_bytes(key, get_id(e->get_op0()));
+      append_bytes(key, get_id(e->get_op1()));
+      append_bytes(key, get_id(e->get_op2()));
+      break;
+    }
+
+    case EXPRESSION_CONCAT:
+      for (auto sub : static_cast<const concat_expr*>(expr)->get_exprs()) {
+        append_bytes(key, get_id(sub));
+      }
+      break;
+
+    default:
+      assert(false);
+    }
+
+    return key;
+  }
+
+  expression* expression_interner::intern(expression* expr) {
+    assert(expr != nullptr);
+
+    if (is_interned(expr)) {
+      return expr;
+    }
+
+    num_requests++;
+    requested_bytes += expression_node_bytes(expr);
+
+    string key = key_for(expr);
+    auto it = table.find(key);
+    if (it != table.end()) {
+      delete expr;
+      return exprs[it->second];
+    }
+
+    expr_id id = exprs.size();
+    exprs.push_back(expr);
+    ids.insert({expr, id});
+    table.insert({std::move(key), id});
+    return expr;
+  }
+
+  expr_id expression_interner::get_id(const expression* expr) const {
+    auto it = ids.find(expr);
+    assert(it != ids.end());
+    return it->second;
+  }
+
+  size_t expression_interner::memory_bytes() const {
+    size_t bytes = 0;
+    for (auto expr : exprs) {
+      bytes += expression_node_bytes(expr);
+    }
+    return bytes;
+  }
+
+}
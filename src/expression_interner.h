@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast_memory.h"
+#include "expression.h"
+
+namespace vparser {
+
+  typedef uint32_t expr_id;
+
+  // Hash-consing table for expressions. Structurally identical
+  // expressions are interned to a single node, so two interned
+  // expressions are equal exactly when their pointers are equal. Ids are
+  // assigned in interning order and never change.
+  //
+  // The interner owns every node it returns and must outlive the ASTs
+  // that point into it.
+  class expression_interner {
+    // Key built from the node kind, its own fields and the ids of its
+    // (already interned) children
+    std::unordered_map<std::string, expr_id> table;
+    std::unordered_map<const expression*, expr_id> ids;
+    std::vector<expression*> exprs;
+
+    int num_requests;
+    size_t requested_bytes;
+
+    std::string key_for(const expression* expr) const;
+
+  public:
+
+    expression_interner() : num_requests(0), requested_bytes(0) {}
+
+    expression_interner(const expression_interner&) = delete;
+    expression_interner& operator=(const expression_interner&) = delete;
+
+    ~expression_interner();
+
+    // Returns the unique node equal to expr. The children of expr must
+    // already be interned. If an equal node exists expr is deleted.
+    expression* intern(expression* expr);
+
+    bool is_interned(const expression* expr) const {
+      return ids.find(expr) != ids.end();
+    }
+
+    expr_id get_id(const expression* expr) const;
+
+    expression* get_expression(const expr_id id) const { return exprs[id]; }
+
+    // Number of unique nodes
+    int size() const { return exprs.size(); }
+
+    // Number of calls to intern, i.e. nodes the parser would otherwise
+    // have kept
+    int get_num_requests() const { return num_requests; }
+
+    // Bytes of the nodes kept vs bytes of every node passed to intern,
+    // counting each node's object and out of line payload
+    size_t memory_bytes() const;
+    size_t requested_memory_bytes() const { return requested_bytes; }
+  };
+
+}
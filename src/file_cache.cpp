@@ -0,0 +1,155 @@
+#include "file_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace vparser {
+
+  file_cache::file_cache(const std::string& dir_,
+                         const std::string& extension_) :
+    dir(dir_), extension(extension_) {
+    if ((mkdir(dir.c_str(), 0777) != 0) && (errno != EEXIST)) {
+      cout << "Error: Could not create cache directory " << dir << endl;
+    }
+  }
+
+  std::string file_cache::path_for(const uint64_t key) const {
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long) key);
+    return dir + "/" + name + extension;
+  }
+
+  bool file_cache::load(const uint64_t key, std::string& contents) const {
+    ifstream in(path_for(key), ios::in | ios::binary);
+    if (!in) {
+      return false;
+    }
+
+    stringstream ss;
+    ss << in.rdbuf();
+    contents = ss.str();
+    return true;
+  }
+
+  void file_cache::store(const uint64_t key, const std::string& contents) const {
+    static atomic<unsigned> tmp_count(0);
+
+    string final_path = path_for(key);
+    string tmp_path =
+      final_path + ".tmp." + std::to_string(getpid()) + "." +
+      std::to_string(tmp_count++);
+
+    {
+      ofstream out(tmp_path, ios::out | ios::binary | ios::trunc);
+      out.write(contents.data(), contents.size());
+      if (!out) {
+        remove(tmp_path.c_str());
+        return;
+      }
+    }
+
+    if (rename(tmp_path.c_str(), final_path.c_str()) != 0) {
+      remove(tmp_path.c_str());
+    }
+  }
+
+  void file_cache::touch(const uint64_t key) const {
+    utimensat(AT_FDCWD, path_for(key).c_str(), nullptr, 0);
+  }
+
+  class cache_entry {
+  public:
+    std::string path;
+    uint64_t bytes;
+    struct timespec last_use;
+  };
+
+  // Entry files only, temporaries from in-progress stores are skipped
+  vector<cache_entry> list_entries(const std::string& dir,
+                                   const std::string& extension) {
+    vector<cache_entry> entries;
+
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) {
+      return entries;
+    }
+
+    while (struct dirent* ent = readdir(d)) {
+      string name = ent->d_name;
+      if ((name.size() <= extension.size()) ||
+          (name.compare(name.size() - extension.size(),
+                        extension.size(),
+                        extension) != 0)) {
+        continue;
+      }
+
+      string path = dir + "/" + name;
+      struct stat st;
+      if (stat(path.c_str(), &st) == 0) {
+        entries.push_back({path, (uint64_t) st.st_size, st.st_mtim});
+      }
+    }
+
+    closedir(d);
+    return entries;
+  }
+
+  uint64_t file_cache::total_bytes() const {
+    uint64_t bytes = 0;
+    for (auto& ent : list_entries(dir, extension)) {
+      bytes += ent.bytes;
+    }
+    return bytes;
+  }
+
+  int file_cache::evict(const uint64_t max_bytes) const {
+    vector<cache_entry> entries = list_entries(dir, extension);
+
+    uint64_t bytes = 0;
+    for (auto& ent : entries) {
+      bytes += ent.bytes;
+    }
+
+    if (bytes <= max_bytes) {
+      return 0;
+    }
+
+    sort(entries.begin(), entries.end(),
+         [](const cache_entry& a, const cache_entry& b) {
+           if (a.last_use.tv_sec != b.last_use.tv_sec) {
+             return a.last_use.tv_sec < b.last_use.tv_sec;
+           }
+           return a.last_use.tv_nsec < b.last_use.tv_nsec;
+         });
+
+    // Another process may be evicting too, so a failed remove still
+    // counts as freed
+    int removed = 0;
+    for (auto& ent : entries) {
+      if (bytes <= max_bytes) {
+        break;
+      }
+
+      if (remove(ent.path.c_str()) == 0) {
+        removed++;
+      }
+      bytes -= ent.bytes;
+    }
+
+    return removed;
+  }
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace vparser {
+
+  // A directory of files named by 64 bit keys. Entries are written to a
+  // temporary file and renamed into place, so processes sharing the
+  // directory only ever see complete entries.
+  class file_cache {
+    std::string dir;
+    std::string extension;
+
+  public:
+
+    file_cache(const std::string& dir_,
+               const std::string& extension_);
+
+    std::string get_dir() const { return dir; }
+
+    std::string path_for(const uint64_t key) const;
+
+    bool load(const uint64_t key, std::string& contents) const;
+
+    void store(const uint64_t key, const std::string& contents) const;
+
+    // Marks the entry as just used, for evict
+    void touch(const uint64_t key) const;
+
+    // Bytes used by all entries
+    uint64_t total_bytes() const;
+
+    // Removes the least recently stored or touched entries until the
+    // entries use at most max_bytes, returns the number removed. Entries
+    // other processes have mapped stay readable until they unmap them.
+    int evict(const uint64_t max_bytes) const;
+  };
+
+}
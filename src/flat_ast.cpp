@@ -0,0 +1,514 @@
+#include "flat_ast.h"
+
+using namespace std;
+
+namespace vparser {
+
+  string_id flat_ast::add_string(const std::string& str) {
+    auto it = string_ids.find(str);
+    if (it != string_ids.end()) {
+      return it->second;
+    }
+
+    // Offsets are 32 bits, so the table holds at most 4 GB of characters
+    assert(chars.size() + str.size() <= UINT32_MAX);
+
+    string_id id = string_offsets.size() - 1;
+    chars.insert(chars.end(), str.begin(), str.end());
+    string_offsets.push_back(chars.size());
+    string_ids.insert({str, id});
+    return id;
+  }
+
+  flat_span flat_ast::add_span(const std::vector<uint32_t>& inds) {
+    assert(index_pool.size() + inds.size() <= UINT32_MAX);
+
+    flat_span span{(uint32_t) index_pool.size(), (uint32_t) inds.size()};
+    index_pool.insert(index_pool.end(), inds.begin(), inds.end());
+    return span;
+  }
+
+  template<typename T>
+  node_id push_node(const int kind, std::vector<T>& nodes, const T& node) {
+    assert(nodes.size() < node_index_mask);
+
+    nodes.push_back(node);
+    return make_node_id(kind, nodes.size() - 1);
+  }
+
+  node_id flat_ast::add_expression(const expression* expr) {
+    if (expr == nullptr) {
+      return null_node;
+    }
+
+    switch (expr->get_type()) {
+    case EXPRESSION_ID: {
+      auto e = static_cast<const id_expr*>(expr);
+      return push_node(EXPRESSION_ID, id_exprs, {add_string(e->get_name())});
+    }
+
+    case EXPRESSION_NUM: {
+      auto e = static_cast<const num_expr*>(expr);
+      flat_num_expr n{e->get_size(),
+          (uint32_t) e->get_radix(),
+          add_string(e->get_value())};
+      return push_node(EXPRESSION_NUM, num_exprs, n);
+    }
+
+    case EXPRESSION_SLICE: {
+      auto e = static_cast<const slice_expr*>(expr);
+      flat_slice_expr n{add_expression(e->get_arg()),
+          add_expression(e->get_start()),
+          add_expression(e->get_end())};
+      return push_node(EXPRESSION_SLICE, slice_exprs, n);
+    }
+
+    case EXPRESSION_STRING_LITERAL: {
+      auto e = static_cast<const string_literal_expr*>(expr);
+      return push_node(EXPRESSION_STRING_LITERAL,
+                       string_literal_exprs,
+                       {add_string(e->get_value())});
+    }
+
+    case EXPRESSION_UNOP: {
+      auto e = static_cast<const unop_expr*>(expr);
+      flat_unop_expr n{(uint32_t) e->get_op(), add_expression(e->get_op0())};
+      return push_node(EXPRESSION_UNOP, unop_exprs, n);
+    }
+
+    case EXPRESSION_BINOP: {
+      auto e = static_cast<const binop_expr*>(expr);
+      flat_binop_expr n{(uint32_t) e->get_op(),
+          add_expression(e->get_op0()),
+          add_expression(e->get_op1())};
+      return push_node(EXPRESSION_BINOP, binop_exprs, n);
+    }
+
+    case EXPRESSION_TRINOP: {
+      auto e = static_cast<const trinop_expr*>(expr);
+      flat_trinop_expr n{(uint32_t) e->get_op(),
+          add_expression(e->get_op0()),
+          add_expression(e->get_op1()),
+          add_expression(e->get_op2())};
+      return push_node(EXPRESSION_TRINOP, trinop_exprs, n);
+    }
+
+    case EXPRESSION_CONCAT: {
+      auto e = static_cast<const concat_expr*>(expr);
+      vector<uint32_t> inds;
+      for (auto sub : e->get_exprs()) {
+        inds.push_back(add_expression(sub));
+      }
+      return push_node(EXPRESSION_CONCAT, concat_exprs, {add_span(inds)});
+    }
+
+    case EXPRESSION_FLOAT: {
+      auto e = static_cast<const float_expr*>(expr);
+      return push_node(EXPRESSION_FLOAT, float_exprs, {e->get_value()});
+    }
+
+    default:
+      assert(false);
+      return null_node;
+    }
+  }
+
+  node_id flat_ast::add_statement(const statement* stmt) {
+    if (stmt == nullptr) {
+      return null_node;
+    }
+
+    switch (stmt->get_type()) {
+    case STATEMENT_DECL: {
+      auto s = static_cast<const decl_stmt*>(stmt);
+      flat_decl_stmt n{add_string(s->get_category()),
+          add_string(s->get_storage_type()),
+          add_string(s->get_name()),
+          add_expression(s->get_width_start()),
+          add_expression(s->get_width_end()),
+          add_expression(s->get_init_value())};
+      return push_node(STATEMENT_DECL, decl_stmts, n);
+    }
+
+    case STATEMENT_ALWAYS: {
+      auto s = static_cast<const always_stmt*>(stmt);
+      vector<uint32_t> inds;
+      for (auto& sens : s->get_sensitivity_list()) {
+        inds.push_back(sens.first);
+        inds.push_back(add_string(sens.second));
+      }
+      flat_always_stmt n{add_span(inds), add_statement(s->get_statement())};
+      return push_node(STATEMENT_ALWAYS, always_stmts, n);
+    }
+
+    case STATEMENT_BEGIN: {
+      auto s = static_cast<const begin_stmt*>(stmt);
+      vector<uint32_t> inds;
+      for (auto sub : s->get_statements()) {
+        inds.push_back(add_statement(sub));
+      }
+      return push_node(STATEMENT_BEGIN, begin_stmts, {add_span(inds)});
+    }
+
+    case STATEMENT_IF: {
+      auto s = static_cast<const if_stmt*>(stmt);
+      flat_if_stmt n{add_expression(s->get_condition()),
+          add_statement(s->get_if_exe()),
+          add_statement(s->get_else_exe())};
+      return push_node(STATEMENT_IF, if_stmts, n);
+    }
+
+    case STATEMENT_ASSIGN: {
+      auto s = static_cast<const assign_stmt*>(stmt);
+      flat_assign_stmt n{add_expression(s->get_lhs()),
+          add_expression(s->get_rhs())};
+      return push_node(STATEMENT_ASSIGN, assign_stmts, n);
+    }
+
+    case STATEMENT_CASE: {
+      auto s = static_cast<const case_stmt*>(stmt);
+      vector<uint32_t> inds;
+      for (auto& cs : s->get_cases()) {
+        inds.push_back(add_expression(cs.first));
+        inds.push_back(add_statement(cs.second));
+      }
+      flat_case_stmt n{add_span(inds), add_statement(s->get_default())};
+      return push_node(STATEMENT_CASE, case_stmts, n);
+    }
+
+    case STATEMENT_EMPTY:
+      return push_node(STATEMENT_EMPTY, empty_stmts, {0});
+
+    case STATEMENT_MODULE_INSTANTIATION: {
+      auto s = static_cast<const module_instantiation_stmt*>(stmt);
+      vector<uint32_t> inds;
+      for (auto& pa : s->get_port_assignments()) {
+        inds.push_back(add_string(pa.first));
+        inds.push_back(add_expression(pa.second));
+      }
+      flat_module_instantiation_stmt n{add_string(s->get_module_type()),
+          add_string(s->get_name()),
+          add_span(inds)};
+      return push_node(STATEMENT_MODULE_INSTANTIATION,
+                       module_instantiation_stmts,
+                       n);
+    }
+
+    case STATEMENT_BLOCKING_ASSIGN: {
+      auto s = static_cast<const blocking_assign_stmt*>(stmt);
+      flat_assign_stmt n{add_expression(s->get_lhs()),
+          add_expression(s->get_rhs())};
+      return push_node(STATEMENT_BLOCKING_ASSIGN, blocking_assign_stmts, n);
+    }
+
+    case STATEMENT_NON_BLOCKING_ASSIGN: {
+      auto s = static_cast<const non_blocking_assign_stmt*>(stmt);
+      flat_assign_stmt n{add_expression(s->get_lhs()),
+          add_expression(s->get_rhs())};
+      return push_node(STATEMENT_NON_BLOCKING_ASSIGN,
+                       non_blocking_assign_stmts,
+                       n);
+    }
+
+    case STATEMENT_CALL: {
+      auto s = static_cast<const call_stmt*>(stmt);
+      vector<uint32_t> inds;
+      for (auto arg : s->get_args()) {
+        inds.push_back(add_expression(arg));
+      }
+      flat_call_stmt n{add_string(s->get_name()), add_span(inds)};
+      return push_node(STATEMENT_CALL, call_stmts, n);
+    }
+
+    default:
+      assert(false);
+      return null_node;
+    }
+  }
+
+  uint32_t flat_ast::add_module(const verilog_module& mod) {
+    vector<uint32_t> port_inds;
+    for (auto port : mod.get_ports()) {
+      port_inds.push_back(add_statement(port));
+    }
+
+    vector<uint32_t> stmt_inds;
+    for (auto stmt : mod.get_statements()) {
+      stmt_inds.push_back(add_statement(stmt));
+    }
+
+    modules.push_back({add_string(mod.get_name()),
+          add_span(port_inds),
+          add_span(stmt_inds)});
+    return modules.size() - 1;
+  }
+
+  flat_ast_view flat_ast::view() const {
+    flat_ast_view v;
+    v.id_exprs = id_exprs;
+    v.num_exprs = num_exprs;
+    v.slice_exprs = slice_exprs;
+    v.string_literal_exprs = string_literal_exprs;
+    v.unop_exprs = unop_exprs;
+    v.binop_exprs = binop_exprs;
+    v.trinop_exprs = trinop_exprs;
+    v.concat_exprs = concat_exprs;
+    v.float_exprs = float_exprs;
+
+    v.decl_stmts = decl_stmts;
+    v.always_stmts = always_stmts;
+    v.begin_stmts = begin_stmts;
+    v.if_stmts = if_stmts;
+    v.assign_stmts = assign_stmts;
+    v.case_stmts = case_stmts;
+    v.empty_stmts = empty_stmts;
+    v.module_instantiation_stmts = module_instantiation_stmts;
+    v.blocking_assign_stmts = blocking_assign_stmts;
+    v.non_blocking_assign_stmts = non_blocking_assign_stmts;
+    v.call_stmts = call_stmts;
+
+    v.modules = modules;
+    v.index_pool = index_pool;
+    v.chars = chars;
+    v.string_offsets = string_offsets;
+    return v;
+  }
+
+  template<typename T>
+  size_t array_bytes(const std::vector<T>& v) {
+    return v.size() * sizeof(T);
+  }
+
+  size_t flat_ast::memory_bytes() const {
+    return array_bytes(id_exprs) +
+      array_bytes(num_exprs) +
+      array_bytes(slice_exprs) +
+      array_bytes(string_literal_exprs) +
+      array_bytes(unop_exprs) +
+      array_bytes(binop_exprs) +
+      array_bytes(trinop_exprs) +
+      array_bytes(concat_exprs) +
+      array_bytes(float_exprs) +
+      array_bytes(decl_stmts) +
+      array_bytes(always_stmts) +
+      array_bytes(begin_stmts) +
+      array_bytes(if_stmts) +
+      array_bytes(assign_stmts) +
+      array_bytes(case_stmts) +
+      array_bytes(empty_stmts) +
+      array_bytes(module_instantiation_stmts) +
+      array_bytes(blocking_assign_stmts) +
+      array_bytes(non_blocking_assign_stmts) +
+      array_bytes(call_stmts) +
+      array_bytes(modules) +
+      array_bytes(index_pool) +
+      array_bytes(chars) +
+      array_bytes(string_offsets);
+  }
+
+  uint32_t flat_ast_view::num_nodes() const {
+    return id_exprs.size() +
+      num_exprs.size() +
+      slice_exprs.size() +
+      string_literal_exprs.size() +
+      unop_exprs.size() +
+      binop_exprs.size() +
+      trinop_exprs.size() +
+      concat_exprs.size() +
+      float_exprs.size() +
+      decl_stmts.size() +
+      always_stmts.size() +
+      begin_stmts.size() +
+      if_stmts.size() +
+      assign_stmts.size() +
+      case_stmts.size() +
+      empty_stmts.size() +
+      module_instantiation_stmts.size() +
+      blocking_assign_stmts.size() +
+      non_blocking_assign_stmts.size() +
+      call_stmts.size();
+  }
+
+  expression* flat_ast_view::to_expression(const node_id id) const {
+    if (id == null_node) {
+      return nullptr;
+    }
+
+    uint32_t i = node_index(id);
+
+    switch (get_expr_type(id)) {
+    case EXPRESSION_ID:
+      return new id_expr(get_string(id_exprs[i].name));
+
+    case EXPRESSION_NUM: {
+      const flat_num_expr& n = num_exprs[i];
+      return new num_expr(n.size, (char) n.radix, get_string(n.value));
+    }
+
+    case EXPRESSION_SLICE: {
+      const flat_slice_expr& n = slice_exprs[i];
+      return new slice_expr(to_expression(n.arg),
+                            to_expression(n.start),
+                            to_expression(n.end));
+    }
+
+    case EXPRESSION_STRING_LITERAL:
+      return new string_literal_expr(get_string(string_literal_exprs[i].str));
+
+    case EXPRESSION_UNOP: {
+      const flat_unop_expr& n = unop_exprs[i];
+      return new unop_expr((op_code) n.op, to_expression(n.operand0));
+    }
+
+    case EXPRESSION_BINOP: {
+      const flat_binop_expr& n = binop_exprs[i];
+      return new binop_expr((op_code) n.op,
+                            to_expression(n.operand0),
+                            to_expression(n.operand1));
+    }
+
+    case EXPRESSION_TRINOP: {
+      const flat_trinop_expr& n = trinop_exprs[i];
+      return new trinop_expr((op_code) n.op,
+                             to_expression(n.operand0),
+                             to_expression(n.operand1),
+                             to_expression(n.operand2));
+    }
+
+    case EXPRESSION_CONCAT: {
+      expression_list exprs;
+      for (auto sub : get_span(concat_exprs[i].exprs)) {
+        exprs.push_back(to_expression(sub));
+      }
+      return new concat_expr(std::move(exprs));
+    }
+
+    case EXPRESSION_FLOAT:
+      return new float_expr(float_exprs[i].val);
+
+    default:
+      assert(false);
+      return nullptr;
+    }
+  }
+
+  statement* flat_ast_view::to_statement(const node_id id) const {
+    if (id == null_node) {
+      return nullptr;
+    }
+
+    uint32_t i = node_index(id);
+
+    switch (get_stmt_type(id)) {
+    case STATEMENT_DECL: {
+      const flat_decl_stmt& n = decl_stmts[i];
+      return new decl_stmt(get_string(n.category),
+                           get_string(n.storage_type),
+                           to_expression(n.w_start),
+                           to_expression(n.w_end),
+                           get_string(n.name),
+                           to_expression(n.init_value));
+    }
+
+    case STATEMENT_ALWAYS: {
+      const flat_always_stmt& n = always_stmts[i];
+      vector<pair<signal_edge, string> > sensitivity_list;
+      auto sens = get_span(n.sensitivity_list);
+      for (uint32_t j = 0; j < sens.size(); j += 2) {
+        sensitivity_list.push_back({(signal_edge) sens[j],
+              get_string(sens[j + 1])});
+      }
+      return new always_stmt(sensitivity_list, to_statement(n.stmt));
+    }
+
+    case STATEMENT_BEGIN: {
+      statement_list stmts;
+      for (auto sub : get_span(begin_stmts[i].stmts)) {
+        stmts.push_back(to_statement(sub));
+      }
+      return new begin_stmt(std::move(stmts));
+    }
+
+    case STATEMENT_IF: {
+      const flat_if_stmt& n = if_stmts[i];
+      return new if_stmt(to_expression(n.condition),
+                         to_statement(n.if_exe),
+                         to_statement(n.else_exe));
+    }
+
+    case STATEMENT_ASSIGN: {
+      const flat_assign_stmt& n = assign_stmts[i];
+      return new assign_stmt(to_expression(n.lhs), to_expression(n.rhs));
+    }
+
+    case STATEMENT_CASE: {
+      const flat_case_stmt& n = case_stmts[i];
+      case_list cases;
+      auto inds = get_span(n.cases);
+      for (uint32_t j = 0; j < inds.size(); j += 2) {
+        cases.emplace_back(to_expression(inds[j]), to_statement(inds[j + 1]));
+      }
+      return new case_stmt(std::move(cases), to_statement(n.default_stmt));
+    }
+
+    case STATEMENT_EMPTY:
+      return new empty_stmt();
+
+    case STATEMENT_MODULE_INSTANTIATION: {
+      const flat_module_instantiation_stmt& n = module_instantiation_stmts[i];
+      vector<pair<string, expression*> > port_assignments;
+      auto inds = get_span(n.port_assignments);
+      for (uint32_t j = 0; j < inds.size(); j += 2) {
+        port_assignments.push_back({get_string(inds[j]),
+              to_expression(inds[j + 1])});
+      }
+      return new module_instantiation_stmt(get_string(n.module_type),
+                                           get_string(n.name),
+                                           port_assignments);
+    }
+
+    case STATEMENT_BLOCKING_ASSIGN: {
+      const flat_assign_stmt& n = blocking_assign_stmts[i];
+      return new blocking_assign_stmt(to_expression(n.lhs),
+                                      to_expression(n.rhs));
+    }
+
+    case STATEMENT_NON_BLOCKING_ASSIGN: {
+      const flat_assign_stmt& n = non_blocking_assign_stmts[i];
+      return new non_blocking_assign_stmt(to_expression(n.lhs),
+                                          to_expression(n.rhs));
+    }
+
+    case STATEMENT_CALL: {
+      const flat_call_stmt& n = call_stmts[i];
+      expression_list args;
+      for (auto arg : get_span(n.args)) {
+        args.push_back(to_expression(arg));
+      }
+      return new call_stmt(get_string(n.name), std::move(args));
+    }
+
+    default:
+      assert(false);
+      return nullptr;
+    }
+  }
+
+  verilog_module flat_ast_view::to_module(const uint32_t module) const {
+    const flat_module& mod = modules[module];
+
+    vector<decl_stmt*> ports;
+    for (auto port : get_span(mod.ports)) {
+      assert(get_stmt_type(port) == STATEMENT_DECL);
+      ports.push_back(static_cast<decl_stmt*>(to_statement(port)));
+    }
+
+    vector<statement*> stmts;
+    for (auto stmt : get_span(mod.stmts)) {
+      stmts.push_back(to_statement(stmt));
+    }
+
+    return verilog_module(get_string(mod.name), ports, stmts);
+  }
+
+}
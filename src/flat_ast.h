@@ -0,0 +1,311 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "parse.h"
+
+namespace vparser {
+
+  // Flat AST storage. Nodes of each kind live in their own contiguous
+  // array, nodes refer to each other by 32 bit ids, child lists are spans
+  // of a shared index pool and strings are ids into one string table. No
+  // field holds a pointer, so the arrays can be copied or mapped as-is.
+
+  // The top 5 bits of a node id are the expression_type or
+  // statement_type, the rest is the index into that kind's array
+  typedef uint32_t node_id;
+  typedef uint32_t string_id;
+
+  static const node_id null_node = 0xffffffff;
+  static const int node_kind_shift = 27;
+  static const uint32_t node_index_mask = (1u << node_kind_shift) - 1;
+
+  // Each kind holds at most node_index_mask nodes, the last index of
+  // the last kind would be null_node
+  static inline node_id make_node_id(const int kind, const uint32_t index) {
+    assert((0 <= kind) && (kind < (1 << (32 - node_kind_shift))));
+    assert(index <= node_index_mask);
+
+    node_id id = (((uint32_t) kind) << node_kind_shift) | index;
+    assert(id != null_node);
+    return id;
+  }
+
+  static inline int node_kind(const node_id id) {
+    return id >> node_kind_shift;
+  }
+
+  static inline uint32_t node_index(const node_id id) {
+    return id & node_index_mask;
+  }
+
+  class flat_span {
+  public:
+    uint32_t offset;
+    uint32_t size;
+  };
+
+  class flat_id_expr {
+  public:
+    string_id name;
+  };
+
+  class flat_num_expr {
+  public:
+    int32_t size;
+    uint32_t radix;
+    string_id value;
+  };
+
+  class flat_float_expr {
+  public:
+    double val;
+  };
+
+  class flat_string_literal_expr {
+  public:
+    string_id str;
+  };
+
+  class flat_slice_expr {
+  public:
+    node_id arg;
+    node_id start;
+    node_id end;
+  };
+
+  class flat_unop_expr {
+  public:
+    uint32_t op;
+    node_id operand0;
+  };
+
+  class flat_binop_expr {
+  public:
+    uint32_t op;
+    node_id operand0;
+    node_id operand1;
+  };
+
+  class flat_trinop_expr {
+  public:
+    uint32_t op;
+    node_id operand0;
+    node_id operand1;
+    node_id operand2;
+  };
+
+  class flat_concat_expr {
+  public:
+    flat_span exprs;
+  };
+
+  class flat_decl_stmt {
+  public:
+    string_id category;
+    string_id storage_type;
+    string_id name;
+    node_id w_start;
+    node_id w_end;
+    node_id init_value;
+  };
+
+  class flat_always_stmt {
+  public:
+    // (signal_edge, signal name) pairs
+    flat_span sensitivity_list;
+    node_id stmt;
+  };
+
+  class flat_begin_stmt {
+  public:
+    flat_span stmts;
+  };
+
+  class flat_if_stmt {
+  public:
+    node_id condition;
+    node_id if_exe;
+    node_id else_exe;
+  };
+
+  // assign, blocking and non blocking assignments
+  class flat_assign_stmt {
+  public:
+    node_id lhs;
+    node_id rhs;
+  };
+
+  class flat_case_stmt {
+  public:
+    // (expression, statement) pairs
+    flat_span cases;
+    node_id default_stmt;
+  };
+
+  class flat_empty_stmt {
+  public:
+    uint32_t unused;
+  };
+
+  class flat_module_instantiation_stmt {
+  public:
+    string_id module_type;
+    string_id name;
+
+    // (port name, expression) pairs
+    flat_span port_assignments;
+  };
+
+  class flat_call_stmt {
+  public:
+    string_id name;
+    flat_span args;
+  };
+
+  class flat_module {
+  public:
+    string_id name;
+    flat_span ports;
+    flat_span stmts;
+  };
+
+  template<typename T>
+  class array_view {
+  public:
+    const T* data;
+    uint32_t count;
+
+    array_view() : data(nullptr), count(0) {}
+
+    array_view(const T* data_, const uint32_t count_) :
+      data(data_), count(count_) {}
+
+    array_view(const std::vector<T>& vec) :
+      data(vec.data()), count(vec.size()) {}
+
+    const T& operator[](const uint32_t i) const { return data[i]; }
+
+    uint32_t size() const { return count; }
+
+    const T* begin() const { return data; }
+    const T* end() const { return data + count; }
+  };
+
+  // Read-only access to flat AST arrays, wherever they are stored
+  class flat_ast_view {
+  public:
+    array_view<flat_id_expr> id_exprs;
+    array_view<flat_num_expr> num_exprs;
+    array_view<flat_slice_expr> slice_exprs;
+    array_view<flat_string_literal_expr> string_literal_exprs;
+    array_view<flat_unop_expr> unop_exprs;
+    array_view<flat_binop_expr> binop_exprs;
+    array_view<flat_trinop_expr> trinop_exprs;
+    array_view<flat_concat_expr> concat_exprs;
+    array_view<flat_float_expr> float_exprs;
+
+    array_view<flat_decl_stmt> decl_stmts;
+    array_view<flat_always_stmt> always_stmts;
+    array_view<flat_begin_stmt> begin_stmts;
+    array_view<flat_if_stmt> if_stmts;
+    array_view<flat_assign_stmt> assign_stmts;
+    array_view<flat_case_stmt> case_stmts;
+    array_view<flat_empty_stmt> empty_stmts;
+    array_view<flat_module_instantiation_stmt> module_instantiation_stmts;
+    array_view<flat_assign_stmt> blocking_assign_stmts;
+    array_view<flat_assign_stmt> non_blocking_assign_stmts;
+    array_view<flat_call_stmt> call_stmts;
+
+    array_view<flat_module> modules;
+
+    array_view<uint32_t> index_pool;
+
+    // String i is chars[string_offsets[i], string_offsets[i + 1])
+    array_view<char> chars;
+    array_view<uint32_t> string_offsets;
+
+    expression_type get_expr_type(const node_id id) const {
+      return (expression_type) node_kind(id);
+    }
+
+    statement_type get_stmt_type(const node_id id) const {
+      return (statement_type) node_kind(id);
+    }
+
+    std::string get_string(const string_id str) const {
+      return std::string(chars.data + string_offsets[str],
+                         string_offsets[str + 1] - string_offsets[str]);
+    }
+
+    array_view<uint32_t> get_span(const flat_span& span) const {
+      return array_view<uint32_t>(index_pool.data + span.offset, span.size);
+    }
+
+    uint32_t num_nodes() const;
+
+    // Adapters that build the pointer AST for a flat node
+    expression* to_expression(const node_id id) const;
+    statement* to_statement(const node_id id) const;
+    verilog_module to_module(const uint32_t module) const;
+  };
+
+  // Owns flat AST arrays, filled by flattening pointer ASTs
+  class flat_ast {
+    std::vector<flat_id_expr> id_exprs;
+    std::vector<flat_num_expr> num_exprs;
+    std::vector<flat_slice_expr> slice_exprs;
+    std::vector<flat_string_literal_expr> string_literal_exprs;
+    std::vector<flat_unop_expr> unop_exprs;
+    std::vector<flat_binop_expr> binop_exprs;
+    std::vector<flat_trinop_expr> trinop_exprs;
+    std::vector<flat_concat_expr> concat_exprs;
+    std::vector<flat_float_expr> float_exprs;
+
+    std::vector<flat_decl_stmt> decl_stmts;
+    std::vector<flat_always_stmt> always_stmts;
+    std::vector<flat_begin_stmt> begin_stmts;
+    std::vector<flat_if_stmt> if_stmts;
+    std::vector<flat_assign_stmt> assign_stmts;
+    std::vector<flat_case_stmt> case_stmts;
+    std::vector<flat_empty_stmt> empty_stmts;
+    std::vector<flat_module_instantiation_stmt> module_instantiation_stmts;
+    std::vector<flat_assign_stmt> blocking_assign_stmts;
+    std::vector<flat_assign_stmt> non_blocking_assign_stmts;
+    std::vector<flat_call_stmt> call_stmts;
+
+    std::vector<flat_module> modules;
+
+    std::vector<uint32_t> index_pool;
+
+    std::vector<char> chars;
+    std::vector<uint32_t> string_offsets;
+
+    // Only used while building, so equal strings share an id
+    std::unordered_map<std::string, string_id> string_ids;
+
+    flat_span add_span(const std::vector<uint32_t>& inds);
+
+  public:
+
+    flat_ast() : string_offsets{0} {}
+
+    string_id add_string(const std::string& str);
+
+    node_id add_expression(const expression* expr);
+    node_id add_statement(const statement* stmt);
+
+    // Flattens the module and returns its index in modules
+    uint32_t add_module(const verilog_module& mod);
+
+    flat_ast_view view() const;
+
+    // Bytes used by the arrays, not counting spare vector capacity
+    size_t memory_bytes() const;
+  };
+
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace vparser {
+
+  // xxHash64, used to key the on-disk caches by file contents
+  class hash64 {
+
+    static const uint64_t prime1 = 11400714785074694791ULL;
+    static const uint64_t prime2 = 14029467366897019727ULL;
+    static const uint64_t prime3 = 1609587929392839161ULL;
+    static const uint64_t prime4 = 9650029242287828579ULL;
+    static const uint64_t prime5 = 2870177450012600261ULL;
+
+    static uint64_t rotl(const uint64_t x, const int r) {
+      return (x << r) | (x >> (64 - r));
+    }
+
+    static uint64_t read64(const unsigned char* p) {
+      uint64_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+
+    static uint32_t read32(const unsigned char* p) {
+      uint32_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+
+    static uint64_t round(uint64_t acc, const uint64_t input) {
+      acc += input * prime2;
+      acc = rotl(acc, 31);
+      return acc * prime1;
+    }
+
+    static uint64_t merge_round(uint64_t acc, const uint64_t val) {
+      acc ^= round(0, val);
+      return acc * prime1 + prime4;
+    }
+
+  public:
+
+    static uint64_t hash(const void* data,
+                         const size_t len,
+                         const uint64_t seed = 0) {
+      const unsigned char* p = static_cast<const unsigned char*>(data);
+      const unsigned char* end = p + len;
+      uint64_t h;
+
+      if (len >= 32) {
+        const unsigned char* limit = end - 32;
+        uint64_t v1 = seed + prime1 + prime2;
+        uint64_t v2 = seed + prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - prime1;
+
+        do {
+          v1 = round(v1, read64(p)); p += 8;
+          v2 = round(v2, read64(p)); p += 8;
+          v3 = round(v3, read64(p)); p += 8;
+          v4 = round(v4, read64(p)); p += 8;
+        } while (p <= limit);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge_round(h, v1);
+        h = merge_round(h, v2);
+        h = merge_round(h, v3);
+        h = merge_round(h, v4);
+      } else {
+        h = seed + prime5;
+      }
+
+      h += (uint64_t) len;
+
+      while (p + 8 <= end) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * prime1 + prime4;
+        p += 8;
+      }
+
+      if (p + 4 <= end) {
+        h ^= (uint64_t) read32(p) * prime1;
+        h = rotl(h, 23) * prime2 + prime3;
+        p += 4;
+      }
+
+      while (p < end) {
+        h ^= (*p) * prime5;
+        h = rotl(h, 11) * prime1;
+        p++;
+      }
+
+      h ^= h >> 33;
+      h *= prime2;
+      h ^= h >> 29;
+      h *= prime3;
+      h ^= h >> 32;
+
+      return h;
+    }
+
+    static uint64_t hash(const std::string& str, const uint64_t seed = 0) {
+      return hash(str.data(), str.size(), seed);
+    }
+
+    static uint64_t combine(const uint64_t a, const uint64_t b) {
+      return merge_round(a, b);
+    }
+
+  };
+
+}
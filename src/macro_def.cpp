@@ -4,7 +4,7 @@
 #include "parse.h"
 #include "tokenize.h"
 
-#include <sstream>
+#include <unordered_map>
 
 using namespace afk;
 using namespace std;
@@ -15,13 +15,14 @@ namespace vparser {
 
     vector<string> lines;
 
-    if (text == "") { return lines; }
-
-    std::stringstream ss(text);
-    std::string to;
-    
-    while(std::getline(ss,to,'\n')) {
-      lines.push_back(to);
+    size_t start = 0;
+    while (start < text.size()) {
+      size_t end = text.find('\n', start);
+      if (end == string::npos) {
+        end = text.size();
+      }
+      lines.push_back(text.substr(start, end - start));
+      start = end + 1;
     }
 
     return lines;
@@ -67,10 +68,18 @@ namespace vparser {
   }
 
   std::string preprocess_text(const std::string& text,
-                              const std::vector<macro_def>& defs) {
+                              const std::vector<macro_def>& defs,
+                              source_map& src_map,
+                              int& num_tokens) {
     vector<token> tokens = tokenize(text);
     token_stream ts(tokens);
 
+    // The first definition of a name is the one used
+    unordered_map<string, int> def_index;
+    for (int i = 0; i < (int) defs.size(); i++) {
+      def_index.insert({defs[i].get_name(), i});
+    }
+
     vector<string> preprocessed_tokens;
 
     while (ts.chars_left()) {
@@ -78,17 +87,17 @@ namespace vparser {
       auto t = ts.next();
       
       if (t == "`") {
-        string macro_name = ts.next(1);
-        cout << "macro name = " << macro_name << endl;
-        auto mdit = find_if(begin(defs), end(defs), [macro_name](const macro_def& m) {
-            return m.get_name() == macro_name;
-          });
+        macro_expansion exp;
+        exp.source_token = ts.index();
+        exp.use_pos = tokens[ts.index()].get_pos();
+        exp.first_token = preprocessed_tokens.size();
 
-        assert(mdit != end(defs));
+        auto mdit = def_index.find(ts.next(1));
 
-        macro_def md = *mdit;
+        assert(mdit != end(def_index));
 
-        cout << md.get_name() << endl;
+        const macro_def& md = defs[mdit->second];
+        exp.macro = mdit->second;
 
         ts++;
         ts++;
@@ -97,18 +106,10 @@ namespace vparser {
           vector<vector<string>> args =
             parse_comma_list(ts);
 
-          cout << "Args" << endl;
-          for (auto& arg : args) {
-            cout << "---- A" << endl;
-            for (auto& tok : arg) {
-              cout << "\t" << tok << endl;
-            }
-          }
-
           assert(args.size() == md.get_arg_names().size());
 
           map<string, vector<string> > arg_expansions;
-          for (int i = 0; i < args.size(); i++) {
+          for (unsigned i = 0; i < args.size(); i++) {
             arg_expansions.insert({md.get_arg_names()[i], args[i]});
           }
 
@@ -129,6 +130,10 @@ namespace vparser {
 
         }
 
+        exp.num_tokens = preprocessed_tokens.size() - exp.first_token;
+        exp.num_source_tokens = ts.index() - exp.source_token;
+        src_map.add_expansion(exp);
+
       } else {
         preprocessed_tokens.push_back(t);
         ts++;
@@ -136,15 +141,26 @@ namespace vparser {
 
     }
 
+    num_tokens = preprocessed_tokens.size();
+
+    size_t len = 0;
+    for (auto& t : preprocessed_tokens) {
+      len += t.size() + 1;
+    }
+
     string prep_text;
+    prep_text.reserve(len);
     for (auto& t : preprocessed_tokens) {
-      prep_text += " " + t;
+      prep_text += ' ';
+      prep_text += t;
     }
     return prep_text;
   }
 
   preprocessed_verilog
-  preprocess_code(const std::string& verilog_text) {
+  preprocess_code(const std::string& verilog_text, parse_stats* stats) {
+    phase_timer timer(stats == nullptr ? nullptr : &(stats->preprocess));
+
     vector<string> lines = split_lines(verilog_text);
 
     // cout << "LINES" << endl;
@@ -156,21 +172,23 @@ namespace vparser {
     vector<macro_def> defs;
 
     string prep_text = "";
+    prep_text.reserve(verilog_text.size() + 1);
 
+    int line_no = 0;
     for (auto& line : lines) {
+      line_no++;
+
       if (line[0] == '`') {
 
         vector<token> toks = tokenize(line);
 
         if ((toks[0].get_text() == "`") && (toks[1].get_text() == "define")) {
-          cout << "MACRO: " << line << endl;
           token_stream ts(toks);
           ts++;
           ts++;
 
           string macro_name = ts.next();
 
-          cout << "Name: " << macro_name << endl;
           ts++;
 
           vector<vector<string> > subsequent_text =
@@ -180,8 +198,6 @@ namespace vparser {
               return txt.size() == 1;
             });
 
-          cout << "Is argmacro ? " << is_arg_macro << endl;
-
           if (is_arg_macro) {
             vector<string> args_names;
             for (auto& text : subsequent_text) {
@@ -194,13 +210,10 @@ namespace vparser {
               ts++;
             }
 
-            cout << "Macro text" << endl;
-            for (auto& tx : text) {
-              cout << tx << " ";
-            }
-            cout << endl;
-
-            defs.push_back(macro_def(macro_name, args_names, text));
+            defs.push_back(macro_def(macro_name,
+                                     args_names,
+                                     text,
+                                     source_position(line_no, 1)));
 
           } else {
             vector<string> text;
@@ -210,28 +223,109 @@ namespace vparser {
             }
             text.push_back(")");
 
-            cout << "Macro body: ";
-            for (auto& t : text) {
-              cout << t << " ";
-            }
-            cout << endl;
-
-            defs.push_back(macro_def(macro_name, {}, text));
+            defs.push_back(macro_def(macro_name,
+                                     {},
+                                     text,
+                                     source_position(line_no, 1)));
           }
+
+          // Keep the line so positions in the source stay valid
+          prep_text += "\n";
         } else {
 
-          prep_text += line + "\n";
+          prep_text += line;
+          prep_text += '\n';
         }
       } else {
 
-        prep_text += line + "\n";
+        prep_text += line;
+        prep_text += '\n';
       }
     }
 
+    source_map src_map;
+    int num_tokens = 0;
     string tr_prep_text =
-      preprocess_text(prep_text, defs);
+      preprocess_text(prep_text, defs, src_map, num_tokens);
+
+    if (stats != nullptr) {
+      stats->preprocess.bytes += verilog_text.size();
+      stats->preprocess.tokens += num_tokens;
+      stats->macro_expansions += src_map.get_expansions().size();
+    }
+
+    return {defs, tr_prep_text, prep_text, src_map};
+  }
+
+  preprocessed_verilog
+  preprocess_code(const std::string& verilog_text) {
+    return preprocess_code(verilog_text, nullptr);
+  }
+
+  preprocessed_verilog
+  preprocess_code(const std::string& verilog_text, parse_stats& stats) {
+    return preprocess_code(verilog_text, &stats);
+  }
+
+  const macro_expansion*
+  source_map::last_expansion_at(const int output_token) const {
+    auto it = upper_bound(begin(expansions), end(expansions), output_token,
+                          [](const int tok, const macro_expansion& exp) {
+                            return tok < exp.first_token;
+                          });
+
+    if (it == begin(expansions)) {
+      return nullptr;
+    }
+
+    return &(*(it - 1));
+  }
+
+  const macro_expansion*
+  source_map::find_expansion(const int output_token) const {
+    const macro_expansion* exp = last_expansion_at(output_token);
+    if ((exp != nullptr) &&
+        (output_token < exp->first_token + exp->num_tokens)) {
+      return exp;
+    }
+    return nullptr;
+  }
+
+  int source_map::source_token_index(const int output_token) const {
+    const macro_expansion* exp = last_expansion_at(output_token);
+
+    if (exp == nullptr) {
+      return output_token;
+    }
+
+    int exp_end = exp->first_token + exp->num_tokens;
+    if (output_token < exp_end) {
+      return exp->source_token;
+    }
+
+    return exp->source_token + exp->num_source_tokens + (output_token - exp_end);
+  }
+
+  source_location
+  preprocessed_verilog::locate(const int output_token) const {
+    source_location loc;
+
+    const macro_expansion* exp = map.find_expansion(output_token);
+    if (exp != nullptr) {
+      loc.pos = exp->use_pos;
+      loc.macro = exp->macro;
+      loc.def_pos = defs[exp->macro].get_def_pos();
+      return loc;
+    }
+
+    vector<token> toks = tokenize(source);
+    int src = map.source_token_index(output_token);
+
+    assert(src < ((int) toks.size()));
 
-    return {defs, tr_prep_text};
+    loc.pos = toks[src].get_pos();
+    loc.macro = -1;
+    return loc;
   }
 
 }
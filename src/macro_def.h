@@ -3,6 +3,9 @@
 #include <string>
 #include <vector>
 
+#include "parse_stats.h"
+#include "token.h"
+
 namespace vparser {
 
   class macro_def {
@@ -10,25 +13,93 @@ namespace vparser {
     std::string name;
     std::vector<std::string> arg_names;
     std::vector<std::string> body;
+    source_position def_pos;
 
   public:
 
     macro_def(const std::string& name_,
               const std::vector<std::string>& arg_names_,
-              const std::vector<std::string>& body_) :
-      name(name_), arg_names(arg_names_), body(body_) {}
+              const std::vector<std::string>& body_,
+              const source_position& def_pos_ = source_position()) :
+      name(name_), arg_names(arg_names_), body(body_), def_pos(def_pos_) {}
+
+    const std::string& get_name() const { return name; }
+    const std::vector<std::string>& get_arg_names() const { return arg_names; }
+    const std::vector<std::string>& get_body() const { return body; }
+    source_position get_def_pos() const { return def_pos; }
+  };
 
-    std::string get_name() const { return name; }
-    std::vector<std::string> get_arg_names() const { return arg_names; }
-    std::vector<std::string> get_body() const { return body; }
+  // One use of a macro in the preprocessed output. The tokens it produced
+  // are [first_token, first_token + num_tokens) of the preprocessed text,
+  // and the use itself (backtick, name and arguments) is
+  // [source_token, source_token + num_source_tokens) of the source.
+  class macro_expansion {
+  public:
+    int macro;
+    int first_token;
+    int num_tokens;
+    int source_token;
+    int num_source_tokens;
+    source_position use_pos;
+  };
+
+  class source_location {
+  public:
+    // Position in the original file. For tokens produced by a macro
+    // this is the position of the macro use.
+    source_position pos;
+
+    // Index into preprocessed_verilog::defs, -1 if the token was
+    // copied straight from the source
+    int macro;
+    source_position def_pos;
+
+    bool from_macro() const { return macro >= 0; }
+  };
+
+  // Side table from preprocessed token indexes back to the source. Only
+  // macro expansions get entries, tokens copied from the source are found
+  // by counting from the nearest expansion.
+  class source_map {
+    std::vector<macro_expansion> expansions;
+
+  public:
+
+    void add_expansion(const macro_expansion& exp) {
+      expansions.push_back(exp);
+    }
+
+    const std::vector<macro_expansion>& get_expansions() const {
+      return expansions;
+    }
+
+    const macro_expansion* last_expansion_at(const int output_token) const;
+
+    const macro_expansion* find_expansion(const int output_token) const;
+
+    int source_token_index(const int output_token) const;
   };
 
   class preprocessed_verilog {
   public:
     std::vector<macro_def> defs;
     std::string text;
+
+    // The input with `define lines blanked, so its line numbers are
+    // those of the original file
+    std::string source;
+    source_map map;
+
+    // Maps the output_token'th token of text back to the original
+    // file. Tokens copied from the source need the source to be
+    // re-tokenized, so this is meant for diagnostics, not hot loops.
+    source_location locate(const int output_token) const;
   };
 
   preprocessed_verilog preprocess_code(const std::string& verilog_text);
 
+  // Adds a preprocess phase and the macro expansions to stats
+  preprocessed_verilog preprocess_code(const std::string& verilog_text,
+                                       parse_stats& stats);
+
 }
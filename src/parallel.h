@@ -0,0 +1,391 @@
+#ifndef AFK_PARALLEL_H
+#define AFK_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace afk {
+
+  // Set by whoever wants a parallel loop to stop early. Loops check it
+  // before each element, elements already running finish.
+  class cancellation_token {
+    std::atomic<bool> cancelled;
+
+  public:
+    cancellation_token() : cancelled(false) {}
+
+    void cancel() { cancelled = true; }
+
+    bool is_cancelled() const { return cancelled; }
+  };
+
+  // A fixed set of threads with a task deque each. A worker pushes the
+  // tasks it spawns onto its own deque and pops them newest first, an
+  // idle worker steals the oldest task of another deque. Threads outside
+  // the pool push onto a shared deque. Whoever waits on tasks runs queued
+  // ones meanwhile, so loops nested in loops cannot deadlock and one
+  // pool can be shared by the parse driver and any analysis on top.
+  class thread_pool {
+
+    class task_queue {
+    public:
+      std::mutex mutex;
+      std::deque<std::function<void()> > tasks;
+    };
+
+    class worker_identity {
+    public:
+      const thread_pool* pool;
+      int index;
+    };
+
+    // Queue 0 is shared by threads outside the pool, queue i > 0 belongs
+    // to worker thread i
+    std::vector<std::unique_ptr<task_queue> > queues;
+    std::vector<std::thread> threads;
+
+    std::atomic<int> num_queued;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    bool stopping;
+
+    static worker_identity& this_worker() {
+      static thread_local worker_identity id = {nullptr, 0};
+      return id;
+    }
+
+    bool pop(const int queue, const bool newest, std::function<void()>& task) {
+      task_queue& q = *queues[queue];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (q.tasks.empty()) {
+        return false;
+      }
+
+      if (newest) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+      } else {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+      }
+      num_queued--;
+      return true;
+    }
+
+    void worker_loop(const int index) {
+      this_worker() = {this, index};
+
+      while (true) {
+        if (run_pending_task()) {
+          continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake.wait(lock, [this]() { return stopping || (num_queued > 0); });
+        if (stopping && (num_queued == 0)) {
+          return;
+        }
+      }
+    }
+
+  public:
+
+    // 0 uses one thread per hardware thread. The pool starts
+    // num_threads - 1 threads, the thread waiting on a loop is the last.
+    explicit thread_pool(const int num_threads = 0) :
+      num_queued(0), stopping(false) {
+      int n = num_threads;
+      if (n <= 0) {
+        n = std::max(1u, std::thread::hardware_concurrency());
+      }
+
+      for (int i = 0; i < n; i++) {
+        queues.push_back(std::unique_ptr<task_queue>(new task_queue()));
+      }
+      for (int i = 1; i < n; i++) {
+        threads.push_back(std::thread([this, i]() { worker_loop(i); }));
+      }
+    }
+
+    // Runs whatever is still queued, then joins the threads
+    ~thread_pool() {
+      {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+      }
+      wake.notify_all();
+
+      for (auto& t : threads) {
+        t.join();
+      }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    int size() const { return queues.size(); }
+
+    // The calling thread's index: 1 to size() - 1 on the pool's own
+    // threads, 0 on any other
+    int current_worker() const {
+      const worker_identity& id = this_worker();
+      return id.pool == this ? id.index : 0;
+    }
+
+    // Tasks must not throw, task_group wraps the ones that might
+    void submit(std::function<void()> task) {
+      task_queue& q = *queues[current_worker()];
+
+      num_queued++;
+      {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back(std::move(task));
+      }
+
+      // Taking the lock orders this with a worker's check of num_queued
+      // before it sleeps, so the wake up cannot be lost
+      {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+      }
+      wake.notify_one();
+    }
+
+    // Runs one queued task on the calling thread, from its own deque if
+    // it has one, else stolen. False if every deque was empty.
+    bool run_pending_task() {
+      int self = current_worker();
+
+      std::function<void()> task;
+      bool found = pop(self, true, task);
+      for (int i = 1; (i < size()) && !found; i++) {
+        found = pop((self + i) % size(), false, task);
+      }
+
+      if (!found) {
+        return false;
+      }
+
+      task();
+      return true;
+    }
+  };
+
+  // Tasks run on a pool and waited on together. The first exception a
+  // task throws is rethrown by wait.
+  class task_group {
+    thread_pool& pool;
+
+    std::mutex mutex;
+    std::condition_variable done;
+    int outstanding;
+    std::exception_ptr error;
+
+    void finish() {
+      while (true) {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (outstanding == 0) {
+            return;
+          }
+        }
+
+        // Nothing left to help with, the remaining tasks are running
+        // on other threads
+        if (!pool.run_pending_task()) {
+          std::unique_lock<std::mutex> lock(mutex);
+          done.wait_for(lock, std::chrono::milliseconds(1),
+                        [this]() { return outstanding == 0; });
+        }
+      }
+    }
+
+  public:
+
+    explicit task_group(thread_pool& pool_) : pool(pool_), outstanding(0) {}
+
+    ~task_group() { finish(); }
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    template<typename F>
+    void run(F f) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        outstanding++;
+      }
+
+      pool.submit([this, f]() mutable {
+          std::exception_ptr err;
+          {
+            // Destroyed before the group can see the task finish, in
+            // case it refers to the waiter's stack
+            F task(std::move(f));
+            try {
+              task();
+            } catch (...) {
+              err = std::current_exception();
+            }
+          }
+
+          std::lock_guard<std::mutex> lock(mutex);
+          if (err && !error) {
+            error = err;
+          }
+          outstanding--;
+          if (outstanding == 0) {
+            done.notify_all();
+          }
+        });
+    }
+
+    void wait() {
+      finish();
+
+      if (error) {
+        std::exception_ptr err = error;
+        error = nullptr;
+        std::rethrow_exception(err);
+      }
+    }
+  };
+
+  // About eight chunks per thread, enough for stealing to even out
+  // uneven elements without paying a task per element
+  inline size_t default_grain(const thread_pool& pool, const size_t n) {
+    return std::max<size_t>(1, n / (8*pool.size()));
+  }
+
+  // Calls f(i) for every i in [0, n) on the pool, grain indexes per
+  // task (0 picks one). Once cancel is set the remaining indexes are
+  // skipped and this returns false. f is called concurrently.
+  template<typename F>
+  bool parallel_for(thread_pool& pool,
+                    const size_t n,
+                    F f,
+                    const cancellation_token* cancel = nullptr,
+                    size_t grain = 0) {
+    if (grain == 0) {
+      grain = default_grain(pool, n);
+    }
+
+    std::atomic<bool> skipped(false);
+    task_group group(pool);
+    for (size_t start = 0; start < n; start += grain) {
+      size_t end = std::min(n, start + grain);
+      group.run([&f, &skipped, cancel, start, end]() {
+          for (size_t i = start; i < end; i++) {
+            if ((cancel != nullptr) && cancel->is_cancelled()) {
+              skipped = true;
+              return;
+            }
+            f(i);
+          }
+        });
+    }
+    group.wait();
+
+    return !skipped;
+  }
+
+  // Calls f(e) for every element of elems, as above
+  template<typename T, typename F>
+  bool parallel_for(thread_pool& pool,
+                    const std::vector<T>& elems,
+                    F f,
+                    const cancellation_token* cancel = nullptr,
+                    const size_t grain = 0) {
+    return parallel_for(pool,
+                        elems.size(),
+                        [&elems, &f](const size_t i) { f(elems[i]); },
+                        cancel,
+                        grain);
+  }
+
+  // f applied to every element, results in the order of elems whatever
+  // the scheduling. Elements skipped by cancellation get a default
+  // constructed result.
+  template<typename T, typename F>
+  auto parallel_map(thread_pool& pool,
+                    const std::vector<T>& elems,
+                    F f,
+                    const cancellation_token* cancel = nullptr,
+                    const size_t grain = 0)
+    -> std::vector<typename std::decay<decltype(f(elems[0]))>::type> {
+    typedef typename std::decay<decltype(f(elems[0]))>::type R;
+    static_assert(!std::is_same<R, bool>::value,
+                  "std::vector<bool> elements cannot be written concurrently");
+
+    std::vector<R> results(elems.size());
+    parallel_for(pool,
+                 elems.size(),
+                 [&elems, &f, &results](const size_t i) { results[i] = f(elems[i]); },
+                 cancel,
+                 grain);
+    return results;
+  }
+
+  // Folds each chunk of grain elements from identity with
+  // fold(acc, elem), then combines the chunk results left to right with
+  // combine(acc, chunk). The chunks depend only on elems.size() and
+  // grain, never on the pool, so the result is the same for any number
+  // of threads even when the operations are not associative, like
+  // floating point addition.
+  template<typename T, typename R, typename Fold, typename Combine>
+  R parallel_reduce(thread_pool& pool,
+                    const std::vector<T>& elems,
+                    const R& identity,
+                    Fold fold,
+                    Combine combine,
+                    size_t grain = 0) {
+    if (grain == 0) {
+      grain = std::max<size_t>(1, elems.size() / 256);
+    }
+
+    size_t num_chunks = (elems.size() + grain - 1) / grain;
+
+    // Not a vector, so R = bool does not share words between chunks
+    std::deque<R> partials(num_chunks, identity);
+    parallel_for(pool,
+                 num_chunks,
+                 [&elems, &fold, &partials, grain](const size_t c) {
+                   size_t end = std::min(elems.size(), (c + 1)*grain);
+                   R acc = partials[c];
+                   for (size_t i = c*grain; i < end; i++) {
+                     acc = fold(acc, elems[i]);
+                   }
+                   partials[c] = acc;
+                 },
+                 nullptr,
+                 1);
+
+    R result = identity;
+    for (auto& partial : partials) {
+      result = combine(result, partial);
+    }
+    return result;
+  }
+
+  // For when elements and results have the same type, op does both
+  // folding and combining
+  template<typename T, typename R, typename Op>
+  R parallel_reduce(thread_pool& pool,
+                    const std::vector<T>& elems,
+                    const R& identity,
+                    Op op) {
+    return parallel_reduce(pool, elems, identity, op, op);
+  }
+
+}
+
+#endif
@@ -1,7 +1,9 @@
 #include "parse.h"
 
 #include "tokenize.h"
+#include "visitor.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -17,9 +19,18 @@ namespace vparser {
 
   expression* parse_expression(token_stream& ts,
                                const expression_parse_state expr_state);
+
+  // Tracks the nesting of the recursive parsers in the stream
+  class depth_guard {
+    token_stream& ts;
+
+  public:
+    depth_guard(token_stream& ts_) : ts(ts_) { ts.enter(); }
+    ~depth_guard() { ts.leave(); }
+  };
   
   bool is_integer(const std::string& str) {
-    for (int i = 0; i < str.size(); i++) {
+    for (unsigned i = 0; i < str.size(); i++) {
       if (!isdigit(str[i])) {
         return false;
       }
@@ -35,10 +46,67 @@ namespace vparser {
   expression* parse_expression(token_stream& ts);
   statement* parse_statement(token_stream& ts);
 
+  source_position token_stream::pos() const {
+    if (chars_left()) {
+      return toks[i].get_pos();
+    }
+
+    if (toks.size() > 0) {
+      return toks.back().get_pos();
+    }
+
+    return source_position();
+  }
+
+  std::string token_stream::context() const {
+    const int radius = 5;
+    const unsigned max_chars = 120;
+
+    std::string str = "";
+    int start = std::max(0, i - radius);
+    int end = std::min((int) toks.size(), i + radius + 1);
+    for (int ind = start; ind < end; ind++) {
+      str += toks[ind].get_text() + " ";
+    }
+
+    if (str.size() > max_chars) {
+      str = str.substr(0, max_chars) + "...";
+    }
+
+    return str;
+  }
+
+  void token_stream::error(const std::string& msg) const {
+    if (diags == nullptr) {
+      cout << "Error: " << msg << ", near: " << context() << endl;
+      assert(false);
+    } else {
+      diags->error(pos(), i, msg, context());
+    }
+
+    throw parse_error();
+  }
+
+  void token_stream::recover(const int stmt_start) {
+    if (index() == stmt_start) {
+      i++;
+    }
+
+    while (chars_left() &&
+           (next() != ";") &&
+           (next() != "end") &&
+           (next() != "endmodule")) {
+      i++;
+    }
+
+    if (next() == ";") {
+      i++;
+    }
+  }
+
   void parse_token(const string& str, token_stream& ts) {
     if (ts.next() != str) {
-      cout << "Error: Unexpected token: " << ts.next() << ", expected " << str << endl;
-      assert(false);
+      ts.error("Unexpected token: " + ts.next() + ", expected " + str);
     }
 
     ts++;
@@ -48,7 +116,9 @@ namespace vparser {
 				  const string& end_delim,
 				  const string& sep,
 				  token_stream& ts) {
-    assert(ts.next() == start_delim);
+    if (ts.next() != start_delim) {
+      ts.error("Expected " + start_delim);
+    }
 
     vector<string> strs;
 
@@ -67,9 +137,7 @@ namespace vparser {
 
     } while (ts.next() == sep);
 
-    assert(ts.next() == end_delim);
-
-    ts++;
+    parse_token(end_delim, ts);
 
     return strs;
   }
@@ -81,22 +149,16 @@ namespace vparser {
 
     parse_token(start, ts);
 
-    vector<string> toks;
-
-    while (ts.next() != end) {
-      toks.push_back(ts.next());
+    while (ts.chars_left() && (ts.next() != end)) {
       ts++;
     }
 
-    assert(ts.next() == end);
-    ts++;
+    parse_token(end, ts);
 
     return;
   }
 
   statement* parse_always(token_stream& ts) {
-    string ns = ts.next();
-
     parse_token("always", ts);
 
     parse_token("@", ts);
@@ -107,20 +169,19 @@ namespace vparser {
     while (true) {
       if (ts.next() == "posedge") {
         ts++;
-        sensitivity_list.push_back({SIGNAL_POSEDGE, ts.next()});
+        sensitivity_list.emplace_back(SIGNAL_POSEDGE, ts.next());
         ts++;
       } else if (ts.next() == "negedge") {
         ts++;
-        sensitivity_list.push_back({SIGNAL_NEGEDGE, ts.next()});
+        sensitivity_list.emplace_back(SIGNAL_NEGEDGE, ts.next());
         ts++;
       } else if (ts.next() == "*") {
         ts++;
-        sensitivity_list.push_back({SIGNAL_STAR, ""});
+        sensitivity_list.emplace_back(SIGNAL_STAR, "");
       } else if (ts.next() == "or") {
         ts++;
       } else {
-        cout << "Unexpected token in sensitivity list = " << ts.remaining_string() << endl;
-        assert(false);
+        ts.error("Unexpected token in sensitivity list: " + ts.next());
       }
 
       if (ts.next() == ")") {
@@ -133,29 +194,25 @@ namespace vparser {
 
     statement* stmt = parse_statement(ts);
 
-    return new always_stmt(sensitivity_list, stmt);
+    return new always_stmt(std::move(sensitivity_list), stmt);
   }
 
   decl_stmt* parse_declaration(token_stream& ts) {
     //cout << "Parsing declartion = " << ts.remaining_string() << endl;
 
-    string ns = ts.next();
-
     string category = "input";
-    if ((ns == "input") || (ns == "output")) {
-      category = ns;
+    if ((ts.next() == "input") || (ts.next() == "output")) {
+      category = ts.next();
       ts++;
     }
 
     cout << "category = " << category << endl;
     //cout << "after category decl = " << ts.remaining_string() << endl;
 
-    ns = ts.next();
-
     string storageType = "wire";
-    cout << "ns == " << ns << endl;
-    if ((ns == "reg") || (ns == "wire")) {
-      storageType = ns;
+    cout << "ns == " << ts.next() << endl;
+    if ((ts.next() == "reg") || (ts.next() == "wire")) {
+      storageType = ts.next();
       ts++;
     }
 
@@ -185,11 +242,11 @@ namespace vparser {
     if (ts.next() == ";") {
       parse_token(";", ts);
 
-      return new decl_stmt(category,
-                           storageType,
+      return new decl_stmt(std::move(category),
+                           std::move(storageType),
                            width_start,
                            width_end,
-                           name,
+                           std::move(name),
                            nullptr);
     }
 
@@ -197,12 +254,12 @@ namespace vparser {
 
     auto init_value = parse_expression(ts);
 
-    return new decl_stmt(category,
-                           storageType,
-                           width_start,
-                           width_end,
-                           name,
-                           init_value);
+    return new decl_stmt(std::move(category),
+                         std::move(storageType),
+                         width_start,
+                         width_end,
+                         std::move(name),
+                         init_value);
     
     parse_token(";", ts);
     
@@ -211,23 +268,19 @@ namespace vparser {
   decl_stmt* parse_port_declaration(token_stream& ts) {
     //cout << "Parsing declartion = " << ts.remaining_string() << endl;
 
-    string ns = ts.next();
-
     string category = "input";
-    if ((ns == "input") || (ns == "output")) {
-      category = ns;
+    if ((ts.next() == "input") || (ts.next() == "output")) {
+      category = ts.next();
       ts++;
     }
 
     cout << "category = " << category << endl;
     //cout << "after category decl = " << ts.remaining_string() << endl;
 
-    ns = ts.next();
-
     string storageType = "wire";
-    cout << "ns == " << ns << endl;
-    if ((ns == "reg") || (ns == "wire")) {
-      storageType = ns;
+    cout << "ns == " << ts.next() << endl;
+    if ((ts.next() == "reg") || (ts.next() == "wire")) {
+      storageType = ts.next();
       ts++;
     }
 
@@ -254,26 +307,33 @@ namespace vparser {
     string name = ts.next();
     ts++;
 
-    return new decl_stmt(category,
-                         storageType,
+    return new decl_stmt(std::move(category),
+                         std::move(storageType),
                          width_start,
                          width_end,
-                         name,
+                         std::move(name),
                          nullptr);
   }
   
   statement* parse_stmt_block(token_stream& ts) {
     parse_token("begin", ts);
 
-    vector<statement*> stmts;
+    statement_list stmts;
 
-    while (ts.next() != "end") {
-      stmts.push_back(parse_statement(ts));
+    while (ts.chars_left() &&
+           (ts.next() != "end") &&
+           (ts.next() != "endmodule")) {
+      int start = ts.index();
+      try {
+        stmts.push_back(parse_statement(ts));
+      } catch (const parse_error&) {
+        ts.recover(start);
+      }
     }
 
     parse_token("end", ts);
 
-    return new begin_stmt(stmts);
+    return new begin_stmt(std::move(stmts));
   }
 
   statement* parse_if(token_stream& ts) {
@@ -304,12 +364,16 @@ namespace vparser {
 
     cout << "Parsing module: " << module_type << endl;
 
-    assert(is_id(module_type));
+    if (!is_id(module_type)) {
+      ts.error("Expected module name, got " + module_type);
+    }
 
     string module_name = ts.next();
     ts++;
 
-    assert(is_id(module_name));
+    if (!is_id(module_name)) {
+      ts.error("Expected instance name, got " + module_name);
+    }
 
     vector<pair<string, expression*> > port_assignments;
 
@@ -327,7 +391,7 @@ namespace vparser {
 
       parse_token(")", ts);
 
-      port_assignments.push_back({port_name, expr});      
+      port_assignments.emplace_back(std::move(port_name), expr);
 
       if (ts.next() == ",") {
         parse_token(",", ts);
@@ -339,9 +403,9 @@ namespace vparser {
 
     parse_token(")", ts);
 
-    return new module_instantiation_stmt(module_type,
-                                         module_name,
-                                         port_assignments);
+    return new module_instantiation_stmt(std::move(module_type),
+                                         std::move(module_name),
+                                         std::move(port_assignments));
   }
 
   statement* parse_id_statement(token_stream& ts) {
@@ -358,7 +422,9 @@ namespace vparser {
   }
 
   int parse_integer(token_stream& ts) {
-    assert(is_integer(ts.next()));
+    if (!is_integer(ts.next())) {
+      ts.error("Expected integer, got " + ts.next());
+    }
 
     int val = stoi(ts.next());
     ts++;
@@ -366,7 +432,7 @@ namespace vparser {
   }
 
   expression* parse_basic_expression(token_stream& ts) {
-    string nx = ts.next();
+    const string& nx = ts.next();
 
     expression* expr = nullptr;
     if (is_integer(nx)) {
@@ -376,7 +442,7 @@ namespace vparser {
 
         parse_token("'", ts);
 
-        string radix_value_str = ts.next();
+        const string& radix_value_str = ts.next();
         cout << "radix_str = " << radix_value_str << endl;
 
         char radix = radix_value_str[0];
@@ -384,7 +450,7 @@ namespace vparser {
 
         ts++;
 
-        expr = new num_expr(stoi(nx), radix, value);
+        expr = ts.intern(new num_expr(stoi(nx), radix, std::move(value)));
       } else if (ts.next(1) == ".") {
         ts++;
         ts++;
@@ -393,18 +459,18 @@ namespace vparser {
         cout << "Parsing number = " << num_str << endl;
         double num = stod(num_str);
 
-        expr = new float_expr(num);
+        expr = ts.intern(new float_expr(num));
       } else {
         parse_integer(ts);
 
-        expr = new num_expr(nx);
+        expr = ts.intern(new num_expr(nx));
       }
     } else if (is_id(nx)) {
       ts++;
-      expr = new id_expr(nx);
+      expr = ts.intern(new id_expr(nx));
     } else if (nx[0] == '"') {
       ts++;
-      return new string_literal_expr(nx);
+      return ts.intern(new string_literal_expr(nx));
     } else if (nx == "(") {
       parse_token("(", ts);
 
@@ -416,7 +482,7 @@ namespace vparser {
     } else if (nx == "{") {
       parse_token("{", ts);
 
-      vector<expression*> exprs;
+      expression_list exprs;
       while (true) {
         exprs.push_back(parse_expression(ts));
         if (ts.next() == "}") {
@@ -428,10 +494,10 @@ namespace vparser {
 
       parse_token("}", ts);
 
-      return new concat_expr(exprs);
+      return ts.intern(new concat_expr(std::move(exprs)));
 
     } else {
-      assert(false);
+      ts.error("Unexpected token at expression start: " + nx);
     }
 
     return expr;
@@ -446,113 +512,100 @@ namespace vparser {
     return !ts.chars_left() || (ts.next() == ":") || (ts.next() == "]") || (ts.next() == ")") || (ts.next() == "=") || (ts.next() == ";") || (ts.next() == "<=") || (ts.next() == "begin") || (ts.next() == "}") || (ts.next() == ",");
   }
 
-  bool is_prefix_unop(const std::string& nx) {
-    return nx == "~";
-  }
-
-  bool is_binop(const std::string& nx) {
-    return (nx == "&&") ||
-      (nx == "&") ||
-      (nx == "||") ||
-      (nx == "|") ||
-      (nx == "==") ||
-      (nx == "-") ||
-      (nx == "+") ||
-      (nx == "<<") ||
-      (nx == ">>") ||
-      (nx == "<") ||
-      (nx == ">") ||
-      (nx == "<=") ||
-      (nx == ">=") ||
-      (nx == "!=");
-      
-  }
+  expression* parse_unary_expression(token_stream& ts) {
+    depth_guard guard(ts);
 
-  expression* parse_expression(token_stream& ts,
-                               const expression_parse_state expr_state) {
-    //cout << "REMAINING: " << ts.remaining_string() << endl;
+    op_code op;
+    if (unary_op_code(ts.next(), op)) {
+      ts++;
 
-    assert(ts.chars_left());
+      auto op0 = parse_unary_expression(ts);
+      return ts.intern(new unop_expr(op, op0));
+    }
 
-    vector<expression*> exprs;
-    while (!at_expression_end(ts)) {
-      string nx = ts.next();
+    if (ts.next() == "[") {
+      ts.error("Slice without an expression to slice");
+    }
 
-      cout << "nx = " << nx << endl;
+    if (at_expression_end(ts)) {
+      ts.error("Expected expression, got " + ts.next());
+    }
 
-      expression* expr = nullptr;
-      if (is_integer(nx) ||
-          is_id(nx) ||
-          is_string_literal(nx) ||
-          (nx == "(") ||
-          (nx == "{")) {
-        expr = parse_basic_expression(ts);
-        exprs.push_back(expr);
-      } else if (nx[0] == '[') {
-        assert(exprs.size() == 1);
-
-        parse_token("[", ts);
-
-        expression* start = parse_expression(ts);
-
-        if (ts.next() == ":") {
-          parse_token(":", ts);
-          expression* end = parse_expression(ts);
-          parse_token("]", ts);
-          auto exp = new slice_expr(exprs.back(), start, end);
-          exprs.pop_back();
-          exprs.push_back(exp);
-        } else {
-          cout << "Single bracket expr" << endl;
-          parse_token("]", ts);
-          auto exp = new slice_expr(exprs.back(), start, start);
-          exprs.pop_back();
-          exprs.push_back(exp);
-        }
+    expression* expr = parse_basic_expression(ts);
 
-      } else if (is_prefix_unop(nx)) {
-        string op = nx;
-        ts++;
+    while (ts.next() == "[") {
+      parse_token("[", ts);
 
-        auto op0 = parse_expression(ts);
-        exprs.push_back(new unop_expr(op, op0));
-      } else if (is_binop(nx)) {
-        string op = nx;
-        ts++;
+      expression* start = parse_expression(ts);
 
-        auto op2 = parse_expression(ts);
+      if (ts.next() == ":") {
+        parse_token(":", ts);
+        expression* end = parse_expression(ts);
+        parse_token("]", ts);
+        expr = ts.intern(new slice_expr(expr, start, end));
+      } else {
+        parse_token("]", ts);
+        expr = ts.intern(new slice_expr(expr, start, start));
+      }
+    }
 
-        assert(exprs.size() == 1);
+    return expr;
+  }
 
-        auto op1 = exprs.back();
-        exprs.pop_back();
+  // Precedence climbing over the binary operators in op_table, all of
+  // which associate to the left
+  expression* parse_binary_expression(token_stream& ts,
+                                      const int min_precedence) {
+    expression* lhs = parse_unary_expression(ts);
 
-        exprs.push_back(new binop_expr(op, op1, op2));
-      } else if (nx == "?") {
-        string op = nx;
-        ts++;
+    while (!at_expression_end(ts)) {
+      op_code op;
+      if (!binary_op_code(ts.next(), op)) {
+        break;
+      }
 
-        auto op1 = parse_expression(ts);
+      int precedence = get_op_info(op).precedence;
+      if (precedence < min_precedence) {
+        break;
+      }
 
-        parse_token(":", ts);
+      ts++;
 
-        auto op2 = parse_expression(ts);
+      expression* rhs = parse_binary_expression(ts, precedence + 1);
+      lhs = ts.intern(new binop_expr(op, lhs, rhs));
+    }
 
-        auto op0 = exprs.back();
-        exprs.pop_back();
-        exprs.push_back(new trinop_expr(op, op0, op1, op2));
+    return lhs;
+  }
 
-      } else {
-        cout << "Unsupported expr = " << nx << endl;
-        assert(false);
+  expression* parse_expression(token_stream& ts,
+                               const expression_parse_state expr_state) {
+    depth_guard guard(ts);
+
+    if (!ts.chars_left()) {
+      ts.error("Unexpected end of input, expected expression");
+    }
+
+    expression* cond =
+      parse_binary_expression(ts, get_op_info(OP_CONDITIONAL).precedence + 1);
+
+    if (ts.next() != "?") {
+      if (!at_expression_end(ts)) {
+        ts.error("Unsupported expr = " + ts.next());
       }
+
+      return cond;
     }
 
-    cout << "# of Expressions = " << exprs.size() << endl;
+    ts++;
+
+    auto op1 = parse_expression(ts);
 
-    assert(exprs.size() == 1);
+    parse_token(":", ts);
 
-    return exprs[0];
+    auto op2 = parse_expression(ts);
+
+    return ts.intern(new trinop_expr(OP_CONDITIONAL, cond, op1, op2));
   }
 
   expression* parse_expression(token_stream& ts) {
@@ -565,12 +618,12 @@ namespace vparser {
 
     parse_enclosed_tokens("(", ")", ts);
 
-    vector<pair<expression*, statement*> > cases;
-    statement* default_case;
+    case_list cases;
+    statement* default_case = nullptr;
 
     bool found_default = false;    
 
-    while (ts.next() != "endcase") {
+    while (ts.chars_left() && (ts.next() != "endcase")) {
 
       expression* expr = nullptr;
       statement* stmt = nullptr;
@@ -579,7 +632,9 @@ namespace vparser {
         expr = parse_expression(ts);
       } else {
         // There can only be one default case
-        assert(!found_default);
+        if (found_default) {
+          ts.error("Duplicate default case");
+        }
 
         found_default = true;
         ts++;
@@ -592,7 +647,7 @@ namespace vparser {
       //cout << "Found statement = " << *stmt << endl;
 
       if (!found_default) {
-        cases.push_back({expr, stmt});
+        cases.emplace_back(expr, stmt);
       } else {
         default_case = stmt;
       }
@@ -602,9 +657,9 @@ namespace vparser {
     parse_token("endcase", ts);
 
     if (found_default) {
-      return new case_stmt(cases, default_case);
+      return new case_stmt(std::move(cases), default_case);
     }
-    return new case_stmt(cases);
+    return new case_stmt(std::move(cases));
   }
 
   statement* parse_call_statement(token_stream& ts) {
@@ -617,7 +672,7 @@ namespace vparser {
 
     parse_token("(", ts);
 
-    vector<expression*> args;
+    expression_list args;
     while (true) {
       cout << "next = " << ts.next() << endl;
 
@@ -628,6 +683,8 @@ namespace vparser {
         ts++;
       } else if (ts.next() == ")") {
         break;
+      } else {
+        ts.error("Expected , or ) in call arguments, got " + ts.next());
       }
     }
 
@@ -635,7 +692,7 @@ namespace vparser {
 
     parse_token(";", ts);
 
-    return new call_stmt(name, args);
+    return new call_stmt(std::move(name), std::move(args));
   }
 
   statement* parse_assign(token_stream& ts) {
@@ -645,8 +702,6 @@ namespace vparser {
       ts++;
       // TODO: Include this delay as assign parameter
       parse_basic_expression(ts);
-
-      cout << "after parsing # remainder: " << ts.remaining_string() << endl;
     }
 
     expression* lhs = parse_expression(ts);
@@ -678,7 +733,9 @@ namespace vparser {
   }
   
   statement* parse_statement(token_stream& ts) {
-    string ns = ts.next();
+    depth_guard guard(ts);
+
+    const string& ns = ts.next();
 
     if ((ns == "input") || (ns == "output") || (ns == "reg") || (ns == "wire")) {
       return parse_declaration(ts);
@@ -691,29 +748,27 @@ namespace vparser {
     } else if (ns == "begin") {
       return parse_stmt_block(ts);
     } else if (ns == "else") {
-      assert(false);
+      ts.error("else without if");
     } else if (ns == "endcase") {
-      assert(false);
+      ts.error("endcase without case");
     } else if (ns == "case") {
       return parse_case(ts);
     } else if (ns == "{") {
       return parse_non_blocking_assign(ts);
     } else if (isalpha(ns[0]) || (ns[0] == '_')) {
-      string nn = ts.next(1);
-
-      if (is_id(nn)) {
+      if (is_id(ts.next(1))) {
         return parse_module_instantiation(ts);
       } else {
 
         // Parse assignment
 
         if (ts.next() == "#") {
-          assert(false);
+          ts.error("Unsupported delay in assignment");
         }
 
         expression* lhs = parse_expression(ts);
 
-        nn = ts.next();
+        const string& nn = ts.next();
 
         if (nn == "=") {
           parse_token("=", ts);
@@ -738,7 +793,7 @@ namespace vparser {
         
       }
 
-      assert(false);
+      ts.error("Expected = or <= in assignment, got " + ts.next());
 
     } else if (ns == ";") {
       ts++;
@@ -746,23 +801,16 @@ namespace vparser {
     } else if (ns == "$") {
       return parse_call_statement(ts);
     } else {
-      cout << "Unsupported statement start token = " << ns << endl;
-      while (ts.chars_left()) {
-	cout << ts.next() << endl;
-	ts++;
-      }
-
-      assert(false);
+      ts.error("Unsupported statement start token = " + ns);
     }
   }
 
-  verilog_module parse_module(const string& mod_string) {
-    vector<token> tokens = tokenize(mod_string);
-
-    token_stream ts(tokens);
+  void parse_module_header(token_stream& ts,
+                           string& mod_name,
+                           vector<decl_stmt*>& ports) {
     parse_token("module", ts);
 
-    string mod_name = ts.next();
+    mod_name = ts.next();
     ts++;
 
     vector<pair<string, expression*> > params;
@@ -782,7 +830,7 @@ namespace vparser {
 
           expression* value = parse_expression(ts);
 
-          params.push_back({name, value});
+          params.emplace_back(std::move(name), value);
         }
 
         if (ts.next() == ",") {
@@ -792,6 +840,9 @@ namespace vparser {
           parse_token(")", ts);
           break;
         }
+        if (ts.next() != "parameter") {
+          ts.error("Unexpected token in parameter list: " + ts.next());
+        }
       }
     }
 
@@ -800,7 +851,6 @@ namespace vparser {
       cout << param.first << " = " << param.second->to_string() << endl;
     }
 
-    vector<decl_stmt*> ports;
     parse_token("(", ts);
 
     while (true) {
@@ -810,6 +860,10 @@ namespace vparser {
         break;
       }
 
+      if (!ts.chars_left()) {
+        ts.error("Unexpected end of input in port list");
+      }
+
       decl_stmt* stmt = parse_port_declaration(ts);
       ports.push_back(stmt);
 
@@ -823,17 +877,196 @@ namespace vparser {
 
     // Add statement parsing
     parse_token(";", ts);
+  }
+
+  void parse_module_body(token_stream& ts,
+                         vector<statement*>& statements) {
+    while (ts.chars_left() && (ts.next() != "endmodule")) {
+      int start = ts.index();
+      try {
+        statements.push_back(parse_statement(ts));
+      } catch (const parse_error&) {
+        ts.recover(start);
+      }
+    }
+  }
+
+  // Expressions are counted as they are created, this adds the
+  // statements
+  class statement_counter : public ast_visitor<statement_counter> {
+  public:
+    parse_stats& stats;
+
+    statement_counter(parse_stats& stats_) : stats(stats_) {}
+
+    visit_result pre_expression(const expression*) {
+      return VISIT_SKIP_CHILDREN;
+    }
+
+    visit_result pre_statement(const statement* stmt) {
+      stats.statements[stmt->get_type()]++;
+      stats.ast_bytes += statement_node_bytes(stmt);
+      return VISIT_CONTINUE;
+    }
+  };
+
+  void record_module_stats(const token_stream& ts, const verilog_module& mod) {
+    parse_stats& stats = *ts.get_stats();
+    stats.parse.tokens += ts.size();
+    stats.max_depth = max(stats.max_depth, ts.get_max_depth());
+
+    statement_counter counter(stats);
+    for (auto port : mod.get_ports()) {
+      counter.walk(port);
+    }
+    for (auto stmt : mod.get_statements()) {
+      counter.walk(stmt);
+    }
+  }
+
+  verilog_module parse_module(token_stream& ts) {
+    phase_timer timer(ts.get_stats() == nullptr ? nullptr : &(ts.get_stats()->parse));
+
+    string mod_name = "";
+    vector<decl_stmt*> ports;
+
+    try {
+      parse_module_header(ts, mod_name, ports);
+    } catch (const parse_error&) {
+      ts.recover(0);
+    }
 
     vector<statement*> statements;
     // Statement parsing
-    while (ts.next() != "endmodule") {
-      statements.push_back(parse_statement(ts));
+    parse_module_body(ts, statements);
+
+    try {
+      parse_token("endmodule", ts);
+
+      if (ts.chars_left()) {
+        ts.error("Unexpected tokens after endmodule: " + ts.next());
+      }
+    } catch (const parse_error&) {
     }
-    parse_token("endmodule", ts);
 
-    assert(!ts.chars_left());
+    verilog_module mod(std::move(mod_name),
+                       std::move(ports),
+                       std::move(statements));
+    if (ts.get_stats() != nullptr) {
+      record_module_stats(ts, mod);
+    }
+    return mod;
+  }
 
-    return verilog_module(mod_name, ports, statements);
+  verilog_module parse_module(const string& mod_string) {
+    vector<token> tokens = tokenize(mod_string);
+
+    token_stream ts(tokens);
+    return parse_module(ts);
+  }
+
+  verilog_module parse_module(const std::string& mod_string,
+                              diagnostic_engine& diags) {
+    vector<token> tokens = tokenize(mod_string, diags);
+
+    token_stream ts(tokens, diags);
+    return parse_module(ts);
+  }
+
+  verilog_module parse_module(const std::string& mod_string,
+                              parse_stats& stats) {
+    vector<token> tokens = tokenize(mod_string, stats);
+
+    token_stream ts(tokens);
+    ts.set_stats(&stats);
+    stats.parse.bytes += mod_string.size();
+    return parse_module(ts);
+  }
+
+  verilog_module parse_module(const std::string& mod_string,
+                              diagnostic_engine& diags,
+                              parse_stats& stats) {
+    vector<token> tokens = tokenize(mod_string, diags, stats);
+
+    token_stream ts(tokens, diags);
+    ts.set_stats(&stats);
+    stats.parse.bytes += mod_string.size();
+    return parse_module(ts);
+  }
+
+  verilog_module parse_module_lazy(std::vector<token>& tokens,
+                                   diagnostic_engine* diags) {
+    token_stream ts =
+      diags == nullptr ? token_stream(tokens) : token_stream(tokens, *diags);
+
+    string mod_name = "";
+    vector<decl_stmt*> ports;
+
+    try {
+      parse_module_header(ts, mod_name, ports);
+    } catch (const parse_error&) {
+      ts.recover(0);
+    }
+
+    // endmodule cannot appear inside a module body, so the body ends at
+    // the last endmodule, which is normally the last token
+    int body_start = ts.index();
+    int body_end = tokens.size();
+    for (int i = tokens.size() - 1; i >= body_start; i--) {
+      if (tokens[i].get_text() == "endmodule") {
+        body_end = i;
+        break;
+      }
+    }
+
+    try {
+      if (body_end == ((int) tokens.size())) {
+        ts.seek(body_end);
+        ts.error("Missing endmodule");
+      } else if (body_end != ((int) tokens.size()) - 1) {
+        ts.seek(body_end + 1);
+        ts.error("Unexpected tokens after endmodule: " + ts.next());
+      }
+    } catch (const parse_error&) {
+    }
+
+    std::unique_ptr<lazy_module_body>
+      body(new lazy_module_body(std::move(tokens),
+                                body_start,
+                                body_end,
+                                diags != nullptr));
+
+    return verilog_module(std::move(mod_name), std::move(ports), std::move(body));
+  }
+
+  verilog_module parse_module_lazy(const std::string& mod_string) {
+    vector<token> tokens = tokenize(mod_string);
+    return parse_module_lazy(tokens, nullptr);
+  }
+
+  verilog_module parse_module_lazy(const std::string& mod_string,
+                                   diagnostic_engine& diags) {
+    vector<token> tokens = tokenize(mod_string, diags);
+    return parse_module_lazy(tokens, &diags);
+  }
+
+  void verilog_module::parse_body() const {
+    if (body == nullptr) {
+      return;
+    }
+
+    lazy_module_body& lb = *body;
+    std::call_once(lb.parse_once, [this, &lb]() {
+        token_stream ts =
+          lb.collect_errors ? token_stream(lb.toks, lb.diags) : token_stream(lb.toks);
+        ts.seek(lb.start);
+
+        parse_module_body(ts, statements);
+
+        // The statements own everything needed from here on
+        vector<token>().swap(lb.toks);
+        lb.parsed = true;
+      });
   }
 
   statement* parse_statement(const std::string& stmt_string) {
@@ -848,4 +1081,51 @@ namespace vparser {
     return parse_expression(ts);
   }
 
+  statement* parse_statement(const std::string& stmt_string,
+                             diagnostic_engine& diags) {
+    auto toks = tokenize(stmt_string, diags);
+    token_stream ts(toks, diags);
+    try {
+      return parse_statement(ts);
+    } catch (const parse_error&) {
+      return nullptr;
+    }
+  }
+
+  expression* parse_expression(const std::string& stmt_string,
+                               diagnostic_engine& diags) {
+    auto toks = tokenize(stmt_string, diags);
+    token_stream ts(toks, diags);
+    try {
+      return parse_expression(ts);
+    } catch (const parse_error&) {
+      return nullptr;
+    }
+  }
+
+  verilog_module parse_module(const std::string& mod_string,
+                              expression_interner& interner) {
+    vector<token> tokens = tokenize(mod_string);
+
+    token_stream ts(tokens);
+    ts.set_interner(&interner);
+    return parse_module(ts);
+  }
+
+  statement* parse_statement(const std::string& stmt_string,
+                             expression_interner& interner) {
+    auto toks = tokenize(stmt_string);
+    token_stream ts(toks);
+    ts.set_interner(&interner);
+    return parse_statement(ts);
+  }
+
+  expression* parse_expression(const std::string& stmt_string,
+                               expression_interner& interner) {
+    auto toks = tokenize(stmt_string);
+    token_stream ts(toks);
+    ts.set_interner(&interner);
+    return parse_expression(ts);
+  }
+
 }
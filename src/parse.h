@@ -1,27 +1,87 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "ast_memory.h"
+#include "diagnostics.h"
+#include "expression_interner.h"
+#include "parse_stats.h"
+#include "printer.h"
 #include "statement.h"
 #include "token.h"
 
 namespace vparser {
 
+  // Bump whenever the parser produces a different AST for the same text,
+  // it keys the parse cache
+  static const uint32_t parser_version = 1;
+
   class token_stream {
   protected:
     const std::vector<token>& toks;
     int i;
+    diagnostic_engine* diags;
+    expression_interner* interner;
+    parse_stats* stats;
+
+    // Nesting of the statement and expression parsers
+    int depth;
+    int max_depth;
 
   public:
-    token_stream(const std::vector<token>& toks_) : toks(toks_), i(0) {}
+    token_stream(const std::vector<token>& toks_) :
+      toks(toks_), i(0), diags(nullptr), interner(nullptr), stats(nullptr),
+      depth(0), max_depth(0) {}
+
+    token_stream(const std::vector<token>& toks_,
+                 diagnostic_engine& diags_) :
+      toks(toks_), i(0), diags(&diags_), interner(nullptr), stats(nullptr),
+      depth(0), max_depth(0) {}
+
+    // Expressions parsed from this stream are hash-consed in interner
+    void set_interner(expression_interner* interner_) {
+      interner = interner_;
+    }
+
+    // parse_module on this stream adds its parse phase and node counts
+    // to stats
+    void set_stats(parse_stats* stats_) {
+      stats = stats_;
+    }
+
+    parse_stats* get_stats() const { return stats; }
+
+    expression* intern(expression* expr) const {
+      if (stats != nullptr) {
+        stats->expressions[expr->get_type()]++;
+        stats->ast_bytes += expression_node_bytes(expr);
+      }
+      return interner == nullptr ? expr : interner->intern(expr);
+    }
+
+    void enter() {
+      depth++;
+      max_depth = depth > max_depth ? depth : max_depth;
+    }
+
+    void leave() { depth--; }
+
+    int get_max_depth() const { return max_depth; }
+
+    int size() const { return toks.size(); }
 
     bool chars_left() const {
-      return toks.size() - i > 0;
+      return i < ((int) toks.size());
     }
 
     int index() const { return i; }
 
+    void seek(const int ind) { i = ind; }
+
     token_stream operator++(int) {
 
       i++;
@@ -30,8 +90,9 @@ namespace vparser {
 
     std::string remaining_string() const {
       std::string rem = "";
-      for (int ind = i; ind < toks.size(); ind++) {
-        rem += toks[ind].get_text() + " ";
+      for (unsigned ind = i; ind < toks.size(); ind++) {
+        rem += toks[ind].get_text();
+        rem += ' ';
       }
       return rem;
     }
@@ -41,19 +102,110 @@ namespace vparser {
       return *this;
     }
 
-    std::string next() const { return toks[i].get_text(); }
+    // Past the end of the stream next() is the empty string, so error
+    // recovery can run off the end safely. The reference stays valid for
+    // the life of the token vector.
+    const std::string& next() const {
+      return chars_left() ? toks[i].get_text() : end_text();
+    }
+
+    const std::string& next(const int off) const {
+      return (i + off < ((int) toks.size())) ? toks[i + off].get_text() : end_text();
+    }
+
+    static const std::string& end_text() {
+      static const std::string empty = "";
+      return empty;
+    }
+
+    source_position pos() const;
+
+    // The tokens around the current one, bounded so that error reporting
+    // stays cheap on large inputs
+    std::string context() const;
 
-    std::string next(const int off) const { return toks[i + off].get_text(); }
+    // Records msg and throws parse_error. Streams without a
+    // diagnostic_engine print msg and abort.
+    [[noreturn]] void error(const std::string& msg) const;
+
+    // Skips to just past the next `;`, or to the next `end` or
+    // `endmodule`, always making progress past stmt_start
+    void recover(const int stmt_start);
     
   };
 
   void parse_token(const std::string& str, token_stream& ts);
 
+  // The unparsed body of a module: its tokens [start, end), where end is
+  // the index of endmodule
+  class lazy_module_body {
+  public:
+    std::vector<token> toks;
+    int start;
+    int end;
+
+    // Body errors go here when the module was parsed with a
+    // diagnostic_engine, otherwise they abort like parse_module
+    bool collect_errors;
+    diagnostic_engine diags;
+
+    std::once_flag parse_once;
+    std::atomic<bool> parsed;
+
+    lazy_module_body(std::vector<token>&& toks_,
+                     const int start_,
+                     const int end_,
+                     const bool collect_errors_) :
+      toks(std::move(toks_)), start(start_), end(end_),
+      collect_errors(collect_errors_), parsed(false) {}
+  };
+
+  // The names of a list of port declarations, without copying them
+  class port_name_range {
+    const std::vector<decl_stmt*>& ports;
+
+  public:
+
+    class iterator {
+      std::vector<decl_stmt*>::const_iterator it;
+
+    public:
+
+      iterator(std::vector<decl_stmt*>::const_iterator it_) : it(it_) {}
+
+      const std::string& operator*() const { return (*it)->get_name(); }
+
+      iterator& operator++() {
+        ++it;
+        return *this;
+      }
+
+      bool operator!=(const iterator& other) const { return it != other.it; }
+    };
+
+    port_name_range(const std::vector<decl_stmt*>& ports_) : ports(ports_) {}
+
+    iterator begin() const { return iterator(ports.begin()); }
+    iterator end() const { return iterator(ports.end()); }
+
+    int size() const { return ports.size(); }
+
+    const std::string& operator[](const int i) const {
+      return ports[i]->get_name();
+    }
+  };
+
   class verilog_module {
 
     std::string name;
     std::vector<decl_stmt*> ports;
-    std::vector<statement*> statements;
+    mutable std::vector<statement*> statements;
+
+    // Set for modules from parse_module_lazy, the body is parsed into
+    // statements on the first call to get_statements
+    std::unique_ptr<lazy_module_body> body;
+
+    void parse_body() const;
 
   public:
 
@@ -65,16 +217,39 @@ namespace vparser {
       }
     }
 
-    verilog_module(const std::string& name,
-                   //const std::vector<std::string>& port_names_,
-                   const std::vector<decl_stmt*>& ports_,
-                   const std::vector<statement*>& statements_) :
-      name(name), ports(ports_), statements(statements_) {}
+    verilog_module(verilog_module&& other) :
+      name(std::move(other.name)),
+      ports(std::move(other.ports)),
+      statements(std::move(other.statements)),
+      body(std::move(other.body)) {
+      other.statements.clear();
+    }
+
+    verilog_module(std::string name_,
+                   std::vector<decl_stmt*> ports_,
+                   std::vector<statement*> statements_) :
+      name(std::move(name_)),
+      ports(std::move(ports_)),
+      statements(std::move(statements_)) {}
 
-    std::string get_name() const {
+    verilog_module(std::string name_,
+                   std::vector<decl_stmt*> ports_,
+                   std::unique_ptr<lazy_module_body> body_) :
+      name(std::move(name_)), ports(std::move(ports_)), body(std::move(body_)) {}
+
+    const std::string& get_name() const {
       return name;
     }
 
+    const std::vector<decl_stmt*>& get_ports() const {
+      return ports;
+    }
+
+    port_name_range port_names() const {
+      return port_name_range(ports);
+    }
+
+    // Copies the names, port_names() iterates over them in place
     std::vector<std::string> get_port_names() const {
       std::vector<std::string> port_names;
       for (auto& port : ports) {
@@ -83,31 +258,44 @@ namespace vparser {
       return port_names;
     }
 
-    std::string to_string() {
-      std::string str = "module " + name + "(\n";
-
-      auto ports = get_port_names();
-      for (int i = 0; i < ports.size(); i++) {
-        str += indent(1) + ports[i];
+    std::string to_string() const {
+      output_buffer out;
+      ast_printer(out).print(*this);
+      return out.str();
+    }
 
-        if (i < ports.size() - 1) {
-          str += ",\n";
-        }
-      }
+    // Streams the module text without holding all of it in memory
+    void print(std::ostream& out) const {
+      output_buffer buf(out);
+      ast_printer(buf).print(*this);
+    }
 
-      str += ");\n\n";
+    const std::vector<statement*>&
+    get_statements() const {
+      parse_body();
+      return statements;
+    }
 
-      for (auto& stmt : get_statements()) {
-        str += stmt->to_string(1) + "\n";
+    // Replaces statement i, deleting the old one if it is not reused
+    void set_statement(const int i, statement* stmt) {
+      parse_body();
+      if (statements[i] != stmt) {
+        delete statements[i];
+        statements[i] = stmt;
       }
+    }
 
-      str += "\nendmodule";
-      return str;
+    void set_port(const int i, decl_stmt* port) {
+      ports[i] = port;
     }
 
-    std::vector<statement*>
-    get_statements() const {
-      return statements;
+    bool body_parsed() const {
+      return body == nullptr || body->parsed;
+    }
+
+    // Errors found while parsing a lazy body, empty for eager modules
+    const diagnostic_engine* get_body_diagnostics() const {
+      return body == nullptr ? nullptr : &(body->diags);
     }
   };
 
@@ -116,6 +304,45 @@ namespace vparser {
   statement* parse_statement(const std::string& stmt_string);
   expression* parse_expression(const std::string& stmt_string);
 
+  // Non-aborting versions: errors are recorded in diags. parse_module
+  // skips statements it cannot parse and returns the rest, the others
+  // return nullptr on error.
+  verilog_module parse_module(const std::string& mod_string,
+                              diagnostic_engine& diags);
+
+  // Parses only the module header (parameters and ports), the body is
+  // kept as a token range and parsed on the first get_statements call.
+  verilog_module parse_module_lazy(const std::string& mod_string);
+
+  verilog_module parse_module_lazy(const std::string& mod_string,
+                                   diagnostic_engine& diags);
+
+  statement* parse_statement(const std::string& stmt_string,
+                             diagnostic_engine& diags);
+  expression* parse_expression(const std::string& stmt_string,
+                               diagnostic_engine& diags);
+
+  // Hash-consing versions: every expression in the result is interned
+  // in interner, so identical subexpressions are shared. The interner
+  // owns the expressions and must outlive the result.
+  verilog_module parse_module(const std::string& mod_string,
+                              expression_interner& interner);
+
+  statement* parse_statement(const std::string& stmt_string,
+                             expression_interner& interner);
+  expression* parse_expression(const std::string& stmt_string,
+                               expression_interner& interner);
+
+  // Record each phase in stats, see parse_stats. The first adds a
+  // tokenize and a parse phase, parse_module(token_stream&) records
+  // the parse phase when the stream has stats.
+  verilog_module parse_module(const std::string& mod_string,
+                              parse_stats& stats);
+  verilog_module parse_module(const std::string& mod_string,
+                              diagnostic_engine& diags,
+                              parse_stats& stats);
+
+  verilog_module parse_module(token_stream& ts);
   expression* parse_expression(token_stream& ts);
 
 }
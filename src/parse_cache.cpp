@@ -0,0 +1,67 @@
+#include "parse_cache.h"
+
+#include "diagnostics.h"
+#include "flat_ast.h"
+#include "hash.h"
+#include "macro_def.h"
+#include "parse.h"
+
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace vparser {
+
+  uint64_t parse_cache_key(const std::string& verilog_text) {
+    return hash64::combine(hash64::hash(verilog_text, parser_version),
+                           ast_file_version);
+  }
+
+  bool parse_cache::parse(const std::string& verilog_text, mapped_ast& ast) {
+    uint64_t key = parse_cache_key(verilog_text);
+
+    if (ast.open(files.path_for(key))) {
+      hits++;
+      files.touch(key);
+      return true;
+    }
+
+    misses++;
+
+    diagnostic_engine diags;
+    verilog_module vm =
+      parse_module(preprocess_code(verilog_text).text, diags);
+    if (diags.has_errors()) {
+      return false;
+    }
+
+    flat_ast flat;
+    flat.add_module(vm);
+    string contents = serialize_flat_ast(flat.view());
+
+    files.store(key, contents);
+    if (max_bytes > 0) {
+      files.evict(max_bytes);
+    }
+
+    // Loaded from memory, the entry may already be evicted or replaced
+    return ast.load(contents);
+  }
+
+  bool parse_cache::parse_file(const std::string& path, mapped_ast& ast) {
+    ifstream in(path, ios::in | ios::binary);
+    if (!in) {
+      return false;
+    }
+
+    stringstream ss;
+    ss << in.rdbuf();
+    return parse(ss.str(), ast);
+  }
+
+  std::string parse_cache::entry_path(const std::string& verilog_text) const {
+    return files.path_for(parse_cache_key(verilog_text));
+  }
+
+}
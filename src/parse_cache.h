@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "ast_file.h"
+#include "file_cache.h"
+
+namespace vparser {
+
+  // On-disk cache of whole-file parses. Entries are binary AST files
+  // keyed by a hash of the unpreprocessed text, parser_version and
+  // ast_file_version, so a hit is one mmap with no preprocessing or
+  // parsing. Any number of processes may share the directory: entries
+  // are renamed into place complete, and a corrupt or vanished entry is
+  // just a miss: entries carry a hash of their contents, checked on every
+  // hit.
+  //
+  // With a nonzero max_bytes, every store evicts the least recently
+  // used entries (by file mtime, which a hit updates) until the
+  // directory fits.
+  class parse_cache {
+    file_cache files;
+    uint64_t max_bytes;
+    std::atomic<int> hits;
+    std::atomic<int> misses;
+
+  public:
+
+    parse_cache(const std::string& dir, const uint64_t max_bytes_ = 0) :
+      files(dir, ".vast"), max_bytes(max_bytes_), hits(0), misses(0) {}
+
+    // Preprocesses and parses verilog_text into ast on a miss. False if
+    // the text has parse errors, which are not cached.
+    bool parse(const std::string& verilog_text, mapped_ast& ast);
+
+    bool parse_file(const std::string& path, mapped_ast& ast);
+
+    std::string entry_path(const std::string& verilog_text) const;
+
+    uint64_t size_bytes() const { return files.total_bytes(); }
+
+    int num_hits() const { return hits; }
+    int num_misses() const { return misses; }
+
+    // Fraction of lookups that were hits, 0 before the first lookup
+    double hit_rate() const {
+      int h = hits;
+      int lookups = h + misses;
+      return lookups == 0 ? 0.0 : ((double) h) / lookups;
+    }
+  };
+
+  uint64_t parse_cache_key(const std::string& verilog_text);
+
+}
@@ -0,0 +1,183 @@
+#include "parse_stats.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <sstream>
+
+#include <time.h>
+
+using namespace std;
+
+namespace vparser {
+
+  void phase_stats::add(const phase_stats& other) {
+    calls += other.calls;
+    wall_ns += other.wall_ns;
+    cpu_ns += other.cpu_ns;
+    bytes += other.bytes;
+    tokens += other.tokens;
+  }
+
+  void parse_stats::clear() {
+    preprocess = phase_stats();
+    tokenize = phase_stats();
+    parse = phase_stats();
+    fill(expressions, expressions + num_expression_types, 0);
+    fill(statements, statements + num_statement_types, 0);
+    ast_bytes = 0;
+    macro_expansions = 0;
+    max_depth = 0;
+  }
+
+  void parse_stats::add(const parse_stats& other) {
+    preprocess.add(other.preprocess);
+    tokenize.add(other.tokenize);
+    parse.add(other.parse);
+    for (int i = 0; i < num_expression_types; i++) {
+      expressions[i] += other.expressions[i];
+    }
+    for (int i = 0; i < num_statement_types; i++) {
+      statements[i] += other.statements[i];
+    }
+    ast_bytes += other.ast_bytes;
+    macro_expansions += other.macro_expansions;
+    max_depth = max(max_depth, other.max_depth);
+  }
+
+  uint64_t parse_stats::num_expressions() const {
+    uint64_t n = 0;
+    for (auto count : expressions) {
+      n += count;
+    }
+    return n;
+  }
+
+  uint64_t parse_stats::num_statements() const {
+    uint64_t n = 0;
+    for (auto count : statements) {
+      n += count;
+    }
+    return n;
+  }
+
+  void phase_json(ostream& out, const string& name, const phase_stats& phase) {
+    out << "  \"" << name << "\": {\"calls\": " << phase.calls
+        << ", \"wall_ns\": " << phase.wall_ns
+        << ", \"cpu_ns\": " << phase.cpu_ns
+        << ", \"bytes\": " << phase.bytes
+        << ", \"tokens\": " << phase.tokens << "},\n";
+  }
+
+  std::string parse_stats::to_json() const {
+    ostringstream out;
+    out << "{\n";
+    phase_json(out, "preprocess", preprocess);
+    phase_json(out, "tokenize", tokenize);
+    phase_json(out, "parse", parse);
+
+    out << "  \"expressions\": {";
+    for (int i = 0; i < num_expression_types; i++) {
+      out << (i == 0 ? "" : ", ")
+          << "\"" << expression_type_name((expression_type) i) << "\": "
+          << expressions[i];
+    }
+    out << "},\n";
+
+    out << "  \"statements\": {";
+    for (int i = 0; i < num_statement_types; i++) {
+      out << (i == 0 ? "" : ", ")
+          << "\"" << statement_type_name((statement_type) i) << "\": "
+          << statements[i];
+    }
+    out << "},\n";
+
+    out << "  \"ast_bytes\": " << ast_bytes << ",\n";
+    out << "  \"macro_expansions\": " << macro_expansions << ",\n";
+    out << "  \"max_depth\": " << max_depth << "\n";
+    out << "}\n";
+    return out.str();
+  }
+
+  uint64_t thread_cpu_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ((uint64_t) ts.tv_sec)*1000000000ull + ts.tv_nsec;
+  }
+
+  uint64_t wall_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  phase_timer::phase_timer(phase_stats* phase_) :
+    phase(phase_), wall_start(0), cpu_start(0) {
+    if (phase != nullptr) {
+      wall_start = wall_ns();
+      cpu_start = thread_cpu_ns();
+    }
+  }
+
+  phase_timer::~phase_timer() {
+    if (phase != nullptr) {
+      phase->cpu_ns += thread_cpu_ns() - cpu_start;
+      phase->wall_ns += wall_ns() - wall_start;
+      phase->calls++;
+    }
+  }
+
+  const char* expression_type_name(const expression_type type) {
+    switch (type) {
+    case EXPRESSION_ID:
+      return "id";
+    case EXPRESSION_NUM:
+      return "num";
+    case EXPRESSION_SLICE:
+      return "slice";
+    case EXPRESSION_STRING_LITERAL:
+      return "string_literal";
+    case EXPRESSION_UNOP:
+      return "unop";
+    case EXPRESSION_BINOP:
+      return "binop";
+    case EXPRESSION_TRINOP:
+      return "trinop";
+    case EXPRESSION_CONCAT:
+      return "concat";
+    case EXPRESSION_FLOAT:
+      return "float";
+    }
+    assert(false);
+    return "";
+  }
+
+  const char* statement_type_name(const statement_type type) {
+    switch (type) {
+    case STATEMENT_DECL:
+      return "decl";
+    case STATEMENT_ALWAYS:
+      return "always";
+    case STATEMENT_BEGIN:
+      return "begin";
+    case STATEMENT_IF:
+      return "if";
+    case STATEMENT_ASSIGN:
+      return "assign";
+    case STATEMENT_CASE:
+      return "case";
+    case STATEMENT_EMPTY:
+      return "empty";
+    case STATEMENT_MODULE_INSTANTIATION:
+      return "module_instantiation";
+    case STATEMENT_BLOCKING_ASSIGN:
+      return "blocking_assign";
+    case STATEMENT_NON_BLOCKING_ASSIGN:
+      return "non_blocking_assign";
+    case STATEMENT_CALL:
+      return "call";
+    }
+    assert(false);
+    return "";
+  }
+
+}
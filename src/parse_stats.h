@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "expression.h"
+#include "statement.h"
+
+namespace vparser {
+
+  static const int num_expression_types = EXPRESSION_FLOAT + 1;
+  static const int num_statement_types = STATEMENT_CALL + 1;
+
+  // Time and work for one phase, summed over every call that recorded it
+  class phase_stats {
+  public:
+    int calls;
+    uint64_t wall_ns;
+    uint64_t cpu_ns;
+    uint64_t bytes;
+    uint64_t tokens;
+
+    phase_stats() : calls(0), wall_ns(0), cpu_ns(0), bytes(0), tokens(0) {}
+
+    void add(const phase_stats& other);
+  };
+
+  // Filled in by the overloads of preprocess_code, tokenize and
+  // parse_module that take one. Each call adds to what is already
+  // there, so one object can follow a file through every phase or sum
+  // over many files. Recording costs two clock reads per phase and a
+  // counter increment per node.
+  class parse_stats {
+  public:
+    phase_stats preprocess;
+    phase_stats tokenize;
+    phase_stats parse;
+
+    // Nodes created by the parser, by get_type(). With an interner this
+    // counts every node passed to intern, including the duplicates it
+    // deletes.
+    uint64_t expressions[num_expression_types];
+    uint64_t statements[num_statement_types];
+
+    // Bytes of the nodes above, see expression_node_bytes
+    uint64_t ast_bytes;
+
+    uint64_t macro_expansions;
+
+    // Deepest nesting of statement and expression parser calls
+    int max_depth;
+
+    parse_stats() { clear(); }
+
+    void clear();
+
+    void add(const parse_stats& other);
+
+    uint64_t num_expressions() const;
+    uint64_t num_statements() const;
+
+    std::string to_json() const;
+  };
+
+  // CPU time used by the calling thread, not counting time it spent
+  // descheduled
+  uint64_t thread_cpu_ns();
+
+  // Records the wall and thread CPU time from construction to
+  // destruction in a phase, a null phase records nothing
+  class phase_timer {
+    phase_stats* phase;
+    uint64_t wall_start;
+    uint64_t cpu_start;
+
+  public:
+    phase_timer(phase_stats* phase_);
+    ~phase_timer();
+
+    phase_timer(const phase_timer&) = delete;
+    phase_timer& operator=(const phase_timer&) = delete;
+  };
+
+  const char* expression_type_name(const expression_type type);
+  const char* statement_type_name(const statement_type type);
+
+}
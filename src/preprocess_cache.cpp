@@ -0,0 +1,234 @@
+#include "preprocess_cache.h"
+
+#include "hash.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace vparser {
+
+  // Bump whenever preprocess_code output or the entry layout changes
+  static const uint32_t preprocess_cache_version = 1;
+
+  static const char preprocess_cache_magic[4] = {'V', 'P', 'P', 'C'};
+
+  class entry_writer {
+    std::string buf;
+
+  public:
+
+    void put_int(const int32_t v) {
+      buf.append((const char*) &v, sizeof(v));
+    }
+
+    void put_string(const std::string& str) {
+      put_int(str.size());
+      buf += str;
+    }
+
+    void put_strings(const std::vector<std::string>& strs) {
+      put_int(strs.size());
+      for (auto& str : strs) {
+        put_string(str);
+      }
+    }
+
+    void put_pos(const source_position& pos) {
+      put_int(pos.lineNo);
+      put_int(pos.linePos);
+    }
+
+    void put_raw(const char* data, const size_t len) {
+      buf.append(data, len);
+    }
+
+    const std::string& contents() const { return buf; }
+  };
+
+  // Reads entries back, failing instead of reading past the end so a
+  // truncated or foreign file is treated as a miss
+  class entry_reader {
+    const std::string& buf;
+    size_t i;
+    bool ok;
+
+  public:
+
+    entry_reader(const std::string& buf_) : buf(buf_), i(0), ok(true) {}
+
+    bool good() const { return ok; }
+
+    bool at_end() const { return i == buf.size(); }
+
+    int32_t get_int() {
+      int32_t v = 0;
+      if (!ok || (buf.size() - i < sizeof(v))) {
+        ok = false;
+        return 0;
+      }
+      memcpy(&v, buf.data() + i, sizeof(v));
+      i += sizeof(v);
+      return v;
+    }
+
+    std::string get_string() {
+      int32_t len = get_int();
+      if (!ok || (len < 0) || (buf.size() - i < ((size_t) len))) {
+        ok = false;
+        return "";
+      }
+      std::string str = buf.substr(i, len);
+      i += len;
+      return str;
+    }
+
+    std::vector<std::string> get_strings() {
+      int32_t len = get_int();
+      std::vector<std::string> strs;
+      for (int32_t j = 0; ok && (j < len); j++) {
+        strs.push_back(get_string());
+      }
+      return strs;
+    }
+
+    source_position get_pos() {
+      int line_no = get_int();
+      int line_pos = get_int();
+      return source_position(line_no, line_pos);
+    }
+
+    bool get_raw(char* data, const size_t len) {
+      if (!ok || (buf.size() - i < len)) {
+        ok = false;
+        return false;
+      }
+      memcpy(data, buf.data() + i, len);
+      i += len;
+      return true;
+    }
+  };
+
+  uint64_t preprocess_key(const std::string& verilog_text) {
+    return hash64::hash(verilog_text, preprocess_cache_version);
+  }
+
+  std::string serialize_preprocessed(const preprocessed_verilog& prep) {
+    entry_writer out;
+    out.put_raw(preprocess_cache_magic, sizeof(preprocess_cache_magic));
+    out.put_int(preprocess_cache_version);
+
+    out.put_int(prep.defs.size());
+    for (auto& def : prep.defs) {
+      out.put_string(def.get_name());
+      out.put_strings(def.get_arg_names());
+      out.put_strings(def.get_body());
+      out.put_pos(def.get_def_pos());
+    }
+
+    out.put_string(prep.text);
+    out.put_string(prep.source);
+
+    auto& exps = prep.map.get_expansions();
+    out.put_int(exps.size());
+    for (auto& exp : exps) {
+      out.put_int(exp.macro);
+      out.put_int(exp.first_token);
+      out.put_int(exp.num_tokens);
+      out.put_int(exp.source_token);
+      out.put_int(exp.num_source_tokens);
+      out.put_pos(exp.use_pos);
+    }
+
+    return out.contents();
+  }
+
+  bool deserialize_preprocessed(const std::string& data,
+                                preprocessed_verilog& prep) {
+    entry_reader in(data);
+
+    char magic[sizeof(preprocess_cache_magic)];
+    if (!in.get_raw(magic, sizeof(magic)) ||
+        (memcmp(magic, preprocess_cache_magic, sizeof(magic)) != 0)) {
+      return false;
+    }
+
+    if (in.get_int() != ((int32_t) preprocess_cache_version)) {
+      return false;
+    }
+
+    preprocessed_verilog res;
+
+    int num_defs = in.get_int();
+    for (int i = 0; in.good() && (i < num_defs); i++) {
+      string name = in.get_string();
+      vector<string> arg_names = in.get_strings();
+      vector<string> body = in.get_strings();
+      source_position def_pos = in.get_pos();
+      res.defs.push_back(macro_def(name, arg_names, body, def_pos));
+    }
+
+    res.text = in.get_string();
+    res.source = in.get_string();
+
+    int num_exps = in.get_int();
+    for (int i = 0; in.good() && (i < num_exps); i++) {
+      macro_expansion exp;
+      exp.macro = in.get_int();
+      exp.first_token = in.get_int();
+      exp.num_tokens = in.get_int();
+      exp.source_token = in.get_int();
+      exp.num_source_tokens = in.get_int();
+      exp.use_pos = in.get_pos();
+      res.map.add_expansion(exp);
+    }
+
+    if (!in.good() || !in.at_end()) {
+      return false;
+    }
+
+    prep = res;
+    return true;
+  }
+
+  preprocessed_verilog
+  preprocess_cache::preprocess(const std::string& verilog_text) {
+    preprocessed_verilog prep;
+    if (lookup(verilog_text, prep)) {
+      return prep;
+    }
+
+    prep = preprocess_code(verilog_text);
+    store(verilog_text, prep);
+    return prep;
+  }
+
+  bool preprocess_cache::lookup(const std::string& verilog_text,
+                                preprocessed_verilog& prep) {
+    string data;
+    if (files.load(preprocess_key(verilog_text), data) &&
+        deserialize_preprocessed(data, prep)) {
+      hits++;
+      return true;
+    }
+
+    misses++;
+    return false;
+  }
+
+  void preprocess_cache::store(const std::string& verilog_text,
+                               const preprocessed_verilog& prep) {
+    files.store(preprocess_key(verilog_text), serialize_preprocessed(prep));
+  }
+
+  std::string
+  preprocess_cache::entry_path(const std::string& verilog_text) const {
+    return files.path_for(preprocess_key(verilog_text));
+  }
+
+  preprocessed_verilog preprocess_code(const std::string& verilog_text,
+                                       preprocess_cache& cache) {
+    return cache.preprocess(verilog_text);
+  }
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "file_cache.h"
+#include "macro_def.h"
+
+namespace vparser {
+
+  // On-disk cache of preprocess_code results keyed by a hash of the
+  // input. preprocess_code has no include search path and no predefined
+  // macros, so the text alone determines the macro environment and the
+  // output. Threads may share one cache.
+  class preprocess_cache {
+    file_cache files;
+    std::atomic<int> hits;
+    std::atomic<int> misses;
+
+  public:
+
+    preprocess_cache(const std::string& dir) :
+      files(dir, ".vpp"), hits(0), misses(0) {}
+
+    preprocessed_verilog preprocess(const std::string& verilog_text);
+
+    // The two halves of preprocess, for callers that time them
+    // separately. lookup counts a hit or a miss.
+    bool lookup(const std::string& verilog_text, preprocessed_verilog& prep);
+    void store(const std::string& verilog_text, const preprocessed_verilog& prep);
+
+    std::string entry_path(const std::string& verilog_text) const;
+
+    int num_hits() const { return hits; }
+    int num_misses() const { return misses; }
+  };
+
+  uint64_t preprocess_key(const std::string& verilog_text);
+
+  std::string serialize_preprocessed(const preprocessed_verilog& prep);
+
+  bool deserialize_preprocessed(const std::string& data,
+                                preprocessed_verilog& prep);
+
+  preprocessed_verilog preprocess_code(const std::string& verilog_text,
+                                       preprocess_cache& cache);
+
+}
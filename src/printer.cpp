@@ -0,0 +1,380 @@
+#include "printer.h"
+
+#include "parse.h"
+
+#include <cstdio>
+
+using namespace std;
+
+namespace vparser {
+
+  static const char indent_spaces[] =
+    "                                                                ";
+
+  static const char* signal_edge_spelling(const signal_edge edge) {
+    switch (edge) {
+    case SIGNAL_POSEDGE:
+      return "posedge";
+
+    case SIGNAL_NEGEDGE:
+      return "negedge";
+
+    case SIGNAL_STAR:
+      return "*";
+
+    default:
+      assert(false);
+      return "";
+    }
+  }
+
+  void ast_printer::indent(const int lvl) {
+    size_t len = 2*lvl;
+    while (len > 0) {
+      size_t chunk = min(len, sizeof(indent_spaces) - 1);
+      out.append(indent_spaces, chunk);
+      len -= chunk;
+    }
+  }
+
+  // snprintf costs more than printing the rest of a typical number
+  void ast_printer::append_int(const int val) {
+    char digits[12];
+    char* end = digits + sizeof(digits);
+    char* p = end;
+
+    unsigned v = val < 0 ? -((unsigned) val) : val;
+    do {
+      *--p = '0' + (v % 10);
+      v /= 10;
+    } while (v != 0);
+
+    if (val < 0) {
+      *--p = '-';
+    }
+
+    out.append(p, end - p);
+  }
+
+  void ast_printer::print_at(const statement* stmt, const int lvl) {
+    int old_level = level;
+    level = lvl;
+    print(stmt);
+    level = old_level;
+  }
+
+  void ast_printer::print(const expression* expr) {
+    switch (expr->get_type()) {
+    case EXPRESSION_ID:
+      out.append(static_cast<const id_expr*>(expr)->get_name());
+      break;
+
+    case EXPRESSION_NUM: {
+      auto e = static_cast<const num_expr*>(expr);
+      append_int(e->get_size());
+      out.put('\'');
+      out.put(e->get_radix());
+      out.append(e->get_value());
+      break;
+    }
+
+    case EXPRESSION_FLOAT: {
+      // Same format as std::to_string(double)
+      char val[512];
+      int len = snprintf(val, sizeof(val), "%f",
+                         static_cast<const float_expr*>(expr)->get_value());
+      out.append(val, len);
+      break;
+    }
+
+    case EXPRESSION_STRING_LITERAL:
+      out.append(static_cast<const string_literal_expr*>(expr)->get_value());
+      break;
+
+    case EXPRESSION_SLICE: {
+      auto e = static_cast<const slice_expr*>(expr);
+      out.put('(');
+      print(e->get_arg());
+      out.append("[ ", 2);
+      print(e->get_start());
+      out.append(" : ", 3);
+      print(e->get_end());
+      out.append(" ])", 3);
+      break;
+    }
+
+    case EXPRESSION_UNOP: {
+      auto e = static_cast<const unop_expr*>(expr);
+      out.put('(');
+      out.append(get_op_info(e->get_op()).spelling);
+      out.put(' ');
+      print(e->get_op0());
+      out.put(')');
+      break;
+    }
+
+    case EXPRESSION_BINOP: {
+      auto e = static_cast<const binop_expr*>(expr);
+      out.put('(');
+      print(e->get_op0());
+      out.put(' ');
+      out.append(get_op_info(e->get_op()).spelling);
+      out.put(' ');
+      print(e->get_op1());
+      out.put(')');
+      break;
+    }
+
+    case EXPRESSION_TRINOP: {
+      auto e = static_cast<const trinop_expr*>(expr);
+      assert(e->get_op() == OP_CONDITIONAL);
+
+      out.put('(');
+      print(e->get_op0());
+      out.append(" ? ", 3);
+      print(e->get_op1());
+      out.append(" : ", 3);
+      print(e->get_op2());
+      out.put(')');
+      break;
+    }
+
+    case EXPRESSION_CONCAT: {
+      auto& exprs = static_cast<const concat_expr*>(expr)->get_exprs();
+      out.append("{ ", 2);
+      for (unsigned i = 0; i < exprs.size(); i++) {
+        if (i > 0) {
+          out.append(", ", 2);
+        }
+        print(exprs[i]);
+      }
+      out.append(" }", 2);
+      break;
+    }
+
+    default:
+      assert(false);
+    }
+  }
+
+  void ast_printer::print(const statement* stmt) {
+    switch (stmt->get_type()) {
+    case STATEMENT_DECL: {
+      auto s = static_cast<const decl_stmt*>(stmt);
+      indent(level);
+      out.append(s->get_category());
+      out.put(' ');
+
+      if ((s->get_width_end() != nullptr) &&
+          (s->get_width_start() != nullptr)) {
+        out.append("[ ", 2);
+        print(s->get_width_end());
+        out.append(" : ", 3);
+        print(s->get_width_start());
+        out.append(" ] ", 3);
+      }
+
+      out.append(s->get_storage_type());
+      out.put(' ');
+      out.append(s->get_name());
+      if (s->get_init_value() != nullptr) {
+        out.append(" = ", 3);
+        print(s->get_init_value());
+      }
+      out.put(';');
+      break;
+    }
+
+    case STATEMENT_ALWAYS: {
+      auto s = static_cast<const always_stmt*>(stmt);
+      indent(level);
+      out.append("always @(");
+
+      auto& sensitivity_list = s->get_sensitivity_list();
+      for (unsigned i = 0; i < sensitivity_list.size(); i++) {
+        if (i > 0) {
+          out.append(" or ", 4);
+        }
+        out.append(signal_edge_spelling(sensitivity_list[i].first));
+        out.put(' ');
+        out.append(sensitivity_list[i].second);
+      }
+      out.append(")\n", 2);
+      print_at(s->get_statement(), level + 1);
+      break;
+    }
+
+    case STATEMENT_IF: {
+      auto s = static_cast<const if_stmt*>(stmt);
+      indent(level);
+      out.append("if (", 4);
+      print(s->get_condition());
+      out.append(")\n", 2);
+      print_at(s->get_if_exe(), level + 1);
+
+      if (s->get_else_exe() != nullptr) {
+        indent(level);
+        out.append("else\n", 5);
+        print_at(s->get_else_exe(), level + 1);
+      }
+      break;
+    }
+
+    case STATEMENT_EMPTY:
+      break;
+
+    case STATEMENT_BEGIN: {
+      indent(level);
+      out.append("begin\n", 6);
+      for (auto sub : static_cast<const begin_stmt*>(stmt)->get_statements()) {
+        print_at(sub, level + 1);
+        out.put('\n');
+      }
+      out.put('\n');
+      indent(level);
+      out.append("end\n", 4);
+      break;
+    }
+
+    case STATEMENT_CASE: {
+      auto s = static_cast<const case_stmt*>(stmt);
+      indent(level);
+      out.append("case (CASE EXPR)\n");
+
+      for (auto& cs : s->get_cases()) {
+        indent(level + 1);
+        print(cs.first);
+        out.append(": ", 2);
+        print_at(cs.second, 0);
+        out.put('\n');
+      }
+
+      if (s->get_default() != nullptr) {
+        indent(level + 1);
+        out.append("default: ");
+        print_at(s->get_default(), 0);
+        out.put('\n');
+      }
+
+      out.put('\n');
+      indent(level);
+      out.append("endcase\n", 8);
+      break;
+    }
+
+    case STATEMENT_ASSIGN: {
+      auto s = static_cast<const assign_stmt*>(stmt);
+      indent(level);
+      out.append("assign ", 7);
+      print(s->get_lhs());
+      out.append(" = ", 3);
+      print(s->get_rhs());
+      out.put(';');
+      break;
+    }
+
+    case STATEMENT_BLOCKING_ASSIGN: {
+      auto s = static_cast<const blocking_assign_stmt*>(stmt);
+      indent(level);
+      print(s->get_lhs());
+      out.append(" = ", 3);
+      print(s->get_rhs());
+      out.put(';');
+      break;
+    }
+
+    case STATEMENT_NON_BLOCKING_ASSIGN: {
+      auto s = static_cast<const non_blocking_assign_stmt*>(stmt);
+      indent(level);
+      print(s->get_lhs());
+      out.append(" <= ", 4);
+      print(s->get_rhs());
+      out.put(';');
+      break;
+    }
+
+    case STATEMENT_CALL: {
+      auto s = static_cast<const call_stmt*>(stmt);
+      indent(level);
+      out.put('$');
+      out.append(s->get_name());
+      out.append("( ", 2);
+
+      auto& args = s->get_args();
+      for (unsigned i = 0; i < args.size(); i++) {
+        if (i > 0) {
+          out.append(", ", 2);
+        }
+        print(args[i]);
+      }
+      out.append(");", 2);
+      break;
+    }
+
+    case STATEMENT_MODULE_INSTANTIATION: {
+      auto s = static_cast<const module_instantiation_stmt*>(stmt);
+      indent(level);
+      out.append(s->get_module_type());
+      out.put(' ');
+      out.append(s->get_name());
+      out.put('(');
+
+      auto& ports = s->get_port_assignments();
+      for (unsigned i = 0; i < ports.size(); i++) {
+        if (i > 0) {
+          out.append(", ", 2);
+        }
+        out.put('.');
+        out.append(ports[i].first);
+        out.put('(');
+        print(ports[i].second);
+        out.put(')');
+      }
+      out.append(");", 2);
+      break;
+    }
+
+    default:
+      assert(false);
+    }
+  }
+
+  void ast_printer::print(const verilog_module& mod) {
+    out.append("module ", 7);
+    out.append(mod.get_name());
+    out.append("(\n", 2);
+
+    auto& ports = mod.get_ports();
+    for (unsigned i = 0; i < ports.size(); i++) {
+      if (i > 0) {
+        out.append(",\n", 2);
+      }
+      indent(1);
+      out.append(ports[i]->get_name());
+    }
+
+    out.append(");\n\n", 4);
+
+    for (auto stmt : mod.get_statements()) {
+      print_at(stmt, 1);
+      out.put('\n');
+    }
+
+    out.append("\nendmodule", 10);
+  }
+
+  std::string expression::to_string() const {
+    output_buffer out;
+    ast_printer(out).print(this);
+    return out.str();
+  }
+
+  std::string statement::to_string(const int indent_level) const {
+    output_buffer out;
+    ast_printer printer(out);
+    printer.set_level(indent_level);
+    printer.print(this);
+    return out.str();
+  }
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "statement.h"
+
+namespace vparser {
+
+  class verilog_module;
+
+  // A growable character buffer meant to be reused across prints, so
+  // after the first print it has the capacity it needs. With a sink the
+  // contents are written to the stream whenever they pass flush_bytes,
+  // so printing a large design never holds all of its text.
+  class output_buffer {
+    std::vector<char> buf;
+    size_t len;
+    std::ostream* sink;
+    size_t flush_bytes;
+
+    void grow(const size_t min_size) {
+      buf.resize(std::max(min_size, 2*buf.size() + 256));
+    }
+
+  public:
+
+    output_buffer() : len(0), sink(nullptr), flush_bytes(0) {}
+
+    output_buffer(std::ostream& sink_, const size_t flush_bytes_ = 1 << 16) :
+      buf(flush_bytes_), len(0), sink(&sink_), flush_bytes(flush_bytes_) {}
+
+    output_buffer(const output_buffer&) = delete;
+    output_buffer& operator=(const output_buffer&) = delete;
+
+    ~output_buffer() { flush(); }
+
+    void append(const char* str, const size_t n) {
+      if (buf.size() - len < n) {
+        grow(len + n);
+      }
+      memcpy(buf.data() + len, str, n);
+      len += n;
+
+      if ((sink != nullptr) && (len >= flush_bytes)) {
+        flush();
+      }
+    }
+
+    void append(const char* str) { append(str, strlen(str)); }
+
+    void append(const std::string& str) { append(str.data(), str.size()); }
+
+    void put(const char c) {
+      if (len == buf.size()) {
+        grow(len + 1);
+      }
+      buf[len++] = c;
+
+      if ((sink != nullptr) && (len >= flush_bytes)) {
+        flush();
+      }
+    }
+
+    // Writes the contents to the sink, if there is one
+    void flush() {
+      if ((sink != nullptr) && (len > 0)) {
+        sink->write(buf.data(), len);
+        len = 0;
+      }
+    }
+
+    // Empties the buffer but keeps its capacity
+    void clear() { len = 0; }
+
+    void reserve(const size_t bytes) {
+      if (bytes > buf.size()) {
+        grow(bytes);
+      }
+    }
+
+    size_t size() const { return len; }
+
+    // Contents not yet flushed to the sink
+    const char* data() const { return buf.data(); }
+
+    std::string str() const { return std::string(buf.data(), len); }
+  };
+
+  // Writes AST nodes in the to_string format without building any
+  // intermediate strings. The indentation is printer state: level is the
+  // depth of the statement being printed, nested statements are printed
+  // one level deeper and case items at level 0, as to_string always has.
+  // Indents are copied from a constant run of spaces.
+  class ast_printer {
+    output_buffer& out;
+    int level;
+
+    void indent(const int lvl);
+
+    void append_int(const int val);
+
+    void print_at(const statement* stmt, const int lvl);
+
+  public:
+
+    ast_printer(output_buffer& out_) : out(out_), level(0) {}
+
+    int get_level() const { return level; }
+
+    void set_level(const int level_) { level = level_; }
+
+    void print(const expression* expr);
+
+    // Printed at the current level
+    void print(const statement* stmt);
+
+    void print(const verilog_module& mod);
+  };
+
+}
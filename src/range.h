@@ -0,0 +1,323 @@
+#ifndef AFK_RANGE_H
+#define AFK_RANGE_H
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace afk {
+
+  // Lazy adaptors over containers and over each other. Nothing is
+  // computed or allocated until the result is iterated, e.g.
+  //
+  //   for (auto& s : view::map(view::filter(insts, is_sub), name)) ...
+  //
+  // Views hold iterators into the containers they adapt, so anything
+  // that invalidates those iterators invalidates the view, and copy the
+  // views they adapt, which are small. Each pass over a view calls its
+  // functions again.
+  namespace view {
+
+    class view_base {};
+
+    // A pair of iterators
+    template<typename It>
+    class range : public view_base {
+      It first;
+      It last;
+
+    public:
+      typedef It const_iterator;
+
+      range(It first_, It last_) : first(first_), last(last_) {}
+
+      It begin() const { return first; }
+      It end() const { return last; }
+
+      bool empty() const { return first == last; }
+    };
+
+    // The view adapted when an adaptor is given R: a view is copied, a
+    // container is referred to through its const_iterators
+    template<typename R, bool = std::is_base_of<view_base, R>::value>
+    class view_of {
+    public:
+      typedef R type;
+
+      static const R& get(const R& r) { return r; }
+    };
+
+    template<typename R>
+    class view_of<R, false> {
+    public:
+      typedef range<typename R::const_iterator> type;
+
+      static type get(const R& r) { return type(r.begin(), r.end()); }
+    };
+
+    template<typename V>
+    class view_traits {
+    public:
+      typedef typename V::const_iterator iterator;
+      typedef decltype(*std::declval<iterator>()) reference;
+      typedef typename std::decay<reference>::type value_type;
+    };
+
+    // f applied to each element as it is read
+    template<typename V, typename F>
+    class map_view : public view_base {
+      typedef typename view_traits<V>::iterator base_iterator;
+
+      V base;
+      F f;
+
+    public:
+      typedef typename std::decay<
+        decltype(std::declval<const F&>()(*std::declval<base_iterator>()))>::type
+        value_type;
+
+      class const_iterator {
+        base_iterator it;
+        const F* f;
+
+      public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef typename map_view::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef value_type reference;
+
+        const_iterator(base_iterator it_, const F* f_) : it(it_), f(f_) {}
+
+        value_type operator*() const { return (*f)(*it); }
+
+        const_iterator& operator++() {
+          ++it;
+          return *this;
+        }
+
+        const_iterator operator++(int) {
+          const_iterator prev = *this;
+          ++it;
+          return prev;
+        }
+
+        bool operator==(const const_iterator& other) const { return it == other.it; }
+        bool operator!=(const const_iterator& other) const { return it != other.it; }
+      };
+
+      map_view(const V& base_, F f_) : base(base_), f(f_) {}
+
+      const_iterator begin() const { return const_iterator(base.begin(), &f); }
+      const_iterator end() const { return const_iterator(base.end(), &f); }
+    };
+
+    // The elements p holds for, skipped over as the view is iterated
+    template<typename V, typename P>
+    class filter_view : public view_base {
+      typedef typename view_traits<V>::iterator base_iterator;
+
+      V base;
+      P p;
+
+    public:
+      typedef typename view_traits<V>::value_type value_type;
+
+      class const_iterator {
+        base_iterator it;
+        base_iterator last;
+        const P* p;
+
+        void skip() {
+          while ((it != last) && !(*p)(*it)) {
+            ++it;
+          }
+        }
+
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename filter_view::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef typename view_traits<V>::reference reference;
+
+        const_iterator(base_iterator it_, base_iterator last_, const P* p_) :
+          it(it_), last(last_), p(p_) {
+          skip();
+        }
+
+        reference operator*() const { return *it; }
+
+        const_iterator& operator++() {
+          ++it;
+          skip();
+          return *this;
+        }
+
+        const_iterator operator++(int) {
+          const_iterator prev = *this;
+          ++(*this);
+          return prev;
+        }
+
+        bool operator==(const const_iterator& other) const { return it == other.it; }
+        bool operator!=(const const_iterator& other) const { return it != other.it; }
+      };
+
+      filter_view(const V& base_, P p_) : base(base_), p(p_) {}
+
+      const_iterator begin() const {
+        return const_iterator(base.begin(), base.end(), &p);
+      }
+      const_iterator end() const {
+        return const_iterator(base.end(), base.end(), &p);
+      }
+    };
+
+    // Pairs of elements at the same position, as long as the shorter
+    // input
+    template<typename V1, typename V2>
+    class zip_view : public view_base {
+      typedef typename view_traits<V1>::iterator iterator1;
+      typedef typename view_traits<V2>::iterator iterator2;
+
+      V1 base1;
+      V2 base2;
+
+    public:
+      typedef std::pair<typename view_traits<V1>::reference,
+                        typename view_traits<V2>::reference> value_type;
+
+      class const_iterator {
+        iterator1 it1;
+        iterator2 it2;
+
+      public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef typename zip_view::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef value_type reference;
+
+        const_iterator(iterator1 it1_, iterator2 it2_) : it1(it1_), it2(it2_) {}
+
+        value_type operator*() const { return value_type(*it1, *it2); }
+
+        const_iterator& operator++() {
+          ++it1;
+          ++it2;
+          return *this;
+        }
+
+        const_iterator operator++(int) {
+          const_iterator prev = *this;
+          ++(*this);
+          return prev;
+        }
+
+        // Either input ending ends the zip
+        bool operator==(const const_iterator& other) const {
+          return (it1 == other.it1) || (it2 == other.it2);
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+      };
+
+      zip_view(const V1& base1_, const V2& base2_) : base1(base1_), base2(base2_) {}
+
+      const_iterator begin() const { return const_iterator(base1.begin(), base2.begin()); }
+      const_iterator end() const { return const_iterator(base1.end(), base2.end()); }
+    };
+
+    // (index, element) pairs
+    template<typename V>
+    class enumerate_view : public view_base {
+      typedef typename view_traits<V>::iterator base_iterator;
+
+      V base;
+
+    public:
+      typedef std::pair<std::size_t, typename view_traits<V>::reference> value_type;
+
+      class const_iterator {
+        base_iterator it;
+        std::size_t index;
+
+      public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef typename enumerate_view::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef value_type reference;
+
+        const_iterator(base_iterator it_, const std::size_t index_) :
+          it(it_), index(index_) {}
+
+        value_type operator*() const { return value_type(index, *it); }
+
+        const_iterator& operator++() {
+          ++it;
+          index++;
+          return *this;
+        }
+
+        const_iterator operator++(int) {
+          const_iterator prev = *this;
+          ++(*this);
+          return prev;
+        }
+
+        bool operator==(const const_iterator& other) const { return it == other.it; }
+        bool operator!=(const const_iterator& other) const { return it != other.it; }
+      };
+
+      enumerate_view(const V& base_) : base(base_) {}
+
+      const_iterator begin() const { return const_iterator(base.begin(), 0); }
+      const_iterator end() const { return const_iterator(base.end(), 0); }
+    };
+
+    template<typename R>
+    typename view_of<R>::type all(const R& r) {
+      return view_of<R>::get(r);
+    }
+
+    template<typename R, typename F>
+    map_view<typename view_of<R>::type, F> map(const R& r, F f) {
+      return map_view<typename view_of<R>::type, F>(all(r), f);
+    }
+
+    template<typename R, typename P>
+    filter_view<typename view_of<R>::type, P> filter(const R& r, P p) {
+      return filter_view<typename view_of<R>::type, P>(all(r), p);
+    }
+
+    template<typename R1, typename R2>
+    zip_view<typename view_of<R1>::type, typename view_of<R2>::type>
+    zip(const R1& r1, const R2& r2) {
+      return zip_view<typename view_of<R1>::type,
+                      typename view_of<R2>::type>(all(r1), all(r2));
+    }
+
+    template<typename R>
+    enumerate_view<typename view_of<R>::type> enumerate(const R& r) {
+      return enumerate_view<typename view_of<R>::type>(all(r));
+    }
+
+    // Evaluates a view, or copies a container
+    template<typename R>
+    std::vector<typename view_traits<typename view_of<R>::type>::value_type>
+    to_vector(const R& r) {
+      std::vector<typename view_traits<typename view_of<R>::type>::value_type> elems;
+      for (auto&& e : all(r)) {
+        elems.push_back(e);
+      }
+      return elems;
+    }
+
+  }
+
+}
+
+#endif
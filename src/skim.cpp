@@ -0,0 +1,250 @@
+#include "skim.h"
+
+#include "tokenize.h"
+
+#include <cctype>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+namespace vparser {
+
+  bool is_skim_keyword(const std::string& str) {
+    static const unordered_set<string> keywords{
+      "module", "endmodule", "input", "output", "inout", "wire", "reg",
+        "integer", "parameter", "localparam", "genvar", "assign", "always",
+        "initial", "begin", "end", "if", "else", "case", "casex", "casez",
+        "endcase", "default", "for", "while", "generate", "endgenerate",
+        "function", "endfunction", "task", "endtask", "posedge", "negedge",
+        "or", "and", "not", "signed", "supply0", "supply1"};
+
+    return keywords.find(str) != keywords.end();
+  }
+
+  bool is_skim_id(const std::string& str) {
+    return (str.size() > 0) &&
+      (isalpha(str[0]) || (str[0] == '_')) &&
+      !is_skim_keyword(str);
+  }
+
+  // Index just past the bracket that closes the one at toks[i]
+  int skip_balanced(const std::vector<token>& toks, int i) {
+    const string& open = toks[i].get_text();
+    const string close = open == "(" ? ")" : (open == "[" ? "]" : "}");
+
+    int depth = 0;
+    int n = toks.size();
+    for (; i < n; i++) {
+      const string& t = toks[i].get_text();
+      if (t == open) {
+        depth++;
+      } else if (t == close) {
+        depth--;
+        if (depth == 0) {
+          return i + 1;
+        }
+      }
+    }
+    return n;
+  }
+
+  int skip_to_semicolon(const std::vector<token>& toks, int i) {
+    int n = toks.size();
+    while ((i < n) && (toks[i].get_text() != ";")) {
+      i++;
+    }
+    return i < n ? i + 1 : n;
+  }
+
+  // Port names from the list starting at toks[i] == "(": the last
+  // identifier before each top level , or )
+  int skim_port_list(const std::vector<token>& toks,
+                     int i,
+                     std::vector<std::string>& port_names) {
+    int end = skip_balanced(toks, i);
+
+    int last_id = -1;
+    for (int j = i + 1; j < end; j++) {
+      const string& t = toks[j].get_text();
+      if ((t == "[") || (t == "(") || (t == "{")) {
+        j = skip_balanced(toks, j) - 1;
+      } else if ((t == ",") || (j == end - 1)) {
+        if (last_id >= 0) {
+          port_names.push_back(toks[last_id].get_text());
+        }
+        last_id = -1;
+      } else if (is_skim_id(t)) {
+        last_id = j;
+      }
+    }
+
+    return end;
+  }
+
+  // Named port connections from the list starting at toks[i] == "("
+  int skim_connections(const std::vector<token>& toks,
+                       int i,
+                       std::vector<std::string>& port_names) {
+    int end = skip_balanced(toks, i);
+
+    for (int j = i + 1; j < end - 1; j++) {
+      const string& t = toks[j].get_text();
+      if ((t == ".") && (j + 1 < end)) {
+        port_names.push_back(toks[j + 1].get_text());
+      } else if ((t == "(") || (t == "[") || (t == "{")) {
+        j = skip_balanced(toks, j) - 1;
+      }
+    }
+
+    return end;
+  }
+
+  void skim_hierarchy(const std::vector<token>& toks, hierarchy_graph& graph) {
+    int n = toks.size();
+    skim_module* current = nullptr;
+
+    int i = 0;
+    while (i < n) {
+      const string& t = toks[i].get_text();
+
+      if (t == "`") {
+        if ((i + 1 < n) && (toks[i + 1].get_text() == "define")) {
+          // Skip the rest of the define line
+          int line = toks[i].get_pos().lineNo;
+          while ((i < n) && (toks[i].get_pos().lineNo == line)) {
+            i++;
+          }
+        } else {
+          i += 2;
+        }
+      } else if (t == "module") {
+        graph.modules.push_back(skim_module());
+        current = &(graph.modules.back());
+
+        i++;
+        if (i < n) {
+          current->name = toks[i].get_text();
+          i++;
+        }
+
+        if ((i < n) && (toks[i].get_text() == "#")) {
+          i++;
+          if ((i < n) && (toks[i].get_text() == "(")) {
+            i = skip_balanced(toks, i);
+          }
+        }
+
+        if ((i < n) && (toks[i].get_text() == "(")) {
+          i = skim_port_list(toks, i, current->port_names);
+        }
+
+        i = skip_to_semicolon(toks, i);
+      } else if (t == "endmodule") {
+        current = nullptr;
+        i++;
+      } else if ((current != nullptr) &&
+                 (i + 2 < n) &&
+                 ((toks[i + 1].get_text() == "#") ||
+                  (toks[i + 2].get_text() == "(")) &&
+                 is_skim_id(t)) {
+
+        // type [#(params)] name (connections) ;
+        int j = i + 1;
+        if (toks[j].get_text() == "#") {
+          j++;
+          if ((j < n) && (toks[j].get_text() == "(")) {
+            j = skip_balanced(toks, j);
+          }
+        }
+
+        if ((j + 1 < n) &&
+            is_skim_id(toks[j].get_text()) &&
+            (toks[j + 1].get_text() == "(")) {
+          skim_instance inst;
+          inst.module_type = t;
+          inst.name = toks[j].get_text();
+          inst.module = -1;
+
+          i = skim_connections(toks, j + 1, inst.port_names);
+          current->instances.push_back(std::move(inst));
+        } else {
+          i++;
+        }
+      } else if (t == "(") {
+        i = skip_balanced(toks, i);
+      } else {
+        i++;
+      }
+    }
+  }
+
+  hierarchy_graph skim_hierarchy(const std::string& verilog_code) {
+    hierarchy_graph graph;
+    skim_hierarchy(tokenize(verilog_code), graph);
+    graph.resolve();
+    return graph;
+  }
+
+  int hierarchy_graph::find_module(const std::string& name) const {
+    for (unsigned i = 0; i < modules.size(); i++) {
+      if (modules[i].name == name) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  void hierarchy_graph::resolve() {
+    unordered_map<string, int> module_inds;
+    for (unsigned i = 0; i < modules.size(); i++) {
+      module_inds.insert({modules[i].name, i});
+    }
+
+    for (auto& mod : modules) {
+      for (auto& inst : mod.instances) {
+        auto it = module_inds.find(inst.module_type);
+        inst.module = it == module_inds.end() ? -1 : it->second;
+      }
+    }
+  }
+
+  std::vector<int> hierarchy_graph::build_order() const {
+    // 0 = unvisited, 1 = on the stack, 2 = done
+    vector<int> state(modules.size(), 0);
+    vector<int> order;
+
+    for (unsigned root = 0; root < modules.size(); root++) {
+      if (state[root] != 0) {
+        continue;
+      }
+
+      // Iterative post order DFS, (module, next instance) pairs
+      vector<pair<int, unsigned> > stack{{root, 0}};
+      state[root] = 1;
+
+      while (stack.size() > 0) {
+        auto& top = stack.back();
+        const skim_module& mod = modules[top.first];
+
+        if (top.second < mod.instances.size()) {
+          int child = mod.instances[top.second].module;
+          top.second++;
+
+          // Recursive instantiation is left to the consumer
+          if ((child >= 0) && (state[child] == 0)) {
+            state[child] = 1;
+            stack.push_back({child, 0});
+          }
+        } else {
+          state[top.first] = 2;
+          order.push_back(top.first);
+          stack.pop_back();
+        }
+      }
+    }
+
+    return order;
+  }
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "token.h"
+
+namespace vparser {
+
+  class skim_instance {
+  public:
+    std::string module_type;
+    std::string name;
+
+    // Names of the ports connected by name, in order
+    std::vector<std::string> port_names;
+
+    // Index of module_type in hierarchy_graph::modules, -1 if it is not
+    // defined in the skimmed code
+    int module;
+  };
+
+  class skim_module {
+  public:
+    std::string name;
+    std::vector<std::string> port_names;
+    std::vector<skim_instance> instances;
+  };
+
+  // Modules and the instantiation edges between them, found without
+  // building statements or expressions
+  class hierarchy_graph {
+  public:
+    std::vector<skim_module> modules;
+
+    int find_module(const std::string& name) const;
+
+    // Sets skim_instance::module for every instance
+    void resolve();
+
+    // Module indexes ordered so every module comes after the modules it
+    // instantiates. Requires resolve().
+    std::vector<int> build_order() const;
+  };
+
+  // Adds the modules in toks to graph. Anything that is not a module
+  // header or an instantiation is skipped by scanning for delimiters.
+  // Macro uses are skipped, so toks can be raw or preprocessed code.
+  void skim_hierarchy(const std::vector<token>& toks, hierarchy_graph& graph);
+
+  hierarchy_graph skim_hierarchy(const std::string& verilog_code);
+
+}
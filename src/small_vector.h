@@ -0,0 +1,238 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace vparser {
+
+  // A vector that keeps up to N elements inside the object and only
+  // allocates (through Alloc) when it grows past N. Iterators are plain
+  // pointers and are invalidated by any insertion, as with std::vector.
+  template<typename T, unsigned N, typename Alloc = std::allocator<T> >
+  class small_vector {
+    typedef std::allocator_traits<Alloc> alloc_traits;
+
+    T* elems;
+    unsigned len;
+    unsigned cap;
+    Alloc alloc;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type
+    inline_elems[N == 0 ? 1 : N];
+
+    T* inline_data() { return reinterpret_cast<T*>(inline_elems); }
+
+    void destroy_all() {
+      for (unsigned i = 0; i < len; i++) {
+        elems[i].~T();
+      }
+      len = 0;
+    }
+
+    void release() {
+      if (!is_inline()) {
+        alloc_traits::deallocate(alloc, elems, cap);
+      }
+      elems = inline_data();
+      cap = N;
+    }
+
+    // Takes other's heap buffer, or moves its inline elements one by one
+    void steal(small_vector& other) {
+      if (other.is_inline()) {
+        for (unsigned i = 0; i < other.len; i++) {
+          new (elems + i) T(std::move(other.elems[i]));
+        }
+        len = other.len;
+        other.destroy_all();
+      } else {
+        elems = other.elems;
+        len = other.len;
+        cap = other.cap;
+        other.elems = other.inline_data();
+        other.len = 0;
+        other.cap = N;
+      }
+    }
+
+    unsigned grown_capacity(const unsigned min_cap) const {
+      unsigned new_cap = cap < 4 ? 4 : 2*cap;
+      return new_cap < min_cap ? min_cap : new_cap;
+    }
+
+    // Moves the elements into new_elems, which holds new_cap, and frees
+    // the old buffer
+    void relocate(T* new_elems, const unsigned new_cap) {
+      for (unsigned i = 0; i < len; i++) {
+        new (new_elems + i) T(std::move(elems[i]));
+        elems[i].~T();
+      }
+
+      if (!is_inline()) {
+        alloc_traits::deallocate(alloc, elems, cap);
+      }
+      elems = new_elems;
+      cap = new_cap;
+    }
+
+    void grow(const unsigned min_cap) {
+      unsigned new_cap = grown_capacity(min_cap);
+      relocate(alloc_traits::allocate(alloc, new_cap), new_cap);
+    }
+
+  public:
+
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    small_vector(const Alloc& alloc_ = Alloc()) :
+      elems(inline_data()), len(0), cap(N), alloc(alloc_) {}
+
+    small_vector(std::initializer_list<T> init, const Alloc& alloc_ = Alloc()) :
+      small_vector(alloc_) {
+      assign(init.begin(), init.end());
+    }
+
+    small_vector(const std::vector<T>& vec, const Alloc& alloc_ = Alloc()) :
+      small_vector(alloc_) {
+      assign(vec.begin(), vec.end());
+    }
+
+    template<typename It>
+    small_vector(It first, It last, const Alloc& alloc_ = Alloc()) :
+      small_vector(alloc_) {
+      assign(first, last);
+    }
+
+    small_vector(const small_vector& other) : small_vector(other.alloc) {
+      assign(other.begin(), other.end());
+    }
+
+    small_vector(small_vector&& other) : small_vector(other.alloc) {
+      steal(other);
+    }
+
+    ~small_vector() {
+      destroy_all();
+      release();
+    }
+
+    small_vector& operator=(const small_vector& other) {
+      if (this != &other) {
+        assign(other.begin(), other.end());
+      }
+      return *this;
+    }
+
+    small_vector& operator=(small_vector&& other) {
+      if (this != &other) {
+        destroy_all();
+        release();
+        steal(other);
+      }
+      return *this;
+    }
+
+    template<typename It>
+    void assign(It first, It last) {
+      clear();
+      reserve(std::distance(first, last));
+      for (; first != last; ++first) {
+        new (elems + len) T(*first);
+        len++;
+      }
+    }
+
+    void reserve(const unsigned n) {
+      if (n > cap) {
+        grow(n);
+      }
+    }
+
+    void push_back(const T& val) {
+      emplace_back(val);
+    }
+
+    void push_back(T&& val) {
+      emplace_back(std::move(val));
+    }
+
+    // args may refer to an element, like v.push_back(v[0]), so when full
+    // the new element is built in the new buffer before the old one goes
+    template<typename... Args>
+    void emplace_back(Args&&... args) {
+      if (len < cap) {
+        new (elems + len) T(std::forward<Args>(args)...);
+        len++;
+        return;
+      }
+
+      unsigned new_cap = grown_capacity(len + 1);
+      T* new_elems = alloc_traits::allocate(alloc, new_cap);
+      try {
+        new (new_elems + len) T(std::forward<Args>(args)...);
+      } catch (...) {
+        alloc_traits::deallocate(alloc, new_elems, new_cap);
+        throw;
+      }
+      relocate(new_elems, new_cap);
+      len++;
+    }
+
+    void pop_back() {
+      assert(len > 0);
+      len--;
+      elems[len].~T();
+    }
+
+    void clear() { destroy_all(); }
+
+    unsigned size() const { return len; }
+    unsigned capacity() const { return cap; }
+    bool empty() const { return len == 0; }
+
+    // True while the elements live inside the object
+    bool is_inline() const {
+      return elems == reinterpret_cast<const T*>(inline_elems);
+    }
+
+    T& operator[](const unsigned i) { return elems[i]; }
+    const T& operator[](const unsigned i) const { return elems[i]; }
+
+    T& front() { return elems[0]; }
+    const T& front() const { return elems[0]; }
+    T& back() { return elems[len - 1]; }
+    const T& back() const { return elems[len - 1]; }
+
+    T* data() { return elems; }
+    const T* data() const { return elems; }
+
+    iterator begin() { return elems; }
+    iterator end() { return elems + len; }
+    const_iterator begin() const { return elems; }
+    const_iterator end() const { return elems + len; }
+
+    bool operator==(const small_vector& other) const {
+      if (len != other.len) {
+        return false;
+      }
+      for (unsigned i = 0; i < len; i++) {
+        if (!(elems[i] == other.elems[i])) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    bool operator!=(const small_vector& other) const {
+      return !(*this == other);
+    }
+  };
+
+}
@@ -28,19 +28,30 @@ namespace vparser {
   };
 
   class statement {
+    // Not virtual, see expression
+    statement_type type;
+
+  protected:
+
+    statement(const statement_type type_) : type(type_) {}
+
   public:
 
-    virtual statement_type get_type() const = 0;
+    statement_type get_type() const { return type; }
 
     virtual void print(std::ostream& out) const = 0;
 
-    virtual std::string to_string(const int indent_level) const {
-      return indent(indent_level) + "STATEMENT PLACEHOLDER";
-    }
+    // Written by ast_printer, see printer.h
+    std::string to_string(const int indent_level) const;
 
     virtual ~statement() {}
   };
 
+  // Inline sizes from the sample netlists: begin blocks almost always
+  // hold one or two statements, most case statements have 4 or 5 items
+  typedef small_vector<statement*, 2> statement_list;
+  typedef small_vector<std::pair<expression*, statement*>, 4> case_list;
+
   class decl_stmt : public statement {
 
     std::string category;
@@ -52,39 +63,24 @@ namespace vparser {
 
   public:
 
-    decl_stmt(const std::string& category_,
-              const std::string& storage_type_,
+    decl_stmt(std::string category_,
+              std::string storage_type_,
               expression* const w_start_,
               expression* const w_end_,
-              const std::string& name_,
+              std::string name_,
               expression* const init_value_) :
-      category(category_), storage_type(storage_type_), w_start(w_start_), w_end(w_end_), name(name_), init_value(init_value_) {}
-
-    statement_type get_type() const {
-      return STATEMENT_DECL;
-    }
+      statement(STATEMENT_DECL), category(std::move(category_)), storage_type(std::move(storage_type_)), w_start(w_start_), w_end(w_end_), name(std::move(name_)), init_value(init_value_) {}
 
-    std::string get_name() const {
+    const std::string& get_name() const {
       return name;
     }
 
-    std::string to_string(const int lvl) const {
-      std::string str = indent(lvl) + category + " ";
-
-      if ((w_end != nullptr) &&
-          (w_start != nullptr)) {
-        str +=  "[ " + w_end->to_string() + " : " + w_start->to_string() + " ] ";
-      }
+    const std::string& get_category() const { return category; }
+    const std::string& get_storage_type() const { return storage_type; }
 
-      str += storage_type + " " + name;
-      if (init_value != nullptr) {
-        str += " = " + init_value->to_string();
-      }
-
-      str += ";";
-        
-      return str;
-    }
+    expression* get_width_start() const { return w_start; }
+    expression* get_width_end() const { return w_end; }
+    expression* get_init_value() const { return init_value; }
     
     virtual void print(std::ostream& out) const {
       out << "declaration" << std::endl;
@@ -116,34 +112,17 @@ namespace vparser {
 
   public:
 
-    always_stmt(const std::vector<std::pair<signal_edge, std::string> >& sensitivity_list_,
+    always_stmt(std::vector<std::pair<signal_edge, std::string> > sensitivity_list_,
                 statement* const stmt_) :
-      sensitivity_list(sensitivity_list_), stmt(stmt_) {}
-
-    statement_type get_type() const {
-      return STATEMENT_ALWAYS;
-    }
+      statement(STATEMENT_ALWAYS), sensitivity_list(std::move(sensitivity_list_)), stmt(stmt_) {}
 
     statement* get_statement() const {
       return stmt;
     }
 
-    std::string to_string(const int lvl) const {
-      std::string str =
-        indent(lvl) + "always @(";
-        
-        for (int i = 0; i < sensitivity_list.size(); i++) {
-          auto& value_pair = sensitivity_list[i];
-
-          str += signal_edge_to_string(value_pair.first) + " " + value_pair.second;
-
-          if (i < sensitivity_list.size() - 1) {
-            str += " or ";
-          }
-        }
-        str += ")\n" +
-        get_statement()->to_string(lvl + 1);
-      return str;
+    const std::vector<std::pair<signal_edge, std::string> >&
+    get_sensitivity_list() const {
+      return sensitivity_list;
     }
     
     virtual void print(std::ostream& out) const {
@@ -168,29 +147,17 @@ namespace vparser {
   public:
 
     if_stmt(expression* const condition_, statement* const if_exe_) :
-      condition(condition_), if_exe(if_exe_), else_exe(nullptr) {}
+      statement(STATEMENT_IF), condition(condition_), if_exe(if_exe_), else_exe(nullptr) {}
 
     if_stmt(expression* const condition_,
             statement* const if_exe_,
             statement* const else_exe_) :
-      condition(condition_), if_exe(if_exe_), else_exe(else_exe_) {}
+      statement(STATEMENT_IF), condition(condition_), if_exe(if_exe_), else_exe(else_exe_) {}
+
+    expression* get_condition() const { return condition; }
 
     statement* get_if_exe() const { return if_exe; }
     statement* get_else_exe() const { return else_exe; }
-    
-    statement_type get_type() const {
-      return STATEMENT_IF;
-    }
-
-    std::string to_string(const int lvl) const {
-      std::string str = indent(lvl) + "if (" + condition->to_string() + ")\n";
-      str += get_if_exe()->to_string(lvl + 1);
-      if (get_else_exe() != nullptr) {
-        str += indent(lvl) + "else\n" + get_else_exe()->to_string(lvl + 1);
-      }
-      
-      return str;
-    }
 
     virtual void print(std::ostream& out) const {
       out << "if" << std::endl;
@@ -201,47 +168,28 @@ namespace vparser {
   class empty_stmt : public statement {
   public:
 
-    statement_type get_type() const {
-      return STATEMENT_EMPTY;
-    }
+    empty_stmt() : statement(STATEMENT_EMPTY) {}
 
     virtual void print(std::ostream& out) const {
       out << " " << std::endl;
     }
 
-    virtual std::string to_string(const int) const {
-      return "";
-    }
-
   };
 
   class begin_stmt : public statement {
   protected:
 
-    std::vector<statement*> stmts;
+    statement_list stmts;
 
   public:
 
-    begin_stmt(const std::vector<statement*>& stmts_) :
-      stmts(stmts_) {}
+    begin_stmt(statement_list stmts_) :
+      statement(STATEMENT_BEGIN), stmts(std::move(stmts_)) {}
 
-    std::vector<statement*> get_statements() const {
+    const statement_list& get_statements() const {
       return stmts;
     }
 
-    std::string to_string(const int lvl) const {
-      std::string str = indent(lvl) + "begin\n";
-      for (auto& stmt : get_statements()) {
-        str += stmt->to_string(lvl + 1) + "\n";
-      }
-      str += "\n" + indent(lvl) + "end\n";
-      return str;
-    }
-    
-    statement_type get_type() const {
-      return STATEMENT_BEGIN;
-    }
-
     virtual void print(std::ostream& out) const {
       out << to_string(0) << std::endl;
     }
@@ -251,44 +199,25 @@ namespace vparser {
   class case_stmt : public statement {
   protected:
 
-    std::vector<std::pair<expression*, statement*>> inner_cases;
+    case_list inner_cases;
 
     statement* default_stmt;
 
   public:
 
-    case_stmt(const std::vector<std::pair<expression*, statement*>> inner_cases_) :
-      inner_cases(inner_cases_), default_stmt(nullptr) {}
+    case_stmt(case_list inner_cases_) :
+      statement(STATEMENT_CASE), inner_cases(std::move(inner_cases_)), default_stmt(nullptr) {}
 
-    case_stmt(const std::vector<std::pair<expression*, statement*>> inner_cases_,
+    case_stmt(case_list inner_cases_,
               statement* default_stmt_) :
-      inner_cases(inner_cases_), default_stmt(default_stmt_) {}
-    
-    statement_type get_type() const {
-      return STATEMENT_CASE;
-    }
-
-    std::string to_string(const int lvl) const {
-      std::string str = indent(lvl) + "case (CASE EXPR)\n";
-
-      for (auto& cs : inner_cases) {
-        str += indent(lvl + 1) + cs.first->to_string() + ": " + cs.second->to_string(0) + "\n";
-      }
-
-      if (default_stmt != nullptr) {
-        str += indent(lvl + 1) + "default: " + default_stmt->to_string(0) + "\n";
-      }
-
-      str += "\n" + indent(lvl) + "endcase\n";
-
-      return str;
-    }
+      statement(STATEMENT_CASE), inner_cases(std::move(inner_cases_)), default_stmt(default_stmt_) {}
     
-    std::vector<std::pair<expression*, statement*> >
-    get_cases() const {
+    const case_list& get_cases() const {
       return inner_cases;
     }
 
+    statement* get_default() const { return default_stmt; }
+
     virtual void print(std::ostream& out) const {
       out << "case ()" << std::endl;
     }
@@ -304,21 +233,11 @@ namespace vparser {
   public:
 
     assign_stmt(expression* const lhs_,
-                expression* const rhs_) : lhs(lhs_), rhs(rhs_) {}
-
-    statement_type get_type() const {
-      return STATEMENT_ASSIGN;
-    }
+                expression* const rhs_) : statement(STATEMENT_ASSIGN), lhs(lhs_), rhs(rhs_) {}
 
     virtual void print(std::ostream& out) const {
       out << " " << std::endl;
     }
-
-    std::string to_string(const int lvl) const {
-      std::string str =
-        indent(lvl) + "assign " + lhs->to_string() + " = " + rhs->to_string() + ";";
-      return str;
-    }
     
     expression* get_lhs() const {
       return lhs;
@@ -339,17 +258,7 @@ namespace vparser {
   public:
 
     blocking_assign_stmt(expression* const lhs_,
-                expression* const rhs_) : lhs(lhs_), rhs(rhs_) {}
-
-    statement_type get_type() const {
-      return STATEMENT_BLOCKING_ASSIGN;
-    }
-
-    std::string to_string(const int lvl) const {
-      std::string str =
-        indent(lvl) + lhs->to_string() + " = " + rhs->to_string() + ";";
-      return str;
-    }
+                expression* const rhs_) : statement(STATEMENT_BLOCKING_ASSIGN), lhs(lhs_), rhs(rhs_) {}
     
     virtual void print(std::ostream& out) const {
       out << " " << std::endl;
@@ -374,17 +283,7 @@ namespace vparser {
   public:
 
     non_blocking_assign_stmt(expression* const lhs_,
-                expression* const rhs_) : lhs(lhs_), rhs(rhs_) {}
-
-    statement_type get_type() const {
-      return STATEMENT_NON_BLOCKING_ASSIGN;
-    }
-
-    std::string to_string(const int lvl) const {
-      std::string str =
-        indent(lvl) + lhs->to_string() + " <= " + rhs->to_string() + ";";
-      return str;
-    }
+                expression* const rhs_) : statement(STATEMENT_NON_BLOCKING_ASSIGN), lhs(lhs_), rhs(rhs_) {}
     
     virtual void print(std::ostream& out) const {
       out << " " << std::endl;
@@ -402,31 +301,17 @@ namespace vparser {
 
   class call_stmt : public statement {
     std::string name;
-    std::vector<expression*> args;
+    expression_list args;
 
   public:
 
-    call_stmt(const std::string& name_,
-              const std::vector<expression*>& args_) : name(name_), args(args_) {}
+    call_stmt(std::string name_,
+              expression_list args_) :
+      statement(STATEMENT_CALL), name(std::move(name_)), args(std::move(args_)) {}
 
-    std::string to_string(const int lvl) const {
-      std::string str =
-        indent(lvl) + "$" + name + "( ";
+    const std::string& get_name() const { return name; }
 
-      for (int i = 0; i < args.size(); i++) {
-        str += args[i]->to_string();
-
-        if (i < args.size() - 1) {
-          str += ", ";
-        }
-      }
-      str += ");";
-      return str;
-    }
-    
-    statement_type get_type() const {
-      return STATEMENT_CALL;
-    }
+    const expression_list& get_args() const { return args; }
 
     virtual void print(std::ostream& out) const {
       out << " " << std::endl;
@@ -441,38 +326,22 @@ namespace vparser {
 
   public:
 
-    module_instantiation_stmt(const std::string& module_type_,
-                              const std::string& name_,
-                              const std::vector<std::pair<std::string, expression*> > port_assignments_) :
-      module_type(module_type_),
-      name(name_),
-      port_assignments(port_assignments_) {}
-
-    statement_type get_type() const {
-      return STATEMENT_MODULE_INSTANTIATION;
-    }
+    module_instantiation_stmt(std::string module_type_,
+                              std::string name_,
+                              std::vector<std::pair<std::string, expression*> > port_assignments_) :
+      statement(STATEMENT_MODULE_INSTANTIATION),
+      module_type(std::move(module_type_)),
+      name(std::move(name_)),
+      port_assignments(std::move(port_assignments_)) {}
 
-    std::string get_module_type() const { return module_type; }
-    std::string get_name() const { return name; }
+    const std::string& get_module_type() const { return module_type; }
+    const std::string& get_name() const { return name; }
 
-    std::vector<std::pair<std::string, expression*> > get_port_assignments() const {
+    const std::vector<std::pair<std::string, expression*> >&
+    get_port_assignments() const {
       return port_assignments;
     }
 
-    std::string to_string(const int lvl) const {
-      std::string str = indent(lvl) + module_type + " " + name + "(";
-
-      for (int i = 0; i < port_assignments.size(); i++) {
-        str += "." + port_assignments[i].first + "(" + port_assignments[i].second->to_string() + ")";
-        if (i < (port_assignments.size() - 1)) {
-          str += ", ";
-        }
-      }
-      str += ");";
-
-      return str;
-    }
-
     virtual void print(std::ostream& out) const {
       out << " " << std::endl;
     }
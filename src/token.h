@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <utility>
 
 namespace vparser {
 
@@ -21,12 +22,12 @@ namespace vparser {
     source_position pos;
 
   public:
-    token(const std::string& text_,
-          const source_position& pos_) : text(text_), pos(pos_) {}
+    token(std::string text_,
+          const source_position& pos_) : text(std::move(text_)), pos(pos_) {}
 
     token() : text("") {}
 
-    std::string get_text() const { return text; }
+    const std::string& get_text() const { return text; }
     source_position get_pos() const { return pos; }
   };
 
@@ -51,14 +51,13 @@ namespace vparser {
   };
 
   string parse_name(parse_state& ps) {
-    string n = "";
+    int start = ps.index();
     while (ps.chars_left() && (isalpha(ps.next()) ||
 			       (ps.next() == '_') ||
 			       isdigit(ps.next()))) {
-      n += ps.next();
       ps++;
     }
-    return n;
+    return ps.code.substr(start, ps.index() - start);
   }
 
   bool is_separator(const char c) {
@@ -157,12 +156,11 @@ namespace vparser {
   }
 
   string parse_digits(parse_state& ps) {
-    string s = "";
+    int start = ps.index();
     while (ps.chars_left() && isdigit(ps.next())) {
-      s += ps.next();
       ps++;
     }
-    return s;
+    return ps.code.substr(start, ps.index() - start);
   }
 
   bool is_boolop(const char c) {
@@ -171,7 +169,43 @@ namespace vparser {
       (c == '*');
   }
 
-  string parse_string_literal(parse_state& ps) {
+  // At most max_chars of the line around the current position
+  string line_context(const parse_state& ps) {
+    const int max_chars = 40;
+
+    int start = ps.index();
+    while ((start > 0) &&
+           (ps.index() - start < max_chars) &&
+           (ps.code[start - 1] != '\n')) {
+      start--;
+    }
+
+    int end = ps.index();
+    while ((end < ((int) ps.code.size())) &&
+           (end - ps.index() < max_chars) &&
+           (ps.code[end] != '\n')) {
+      end++;
+    }
+
+    return ps.code.substr(start, end - start);
+  }
+
+  void lex_error(const parse_state& ps,
+                 const std::string& msg,
+                 diagnostic_engine* diags) {
+    if (diags == nullptr) {
+      cout << "Error: " << msg << " at position " << ps.index() << ", line number = " << ps.lineNumber() << endl;
+      assert(false);
+      return;
+    }
+
+    diags->error(source_position(ps.lineNumber(), ps.line_pos()),
+                 -1,
+                 msg,
+                 line_context(ps));
+  }
+
+  string parse_string_literal(parse_state& ps, diagnostic_engine* diags) {
     assert(ps.next() == '"');
 
     string tok = "";
@@ -180,12 +214,15 @@ namespace vparser {
     ps++;
 
 
-    while (ps.next() != '"') {
+    while (ps.chars_left() && (ps.next() != '"')) {
       tok += ps.next();
       ps++;
     }
 
-    assert(ps.next() == '"');
+    if (!ps.chars_left()) {
+      lex_error(ps, "Unterminated string literal", diags);
+      return tok + "\"";
+    }
 
     tok += "\"";
     ps++;
@@ -235,7 +272,8 @@ namespace vparser {
 
   }
 
-  std::vector<token> tokenize(const std::string& verilog_code) {
+  std::vector<token> tokenize(const std::string& verilog_code,
+                              diagnostic_engine* diags) {
     vector<token> tokens;
     int i = 0;
 
@@ -284,37 +322,39 @@ namespace vparser {
 	nextTok = parse_lt(ps);
       } else if (c == '>') {
 	nextTok = parse_gt(ps);
-      } else if (is_boolop(c) && !is_boolop(ps.next(1))) {
-	nextTok = string(1, c);
-	ps++;
-      } else if (c == '#') {
-        nextTok = "#";
-        ps++;
-      } else if (c == '&') {
-        assert(ps.next(1) == '&');
+      } else if ((c == '&') && (ps.next(1) == '&')) {
         nextTok = "&&";
         ps++;
         ps++;
-      } else if (c == '|') {
-        assert(ps.next(1) == '|');
+      } else if ((c == '|') && (ps.next(1) == '|')) {
         nextTok = "||";
         ps++;
         ps++;
-      } else if (c == '!') {
-	assert(ps.next(1) == '=');
-	nextTok = "!=";
-	ps++;
+      } else if (is_boolop(c)) {
+	nextTok = string(1, c);
 	ps++;
+      } else if (c == '#') {
+        nextTok = "#";
+        ps++;
+      } else if (c == '!') {
+        if (ps.next(1) == '=') {
+          nextTok = "!=";
+          ps++;
+          ps++;
+        } else {
+          nextTok = "!";
+          ps++;
+        }
       } else if (c == '"') {
         cout << "Parsing string" << endl;
-        nextTok = parse_string_literal(ps);
+        nextTok = parse_string_literal(ps, diags);
       } else {
-	
-	cout << "Unsupported char = " << c << " at position " << ps.index() << ", line number = " << ps.lineNumber() << endl;
-	assert(false);
+        lex_error(ps, "Unsupported char = " + string(1, c), diags);
+        ps++;
+        continue;
       }
 
-      tokens.push_back(token(nextTok, source_position(line_no, line_pos)));
+      tokens.emplace_back(std::move(nextTok), source_position(line_no, line_pos));
 
       i++;
     }
@@ -322,4 +362,37 @@ namespace vparser {
     return tokens;
   }
 
+  std::vector<token> tokenize(const std::string& verilog_code) {
+    return tokenize(verilog_code, nullptr);
+  }
+
+  std::vector<token> tokenize(const std::string& verilog_code,
+                              diagnostic_engine& diags) {
+    return tokenize(verilog_code, &diags);
+  }
+
+  std::vector<token> tokenize(const std::string& verilog_code,
+                              diagnostic_engine* diags,
+                              parse_stats& stats) {
+    vector<token> toks;
+    {
+      phase_timer timer(&stats.tokenize);
+      toks = tokenize(verilog_code, diags);
+    }
+    stats.tokenize.bytes += verilog_code.size();
+    stats.tokenize.tokens += toks.size();
+    return toks;
+  }
+
+  std::vector<token> tokenize(const std::string& verilog_code,
+                              parse_stats& stats) {
+    return tokenize(verilog_code, nullptr, stats);
+  }
+
+  std::vector<token> tokenize(const std::string& verilog_code,
+                              diagnostic_engine& diags,
+                              parse_stats& stats) {
+    return tokenize(verilog_code, &diags, stats);
+  }
+
 }
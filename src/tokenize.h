@@ -3,10 +3,24 @@
 #include <string>
 #include <vector>
 
+#include "diagnostics.h"
+#include "parse_stats.h"
 #include "token.h"
 
 namespace vparser {
 
   std::vector<token> tokenize(const std::string& verilog_code);
 
+  // Records unsupported characters in diags and skips them instead of
+  // aborting
+  std::vector<token> tokenize(const std::string& verilog_code,
+                              diagnostic_engine& diags);
+
+  // Add a tokenize phase to stats
+  std::vector<token> tokenize(const std::string& verilog_code,
+                              parse_stats& stats);
+  std::vector<token> tokenize(const std::string& verilog_code,
+                              diagnostic_engine& diags,
+                              parse_stats& stats);
+
 }
@@ -0,0 +1,121 @@
+#include "trace.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace vparser {
+
+  static std::atomic<uint64_t> next_recorder_id(1);
+
+  // The last buffer this thread got, and the recorder it came from
+  class thread_buffer_cache {
+  public:
+    uint64_t recorder;
+    trace_buffer* buf;
+  };
+
+  static thread_local thread_buffer_cache cached_buffer = {0, nullptr};
+
+  trace_recorder::trace_recorder() :
+    id(next_recorder_id++), start(steady_clock_ns()) {}
+
+  trace_buffer* trace_recorder::thread_buffer() {
+    if (cached_buffer.recorder == id) {
+      return cached_buffer.buf;
+    }
+
+    std::thread::id self = std::this_thread::get_id();
+
+    lock_guard<mutex> lock(buffers_mutex);
+    trace_buffer* buf = nullptr;
+    for (auto& b : buffers) {
+      if (b->owner == self) {
+        buf = b.get();
+      }
+    }
+
+    if (buf == nullptr) {
+      // Tids start at 1, Perfetto shows tid 0 as the process
+      buffers.emplace_back(new trace_buffer(self, buffers.size() + 1, start));
+      buf = buffers.back().get();
+    }
+
+    cached_buffer = {id, buf};
+    return buf;
+  }
+
+  int trace_recorder::num_events() const {
+    int n = 0;
+    for (auto& buf : buffers) {
+      n += buf->events.size();
+    }
+    return n;
+  }
+
+  std::string trace_json_string(const std::string& str) {
+    string out = "\"";
+    for (char c : str) {
+      if ((c == '"') || (c == '\\')) {
+        out += '\\';
+        out += c;
+      } else if (((unsigned char) c) < 0x20) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\u%04x", c);
+        out += buf;
+      } else {
+        out += c;
+      }
+    }
+    out += "\"";
+    return out;
+  }
+
+  // Trace Event timestamps are microseconds, fractions are allowed
+  void print_us(ostream& out, const uint64_t ns) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.3f", ns / 1000.0);
+    out << buf;
+  }
+
+  std::string trace_recorder::to_json() const {
+    ostringstream out;
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+
+    bool first = true;
+    for (auto& buf : buffers) {
+      string name =
+        buf->thread_name.empty() ? "thread " + std::to_string(buf->tid) : buf->thread_name;
+      out << (first ? "" : ",\n")
+          << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+          << buf->tid << ", \"args\": {\"name\": " << trace_json_string(name) << "}}";
+      first = false;
+
+      for (auto& ev : buf->events) {
+        out << ",\n{\"name\": " << trace_json_string(ev.name)
+            << ", \"cat\": \"vparser\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+            << buf->tid << ", \"ts\": ";
+        print_us(out, ev.start_ns);
+        out << ", \"dur\": ";
+        print_us(out, ev.dur_ns);
+        if (!ev.detail.empty()) {
+          out << ", \"args\": {\"detail\": " << trace_json_string(ev.detail) << "}";
+        }
+        out << "}";
+      }
+    }
+
+    out << "\n]}\n";
+    return out.str();
+  }
+
+  bool trace_recorder::write(const std::string& path) const {
+    ofstream out(path);
+    out << to_json();
+    return (bool) out;
+  }
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vparser {
+
+  inline uint64_t steady_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // A finished span. Times are nanoseconds since the recorder started.
+  class trace_event {
+  public:
+    const char* name;
+    std::string detail;
+    uint64_t start_ns;
+    uint64_t dur_ns;
+  };
+
+  // Spans recorded by one thread. Only that thread appends, so adding an
+  // event takes no lock; the buffer is read once the threads are done.
+  class trace_buffer {
+    std::thread::id owner;
+    int tid;
+    uint64_t origin;
+    std::string thread_name;
+    std::vector<trace_event> events;
+
+    friend class trace_recorder;
+
+  public:
+
+    trace_buffer(const std::thread::id owner_,
+                 const int tid_,
+                 const uint64_t origin_) :
+      owner(owner_), tid(tid_), origin(origin_) {}
+
+    int get_tid() const { return tid; }
+
+    // Nanoseconds since the recorder was created
+    uint64_t now() const { return steady_clock_ns() - origin; }
+
+    void set_thread_name(const std::string& name) { thread_name = name; }
+
+    void add(const char* name,
+             const std::string& detail,
+             const uint64_t start_ns,
+             const uint64_t end_ns) {
+      events.push_back({name, detail, start_ns, end_ns - start_ns});
+    }
+
+    const std::vector<trace_event>& get_events() const { return events; }
+  };
+
+  // Collects spans from any number of threads and writes them as Chrome
+  // Trace Event JSON, which chrome://tracing and Perfetto open directly.
+  // Code that may be traced holds a trace_buffer*, null when tracing is
+  // off, so a disabled span costs one branch.
+  class trace_recorder {
+    // Distinguishes recorders in the per-thread buffer cache, even one
+    // allocated where a destroyed recorder used to be
+    uint64_t id;
+    uint64_t start;
+
+    std::mutex buffers_mutex;
+    std::vector<std::unique_ptr<trace_buffer> > buffers;
+
+  public:
+
+    trace_recorder();
+
+    trace_recorder(const trace_recorder&) = delete;
+    trace_recorder& operator=(const trace_recorder&) = delete;
+
+    // The calling thread's buffer, created on its first call. Takes a
+    // lock only the first time a thread asks this recorder.
+    trace_buffer* thread_buffer();
+
+    // Call only once every thread that records has finished
+    int num_events() const;
+    const std::vector<std::unique_ptr<trace_buffer> >& get_buffers() const {
+      return buffers;
+    }
+
+    std::string to_json() const;
+
+    // False if path could not be written
+    bool write(const std::string& path) const;
+  };
+
+  // Records the time from construction to destruction as one span in
+  // buf. With a null buf nothing is recorded and detail is not copied.
+  class trace_span {
+    trace_buffer* buf;
+    const char* name;
+    std::string detail;
+    uint64_t start;
+
+  public:
+
+    trace_span(trace_buffer* buf_, const char* name_) :
+      buf(buf_), name(name_), start(0) {
+      if (buf != nullptr) {
+        start = buf->now();
+      }
+    }
+
+    trace_span(trace_buffer* buf_,
+               const char* name_,
+               const std::string& detail_) :
+      buf(buf_), name(name_), start(0) {
+      if (buf != nullptr) {
+        detail = detail_;
+        start = buf->now();
+      }
+    }
+
+    ~trace_span() {
+      if (buf != nullptr) {
+        buf->add(name, detail, start, buf->now());
+      }
+    }
+
+    trace_span(const trace_span&) = delete;
+    trace_span& operator=(const trace_span&) = delete;
+  };
+
+}
@@ -0,0 +1,646 @@
+#pragma once
+
+#include "parse.h"
+
+namespace vparser {
+
+  enum visit_result {
+    VISIT_CONTINUE,
+    VISIT_SKIP_CHILDREN,
+    VISIT_STOP
+  };
+
+  // CRTP visitor over the AST. A derived class defines the hooks it
+  // needs, with the same names, and walk calls them through the derived
+  // type, so dispatch is a switch on get_type() with no virtual calls.
+  //
+  // pre_* runs before a node's children and may skip them or stop the
+  // walk, post_* runs after them and may stop the walk. Hooks a derived
+  // class does not define fall back to {pre,post}_{expression,statement}.
+  // Shared subexpressions (hash-consed ASTs, `a[i]` slices) are visited
+  // once per use, as in to_string.
+  template<typename Derived>
+  class ast_visitor {
+
+    Derived& derived() { return *static_cast<Derived*>(this); }
+
+  public:
+
+    visit_result pre_expression(const expression*) { return VISIT_CONTINUE; }
+    visit_result post_expression(const expression*) { return VISIT_CONTINUE; }
+    visit_result pre_statement(const statement*) { return VISIT_CONTINUE; }
+    visit_result post_statement(const statement*) { return VISIT_CONTINUE; }
+
+    visit_result pre_id(const id_expr* e) { return derived().pre_expression(e); }
+    visit_result post_id(const id_expr* e) { return derived().post_expression(e); }
+    visit_result pre_num(const num_expr* e) { return derived().pre_expression(e); }
+    visit_result post_num(const num_expr* e) { return derived().post_expression(e); }
+    visit_result pre_float(const float_expr* e) { return derived().pre_expression(e); }
+    visit_result post_float(const float_expr* e) { return derived().post_expression(e); }
+    visit_result pre_string_literal(const string_literal_expr* e) { return derived().pre_expression(e); }
+    visit_result post_string_literal(const string_literal_expr* e) { return derived().post_expression(e); }
+    visit_result pre_slice(const slice_expr* e) { return derived().pre_expression(e); }
+    visit_result post_slice(const slice_expr* e) { return derived().post_expression(e); }
+    visit_result pre_unop(const unop_expr* e) { return derived().pre_expression(e); }
+    visit_result post_unop(const unop_expr* e) { return derived().post_expression(e); }
+    visit_result pre_binop(const binop_expr* e) { return derived().pre_expression(e); }
+    visit_result post_binop(const binop_expr* e) { return derived().post_expression(e); }
+    visit_result pre_trinop(const trinop_expr* e) { return derived().pre_expression(e); }
+    visit_result post_trinop(const trinop_expr* e) { return derived().post_expression(e); }
+    visit_result pre_concat(const concat_expr* e) { return derived().pre_expression(e); }
+    visit_result post_concat(const concat_expr* e) { return derived().post_expression(e); }
+
+    visit_result pre_decl(const decl_stmt* s) { return derived().pre_statement(s); }
+    visit_result post_decl(const decl_stmt* s) { return derived().post_statement(s); }
+    visit_result pre_always(const always_stmt* s) { return derived().pre_statement(s); }
+    visit_result post_always(const always_stmt* s) { return derived().post_statement(s); }
+    visit_result pre_begin(const begin_stmt* s) { return derived().pre_statement(s); }
+    visit_result post_begin(const begin_stmt* s) { return derived().post_statement(s); }
+    visit_result pre_if(const if_stmt* s) { return derived().pre_statement(s); }
+    visit_result post_if(const if_stmt* s) { return derived().post_statement(s); }
+    visit_result pre_assign(const assign_stmt* s) { return derived().pre_statement(s); }
+    visit_result post_assign(const assign_stmt* s) { return derived().post_statement(s); }
+    visit_result pre_case(const case_stmt* s) { return derived().pre_statement(s); }
+    visit_result post_case(const case_stmt* s) { return derived().post_statement(s); }
+    visit_result pre_empty(const empty_stmt* s) { return derived().pre_statement(s); }
+    visit_result post_empty(const empty_stmt* s) { return derived().post_statement(s); }
+    visit_result pre_module_instantiation(const module_instantiation_stmt* s) { return derived().pre_statement(s); }
+    visit_result post_module_instantiation(const module_instantiation_stmt* s) { return derived().post_statement(s); }
+    visit_result pre_blocking_assign(const blocking_assign_stmt* s) { return derived().pre_statement(s); }
+    visit_result post_blocking_assign(const blocking_assign_stmt* s) { return derived().post_statement(s); }
+    visit_result pre_non_blocking_assign(const non_blocking_assign_stmt* s) { return derived().pre_statement(s); }
+    visit_result post_non_blocking_assign(const non_blocking_assign_stmt* s) { return derived().post_statement(s); }
+    visit_result pre_call(const call_stmt* s) { return derived().pre_statement(s); }
+    visit_result post_call(const call_stmt* s) { return derived().post_statement(s); }
+
+    // Each walk returns false if a hook stopped the walk
+    bool walk(const expression* expr) {
+      if (expr == nullptr) {
+        return true;
+      }
+
+      switch (expr->get_type()) {
+      case EXPRESSION_ID: {
+        auto e = static_cast<const id_expr*>(expr);
+        return (derived().pre_id(e) != VISIT_STOP) &&
+          (derived().post_id(e) != VISIT_STOP);
+      }
+
+      case EXPRESSION_NUM: {
+        auto e = static_cast<const num_expr*>(expr);
+        return (derived().pre_num(e) != VISIT_STOP) &&
+          (derived().post_num(e) != VISIT_STOP);
+      }
+
+      case EXPRESSION_FLOAT: {
+        auto e = static_cast<const float_expr*>(expr);
+        return (derived().pre_float(e) != VISIT_STOP) &&
+          (derived().post_float(e) != VISIT_STOP);
+      }
+
+      case EXPRESSION_STRING_LITERAL: {
+        auto e = static_cast<const string_literal_expr*>(expr);
+        return (derived().pre_string_literal(e) != VISIT_STOP) &&
+          (derived().post_string_literal(e) != VISIT_STOP);
+      }
+
+      case EXPRESSION_SLICE: {
+        auto e = static_cast<const slice_expr*>(expr);
+        visit_result pre = derived().pre_slice(e);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE &&
+            !(walk(e->get_arg()) && walk(e->get_start()) && walk(e->get_end()))) {
+          return false;
+        }
+        return derived().post_slice(e) != VISIT_STOP;
+      }
+
+      case EXPRESSION_UNOP: {
+        auto e = static_cast<const unop_expr*>(expr);
+        visit_result pre = derived().pre_unop(e);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE && !walk(e->get_op0())) {
+          return false;
+        }
+        return derived().post_unop(e) != VISIT_STOP;
+      }
+
+      case EXPRESSION_BINOP: {
+        auto e = static_cast<const binop_expr*>(expr);
+        visit_result pre = derived().pre_binop(e);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE && !(walk(e->get_op0()) && walk(e->get_op1()))) {
+          return false;
+        }
+        return derived().post_binop(e) != VISIT_STOP;
+      }
+
+      case EXPRESSION_TRINOP: {
+        auto e = static_cast<const trinop_expr*>(expr);
+        visit_result pre = derived().pre_trinop(e);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE &&
+            !(walk(e->get_op0()) && walk(e->get_op1()) && walk(e->get_op2()))) {
+          return false;
+        }
+        return derived().post_trinop(e) != VISIT_STOP;
+      }
+
+      case EXPRESSION_CONCAT: {
+        auto e = static_cast<const concat_expr*>(expr);
+        visit_result pre = derived().pre_concat(e);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE) {
+          for (auto sub : e->get_exprs()) {
+            if (!walk(sub)) {
+              return false;
+            }
+          }
+        }
+        return derived().post_concat(e) != VISIT_STOP;
+      }
+
+      default:
+        assert(false);
+        return false;
+      }
+    }
+
+    bool walk(const statement* stmt) {
+      if (stmt == nullptr) {
+        return true;
+      }
+
+      switch (stmt->get_type()) {
+      case STATEMENT_DECL: {
+        auto s = static_cast<const decl_stmt*>(stmt);
+        visit_result pre = derived().pre_decl(s);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE &&
+            !(walk(s->get_width_start()) &&
+              walk(s->get_width_end()) &&
+              walk(s->get_init_value()))) {
+          return false;
+        }
+        return derived().post_decl(s) != VISIT_STOP;
+      }
+
+      case STATEMENT_ALWAYS: {
+        auto s = static_cast<const always_stmt*>(stmt);
+        visit_result pre = derived().pre_always(s);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE && !walk(s->get_statement())) {
+          return false;
+        }
+        return derived().post_always(s) != VISIT_STOP;
+      }
+
+      case STATEMENT_BEGIN: {
+        auto s = static_cast<const begin_stmt*>(stmt);
+        visit_result pre = derived().pre_begin(s);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE) {
+          for (auto sub : s->get_statements()) {
+            if (!walk(sub)) {
+              return false;
+            }
+          }
+        }
+        return derived().post_begin(s) != VISIT_STOP;
+      }
+
+      case STATEMENT_IF: {
+        auto s = static_cast<const if_stmt*>(stmt);
+        visit_result pre = derived().pre_if(s);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE &&
+            !(walk(s->get_condition()) &&
+              walk(s->get_if_exe()) &&
+              walk(s->get_else_exe()))) {
+          return false;
+        }
+        return derived().post_if(s) != VISIT_STOP;
+      }
+
+      case STATEMENT_ASSIGN: {
+        auto s = static_cast<const assign_stmt*>(stmt);
+        visit_result pre = derived().pre_assign(s);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE && !(walk(s->get_lhs()) && walk(s->get_rhs()))) {
+          return false;
+        }
+        return derived().post_assign(s) != VISIT_STOP;
+      }
+
+      case STATEMENT_CASE: {
+        auto s = static_cast<const case_stmt*>(stmt);
+        visit_result pre = derived().pre_case(s);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE) {
+          for (auto& c : s->get_cases()) {
+            if (!(walk(c.first) && walk(c.second))) {
+              return false;
+            }
+          }
+          if (!walk(s->get_default())) {
+            return false;
+          }
+        }
+        return derived().post_case(s) != VISIT_STOP;
+      }
+
+      case STATEMENT_EMPTY: {
+        auto s = static_cast<const empty_stmt*>(stmt);
+        return (derived().pre_empty(s) != VISIT_STOP) &&
+          (derived().post_empty(s) != VISIT_STOP);
+      }
+
+      case STATEMENT_MODULE_INSTANTIATION: {
+        auto s = static_cast<const module_instantiation_stmt*>(stmt);
+        visit_result pre = derived().pre_module_instantiation(s);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE) {
+          for (auto& pa : s->get_port_assignments()) {
+            if (!walk(pa.second)) {
+              return false;
+            }
+          }
+        }
+        return derived().post_module_instantiation(s) != VISIT_STOP;
+      }
+
+      case STATEMENT_BLOCKING_ASSIGN: {
+        auto s = static_cast<const blocking_assign_stmt*>(stmt);
+        visit_result pre = derived().pre_blocking_assign(s);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE && !(walk(s->get_lhs()) && walk(s->get_rhs()))) {
+          return false;
+        }
+        return derived().post_blocking_assign(s) != VISIT_STOP;
+      }
+
+      case STATEMENT_NON_BLOCKING_ASSIGN: {
+        auto s = static_cast<const non_blocking_assign_stmt*>(stmt);
+        visit_result pre = derived().pre_non_blocking_assign(s);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE && !(walk(s->get_lhs()) && walk(s->get_rhs()))) {
+          return false;
+        }
+        return derived().post_non_blocking_assign(s) != VISIT_STOP;
+      }
+
+      case STATEMENT_CALL: {
+        auto s = static_cast<const call_stmt*>(stmt);
+        visit_result pre = derived().pre_call(s);
+        if (pre == VISIT_STOP) {
+          return false;
+        }
+        if (pre == VISIT_CONTINUE) {
+          for (auto arg : s->get_args()) {
+            if (!walk(arg)) {
+              return false;
+            }
+          }
+        }
+        return derived().post_call(s) != VISIT_STOP;
+      }
+
+      default:
+        assert(false);
+        return false;
+      }
+    }
+
+    // Ports first, then the body
+    bool walk(const verilog_module& mod) {
+      for (auto port : mod.get_ports()) {
+        if (!walk(port)) {
+          return false;
+        }
+      }
+
+      for (auto stmt : mod.get_statements()) {
+        if (!walk(stmt)) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+  };
+
+  // CRTP rewriter. Children are rewritten first, then the node's
+  // rewrite_* hook is called on a node holding the new children and
+  // returns the node that replaces it (the node itself by default).
+  // Nodes whose children are all unchanged are kept, the others are
+  // rebuilt, so untouched subtrees are shared with the input. Rebuilt
+  // nodes are not hash-consed.
+  //
+  // enter_expression / enter_statement returning false leaves a whole
+  // subtree as it is.
+  template<typename Derived>
+  class ast_mutator {
+
+    Derived& derived() { return *static_cast<Derived*>(this); }
+
+  public:
+
+    bool enter_expression(const expression*) { return true; }
+    bool enter_statement(const statement*) { return true; }
+
+    expression* rewrite_expression(expression* e) { return e; }
+    statement* rewrite_statement(statement* s) { return s; }
+
+    expression* rewrite_id(id_expr* e) { return derived().rewrite_expression(e); }
+    expression* rewrite_num(num_expr* e) { return derived().rewrite_expression(e); }
+    expression* rewrite_float(float_expr* e) { return derived().rewrite_expression(e); }
+    expression* rewrite_string_literal(string_literal_expr* e) { return derived().rewrite_expression(e); }
+    expression* rewrite_slice(slice_expr* e) { return derived().rewrite_expression(e); }
+    expression* rewrite_unop(unop_expr* e) { return derived().rewrite_expression(e); }
+    expression* rewrite_binop(binop_expr* e) { return derived().rewrite_expression(e); }
+    expression* rewrite_trinop(trinop_expr* e) { return derived().rewrite_expression(e); }
+    expression* rewrite_concat(concat_expr* e) { return derived().rewrite_expression(e); }
+
+    statement* rewrite_decl(decl_stmt* s) { return derived().rewrite_statement(s); }
+    statement* rewrite_always(always_stmt* s) { return derived().rewrite_statement(s); }
+    statement* rewrite_begin(begin_stmt* s) { return derived().rewrite_statement(s); }
+    statement* rewrite_if(if_stmt* s) { return derived().rewrite_statement(s); }
+    statement* rewrite_assign(assign_stmt* s) { return derived().rewrite_statement(s); }
+    statement* rewrite_case(case_stmt* s) { return derived().rewrite_statement(s); }
+    statement* rewrite_empty(empty_stmt* s) { return derived().rewrite_statement(s); }
+    statement* rewrite_module_instantiation(module_instantiation_stmt* s) { return derived().rewrite_statement(s); }
+    statement* rewrite_blocking_assign(blocking_assign_stmt* s) { return derived().rewrite_statement(s); }
+    statement* rewrite_non_blocking_assign(non_blocking_assign_stmt* s) { return derived().rewrite_statement(s); }
+    statement* rewrite_call(call_stmt* s) { return derived().rewrite_statement(s); }
+
+    expression* rewrite(expression* expr) {
+      if (expr == nullptr || !derived().enter_expression(expr)) {
+        return expr;
+      }
+
+      switch (expr->get_type()) {
+      case EXPRESSION_ID:
+        return derived().rewrite_id(static_cast<id_expr*>(expr));
+
+      case EXPRESSION_NUM:
+        return derived().rewrite_num(static_cast<num_expr*>(expr));
+
+      case EXPRESSION_FLOAT:
+        return derived().rewrite_float(static_cast<float_expr*>(expr));
+
+      case EXPRESSION_STRING_LITERAL:
+        return derived().rewrite_string_literal(static_cast<string_literal_expr*>(expr));
+
+      case EXPRESSION_SLICE: {
+        auto e = static_cast<slice_expr*>(expr);
+        expression* arg = rewrite(e->get_arg());
+        expression* start = rewrite(e->get_start());
+        expression* end =
+          e->get_end() == e->get_start() ? start : rewrite(e->get_end());
+        if (arg != e->get_arg() || start != e->get_start() || end != e->get_end()) {
+          e = new slice_expr(arg, start, end);
+        }
+        return derived().rewrite_slice(e);
+      }
+
+      case EXPRESSION_UNOP: {
+        auto e = static_cast<unop_expr*>(expr);
+        expression* op0 = rewrite(e->get_op0());
+        if (op0 != e->get_op0()) {
+          e = new unop_expr(e->get_op(), op0);
+        }
+        return derived().rewrite_unop(e);
+      }
+
+      case EXPRESSION_BINOP: {
+        auto e = static_cast<binop_expr*>(expr);
+        expression* op0 = rewrite(e->get_op0());
+        expression* op1 = rewrite(e->get_op1());
+        if (op0 != e->get_op0() || op1 != e->get_op1()) {
+          e = new binop_expr(e->get_op(), op0, op1);
+        }
+        return derived().rewrite_binop(e);
+      }
+
+      case EXPRESSION_TRINOP: {
+        auto e = static_cast<trinop_expr*>(expr);
+        expression* op0 = rewrite(e->get_op0());
+        expression* op1 = rewrite(e->get_op1());
+        expression* op2 = rewrite(e->get_op2());
+        if (op0 != e->get_op0() || op1 != e->get_op1() || op2 != e->get_op2()) {
+          e = new trinop_expr(e->get_op(), op0, op1, op2);
+        }
+        return derived().rewrite_trinop(e);
+      }
+
+      case EXPRESSION_CONCAT: {
+        auto e = static_cast<concat_expr*>(expr);
+        expression_list exprs;
+        bool changed = false;
+        for (auto sub : e->get_exprs()) {
+          exprs.push_back(rewrite(sub));
+          changed = changed || (exprs.back() != sub);
+        }
+        if (changed) {
+          e = new concat_expr(std::move(exprs));
+        }
+        return derived().rewrite_concat(e);
+      }
+
+      default:
+        assert(false);
+        return expr;
+      }
+    }
+
+    statement* rewrite(statement* stmt) {
+      if (stmt == nullptr || !derived().enter_statement(stmt)) {
+        return stmt;
+      }
+
+      switch (stmt->get_type()) {
+      case STATEMENT_DECL: {
+        auto s = static_cast<decl_stmt*>(stmt);
+        expression* w_start = rewrite(s->get_width_start());
+        expression* w_end = rewrite(s->get_width_end());
+        expression* init_value = rewrite(s->get_init_value());
+        if (w_start != s->get_width_start() ||
+            w_end != s->get_width_end() ||
+            init_value != s->get_init_value()) {
+          s = new decl_stmt(s->get_category(),
+                            s->get_storage_type(),
+                            w_start,
+                            w_end,
+                            s->get_name(),
+                            init_value);
+        }
+        return derived().rewrite_decl(s);
+      }
+
+      case STATEMENT_ALWAYS: {
+        auto s = static_cast<always_stmt*>(stmt);
+        statement* body = rewrite(s->get_statement());
+        if (body != s->get_statement()) {
+          s = new always_stmt(s->get_sensitivity_list(), body);
+        }
+        return derived().rewrite_always(s);
+      }
+
+      case STATEMENT_BEGIN: {
+        auto s = static_cast<begin_stmt*>(stmt);
+        statement_list stmts;
+        bool changed = false;
+        for (auto sub : s->get_statements()) {
+          stmts.push_back(rewrite(sub));
+          changed = changed || (stmts.back() != sub);
+        }
+        if (changed) {
+          s = new begin_stmt(std::move(stmts));
+        }
+        return derived().rewrite_begin(s);
+      }
+
+      case STATEMENT_IF: {
+        auto s = static_cast<if_stmt*>(stmt);
+        expression* condition = rewrite(s->get_condition());
+        statement* if_exe = rewrite(s->get_if_exe());
+        statement* else_exe = rewrite(s->get_else_exe());
+        if (condition != s->get_condition() ||
+            if_exe != s->get_if_exe() ||
+            else_exe != s->get_else_exe()) {
+          s = new if_stmt(condition, if_exe, else_exe);
+        }
+        return derived().rewrite_if(s);
+      }
+
+      case STATEMENT_ASSIGN: {
+        auto s = static_cast<assign_stmt*>(stmt);
+        expression* lhs = rewrite(s->get_lhs());
+        expression* rhs = rewrite(s->get_rhs());
+        if (lhs != s->get_lhs() || rhs != s->get_rhs()) {
+          s = new assign_stmt(lhs, rhs);
+        }
+        return derived().rewrite_assign(s);
+      }
+
+      case STATEMENT_CASE: {
+        auto s = static_cast<case_stmt*>(stmt);
+        case_list cases;
+        bool changed = false;
+        for (auto& c : s->get_cases()) {
+          cases.push_back({rewrite(c.first), rewrite(c.second)});
+          changed = changed ||
+            (cases.back().first != c.first) ||
+            (cases.back().second != c.second);
+        }
+        statement* default_stmt = rewrite(s->get_default());
+        if (changed || default_stmt != s->get_default()) {
+          s = new case_stmt(std::move(cases), default_stmt);
+        }
+        return derived().rewrite_case(s);
+      }
+
+      case STATEMENT_EMPTY:
+        return derived().rewrite_empty(static_cast<empty_stmt*>(stmt));
+
+      case STATEMENT_MODULE_INSTANTIATION: {
+        auto s = static_cast<module_instantiation_stmt*>(stmt);
+        std::vector<std::pair<std::string, expression*> > port_assignments;
+        bool changed = false;
+        for (auto& pa : s->get_port_assignments()) {
+          port_assignments.push_back({pa.first, rewrite(pa.second)});
+          changed = changed || (port_assignments.back().second != pa.second);
+        }
+        if (changed) {
+          s = new module_instantiation_stmt(s->get_module_type(),
+                                            s->get_name(),
+                                            port_assignments);
+        }
+        return derived().rewrite_module_instantiation(s);
+      }
+
+      case STATEMENT_BLOCKING_ASSIGN: {
+        auto s = static_cast<blocking_assign_stmt*>(stmt);
+        expression* lhs = rewrite(s->get_lhs());
+        expression* rhs = rewrite(s->get_rhs());
+        if (lhs != s->get_lhs() || rhs != s->get_rhs()) {
+          s = new blocking_assign_stmt(lhs, rhs);
+        }
+        return derived().rewrite_blocking_assign(s);
+      }
+
+      case STATEMENT_NON_BLOCKING_ASSIGN: {
+        auto s = static_cast<non_blocking_assign_stmt*>(stmt);
+        expression* lhs = rewrite(s->get_lhs());
+        expression* rhs = rewrite(s->get_rhs());
+        if (lhs != s->get_lhs() || rhs != s->get_rhs()) {
+          s = new non_blocking_assign_stmt(lhs, rhs);
+        }
+        return derived().rewrite_non_blocking_assign(s);
+      }
+
+      case STATEMENT_CALL: {
+        auto s = static_cast<call_stmt*>(stmt);
+        expression_list args;
+        bool changed = false;
+        for (auto arg : s->get_args()) {
+          args.push_back(rewrite(arg));
+          changed = changed || (args.back() != arg);
+        }
+        if (changed) {
+          s = new call_stmt(s->get_name(), std::move(args));
+        }
+        return derived().rewrite_call(s);
+      }
+
+      default:
+        assert(false);
+        return stmt;
+      }
+    }
+
+    // Rewrites the module's ports and statements in place. Ports must
+    // stay declarations.
+    void rewrite(verilog_module& mod) {
+      for (unsigned i = 0; i < mod.get_ports().size(); i++) {
+        statement* port = rewrite(static_cast<statement*>(mod.get_ports()[i]));
+        assert(port->get_type() == STATEMENT_DECL);
+        mod.set_port(i, static_cast<decl_stmt*>(port));
+      }
+
+      std::vector<statement*> stmts = mod.get_statements();
+      for (unsigned i = 0; i < stmts.size(); i++) {
+        mod.set_statement(i, rewrite(stmts[i]));
+      }
+    }
+  };
+
+}
@@ -0,0 +1,194 @@
+#include "catch.hpp"
+
+#include "algorithm.h"
+
+#include <string>
+
+using namespace afk;
+using namespace std;
+
+namespace vparser {
+
+  // Instances that share a net are connected
+  class net_instance {
+  public:
+    unsigned a;
+    unsigned b;
+  };
+
+  static vector<net_instance> random_instances(const int n, const unsigned num_nets) {
+    vector<net_instance> insts;
+    unsigned state = 12345;
+    auto next = [&state]() {
+      state = state*1103515245u + 12345u;
+      return state >> 8;
+    };
+    for (int i = 0; i < n; i++) {
+      insts.push_back({next() % num_nets, next() % num_nets});
+    }
+    return insts;
+  }
+
+  static bool share_net(const net_instance& x, const net_instance& y) {
+    return (x.a == y.a) || (x.a == y.b) || (x.b == y.a) || (x.b == y.b);
+  }
+
+  // Components as dfs_by finds them, sorted to compare with union_find::sets
+  static vector<vector<unsigned> >
+  dfs_components(const vector<net_instance>& insts) {
+    vector<vector<unsigned> > comps;
+    vector<unsigned> inds(insts.size());
+    iota(begin(inds), end(inds), 0);
+    while (inds.size() > 0) {
+      comps.push_back(dfs_by(inds, insts, share_net));
+      sort(begin(comps.back()), end(comps.back()));
+    }
+    sort(begin(comps), end(comps));
+    return comps;
+  }
+
+  TEST_CASE("union_find joins sets") {
+    union_find sets(6);
+    REQUIRE(sets.unite(0, 3));
+    REQUIRE(sets.unite(4, 3));
+    REQUIRE(!sets.unite(0, 4));
+    REQUIRE(sets.unite(5, 1));
+
+    REQUIRE(sets.same_set(0, 4));
+    REQUIRE(!sets.same_set(0, 1));
+
+    vector<vector<unsigned> > expected{{0, 3, 4}, {1, 5}, {2}};
+    REQUIRE(sets.sets() == expected);
+  }
+
+  TEST_CASE("Connected components agree with depth first search") {
+    for (unsigned num_nets : {20u, 300u, 2000u}) {
+      vector<net_instance> insts = random_instances(600, num_nets);
+      vector<vector<unsigned> > expected = dfs_components(insts);
+
+      auto by_pred = connected_components_by(insts, share_net);
+      sort(begin(by_pred), end(by_pred));
+      REQUIRE(by_pred == expected);
+
+      // Adjacency through the instances on each net
+      vector<vector<unsigned> > on_net(num_nets);
+      for (unsigned i = 0; i < insts.size(); i++) {
+        on_net[insts[i].a].push_back(i);
+        on_net[insts[i].b].push_back(i);
+      }
+      vector<vector<unsigned> > adjacency(insts.size());
+      vector<pair<unsigned, unsigned> > edges;
+      for (auto& insts_on_net : on_net) {
+        for (unsigned k = 1; k < insts_on_net.size(); k++) {
+          adjacency[insts_on_net[k]].push_back(insts_on_net[0]);
+          edges.push_back({insts_on_net[k - 1], insts_on_net[k]});
+        }
+      }
+
+      auto by_adj = connected_components(adjacency);
+      sort(begin(by_adj), end(by_adj));
+      REQUIRE(by_adj == expected);
+
+      auto by_edges = connected_components(insts.size(), edges);
+      sort(begin(by_edges), end(by_edges));
+      REQUIRE(by_edges == expected);
+    }
+  }
+
+  TEST_CASE("Connected components of elements") {
+    vector<int> elems{1, 2, 10, 11, 3, 20};
+    auto close = [](const int x, const int y) { return abs(x - y) <= 1; };
+
+    vector<vector<int> > expected{{1, 2, 3}, {10, 11}, {20}};
+    REQUIRE(connected_components_by_elems(elems, close) == expected);
+    REQUIRE(connected_components_by(vector<int>(), close).empty());
+  }
+
+  TEST_CASE("subtract on index lists") {
+    vector<unsigned> a(100);
+    iota(begin(a), end(a), 0);
+    vector<unsigned> b;
+    for (unsigned i = 0; i < 100; i += 3) {
+      b.push_back(99 - i);
+    }
+
+    subtract(a, b);
+    REQUIRE(a.size() == 66);
+    REQUIRE(a.front() == 1);
+    REQUIRE(!elem(99u, a));
+  }
+
+  TEST_CASE("Lazy views compose without evaluating early") {
+    vector<int> elems{1, 2, 3, 4, 5, 6};
+
+    int calls = 0;
+    auto square = [&calls](const int e) { calls++; return e*e; };
+    auto even = [](const int e) { return e % 2 == 0; };
+
+    auto squares = view::map(view::filter(elems, even), square);
+    REQUIRE(calls == 0);
+
+    vector<int> expected{4, 16, 36};
+    REQUIRE(view::to_vector(squares) == expected);
+    REQUIRE(calls == 3);
+
+    // Each pass evaluates again
+    REQUIRE(view::to_vector(squares) == expected);
+    REQUIRE(calls == 6);
+
+    REQUIRE(afk::all_of(view::filter(elems, even), even));
+    auto none = view::filter(elems, [](const int e) { return e > 100; });
+    REQUIRE(none.begin() == none.end());
+  }
+
+  TEST_CASE("zip and enumerate refer to the elements") {
+    vector<string> names{"a", "b", "c"};
+    set<int> widths{8, 16};
+
+    vector<string> zipped;
+    for (auto p : view::zip(names, widths)) {
+      REQUIRE(&p.first == &names[zipped.size()]);
+      zipped.push_back(p.first + std::to_string(p.second));
+    }
+    vector<string> expected{"a8", "b16"};
+    REQUIRE(zipped == expected);
+
+    size_t count = 0;
+    for (auto p : view::enumerate(view::map(names, [](const string& n) { return n + n; }))) {
+      REQUIRE(p.first == count);
+      REQUIRE(p.second == names[count] + names[count]);
+      count++;
+    }
+    REQUIRE(count == names.size());
+  }
+
+  TEST_CASE("Eager helpers keep their results") {
+    vector<int> elems{5, 3, 8, 3, 1};
+    vector<int> others{3, 1, 9};
+
+    vector<int> large{5, 3, 8, 3};
+    REQUIRE(select(elems, [](const int e) { return e > 2; }) == large);
+
+    vector<int> common{3, 3, 1};
+    REQUIRE(intersection(elems, others) == common);
+
+    vector<int> diff{5, 8};
+    REQUIRE(difference(elems, others) == diff);
+
+    // inds is no longer sorted in place
+    const vector<unsigned> inds{4, 0, 2};
+    const vector<unsigned> inds_before = inds;
+    vector<int> selected{5, 8, 1};
+    vector<int> not_selected{3, 3};
+    REQUIRE(select_indexes(elems, inds) == selected);
+    REQUIRE(copy_not_indexes(elems, inds) == not_selected);
+    REQUIRE(inds == inds_before);
+
+    REQUIRE(elem(8, elems));
+    REQUIRE(!elem(7, elems));
+
+    vector<vector<int> > nested{{1, 2}, {3}};
+    REQUIRE(num_elems(nested) == 3);
+  }
+
+}
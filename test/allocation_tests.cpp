@@ -0,0 +1,192 @@
+#include "catch.hpp"
+
+#include "algorithm.h"
+#include "ast_memory.h"
+#include "macro_def.h"
+#include "printer.h"
+#include "tokenize.h"
+#include "visitor.h"
+
+#include <fstream>
+
+#include "heap_counters.h"
+
+using namespace std;
+
+namespace vparser {
+
+  // Counted by the operator new in bench/heap_counters.cpp
+  static long num_allocations() {
+    return get_heap_counters().allocations;
+  }
+
+  // Touches every node and every string in the tree
+  class full_walker : public ast_visitor<full_walker> {
+  public:
+    size_t chars;
+
+    full_walker() : chars(0) {}
+
+    visit_result pre_id(const id_expr* e) {
+      chars += e->get_name().size();
+      return VISIT_CONTINUE;
+    }
+
+    visit_result pre_num(const num_expr* e) {
+      chars += e->get_value().size();
+      return VISIT_CONTINUE;
+    }
+
+    visit_result pre_decl(const decl_stmt* s) {
+      chars += s->get_name().size() + s->get_category().size();
+      return VISIT_CONTINUE;
+    }
+
+    visit_result pre_module_instantiation(const module_instantiation_stmt* s) {
+      chars += s->get_module_type().size() + s->get_name().size();
+      for (auto& pa : s->get_port_assignments()) {
+        chars += pa.first.size();
+      }
+      return VISIT_CONTINUE;
+    }
+  };
+
+  TEST_CASE("Walking the full tree of top.v allocates nothing") {
+    std::ifstream t("./test/samples/top.v");
+    std::string str((std::istreambuf_iterator<char>(t)),
+                    std::istreambuf_iterator<char>());
+    verilog_module vm = parse_module(preprocess_code(str).text);
+
+    long before = num_allocations();
+
+    full_walker walker;
+    bool finished = walker.walk(vm);
+
+    for (auto& name : vm.port_names()) {
+      walker.chars += name.size();
+    }
+
+    long allocs = num_allocations() - before;
+
+    // Parsing allocated, so the counter is live
+    REQUIRE(before > 0);
+    REQUIRE(finished);
+    REQUIRE(walker.chars > 0);
+    REQUIRE(allocs == 0);
+  }
+
+  TEST_CASE("Allocations while parsing top.v") {
+    std::ifstream t("./test/samples/top.v");
+    std::string str((std::istreambuf_iterator<char>(t)),
+                    std::istreambuf_iterator<char>());
+    string text = preprocess_code(str).text;
+    vector<token> toks = tokenize(text);
+
+    long before = num_allocations();
+    {
+      token_stream ts(toks);
+      verilog_module vm = parse_module(ts);
+    }
+    long allocs = num_allocations() - before;
+
+    cout << "Allocations parsing top.v: " << allocs << " for "
+         << toks.size() << " tokens" << endl;
+
+    // Parsing used to copy token text and child vectors, which took
+    // more allocations than there are tokens
+    REQUIRE(allocs > 0);
+    REQUIRE(allocs < (long) toks.size());
+  }
+
+  TEST_CASE("Printing top.v into a reused buffer allocates nothing") {
+    std::ifstream t("./test/samples/top.v");
+    std::string str((std::istreambuf_iterator<char>(t)),
+                    std::istreambuf_iterator<char>());
+    verilog_module vm = parse_module(preprocess_code(str).text);
+
+    output_buffer out;
+    ast_printer printer(out);
+    printer.print(vm);
+    size_t first_size = out.size();
+
+    long before = num_allocations();
+    out.clear();
+    printer.print(vm);
+    long allocs = num_allocations() - before;
+
+    REQUIRE(out.size() == first_size);
+    REQUIRE(allocs == 0);
+  }
+
+  TEST_CASE("Iterating composed views allocates nothing") {
+    std::vector<std::string> names;
+    for (int i = 0; i < 100; i++) {
+      names.push_back("a_long_signal_name_" + std::to_string(i));
+    }
+
+    long before = num_allocations();
+    size_t total = 0;
+    auto long_names = afk::view::filter(names, [](const std::string& n) {
+        return n.size() > 20;
+      });
+    for (auto p : afk::view::enumerate(afk::view::map(long_names, [](const std::string& n) {
+            return n.size();
+          }))) {
+      total += p.first*p.second;
+    }
+    long allocs = num_allocations() - before;
+
+    REQUIRE(total > 0);
+    REQUIRE(allocs == 0);
+  }
+
+  TEST_CASE("The sample corpus stays within its AST memory budget") {
+    vector<string> texts;
+    for (auto& name : {"cb_unq1.v", "cb_unq2.v", "cb_unq3.v", "cb_unq4.v",
+          "mem_unq1.v", "memory_core_unq1.v", "memory_tile_unq1.v",
+          "pe_tile_new_unq1.v", "pe_tile_new_unq2.v", "sb_unq1.v",
+          "sb_unq2.v", "sb_unq3.v", "sb_unq4.v", "sb_unq5.v", "top.v"}) {
+      std::ifstream t(string("./test/samples/") + name);
+      texts.push_back(std::string((std::istreambuf_iterator<char>(t)),
+                                  std::istreambuf_iterator<char>()));
+    }
+
+    // The module objects are accounted for too
+    reset_heap_peak();
+    heap_counters before = get_heap_counters();
+
+    vector<verilog_module> modules;
+    modules.reserve(texts.size());
+
+    for (auto& text : texts) {
+      modules.push_back(parse_module(preprocess_code(text).text));
+    }
+
+    heap_counters after = get_heap_counters();
+    long peak = after.peak_live_bytes - before.live_bytes;
+    long live = after.live_bytes - before.live_bytes;
+
+    ast_memory_accounting accounting;
+    for (auto& mod : modules) {
+      accounting.add(mod);
+    }
+    long ast_bytes = accounting.get_report().total_bytes();
+
+    cout << "Sample corpus AST: " << ast_bytes << " bytes accounted, "
+         << live << " live heap bytes, " << peak << " peak heap bytes" << endl;
+    cout << accounting.get_report().to_string();
+
+    // Everything accounted for is on the heap, and little of the heap
+    // is missed
+    REQUIRE(ast_bytes <= live);
+    REQUIRE(ast_bytes >= 0.8*live);
+
+    // Budgets about 10% above the current layout with libstdc++, whose
+    // strings are as large as any and keep the fewest characters inline.
+    // Lower them when a change shrinks the AST, raise them only on
+    // purpose.
+    REQUIRE(ast_bytes <= 2450000);
+    REQUIRE(peak <= 8750000);
+  }
+
+}
@@ -0,0 +1,120 @@
+#include "catch.hpp"
+
+#include "ast_file.h"
+#include "macro_def.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace vparser {
+
+  string test_ast_path(const string& name) {
+    return "/tmp/vparser-" + name + "-" + std::to_string(getpid()) + ".vast";
+  }
+
+  TEST_CASE("Binary AST files round trip every sample") {
+    vector<string> paths = {
+      "./test/samples/cb_unq1.v",
+      "./test/samples/cb_unq2.v",
+      "./test/samples/cb_unq3.v",
+      "./test/samples/cb_unq4.v",
+      "./test/samples/mem_unq1.v",
+      "./test/samples/memory_core_unq1.v",
+      "./test/samples/memory_tile_unq1.v",
+      "./test/samples/pe_tile_new_unq1.v",
+      "./test/samples/pe_tile_new_unq2.v",
+      "./test/samples/sb_unq1.v",
+      "./test/samples/sb_unq2.v",
+      "./test/samples/sb_unq3.v",
+      "./test/samples/sb_unq4.v",
+      "./test/samples/sb_unq5.v",
+      "./test/samples/top.v"};
+
+    flat_ast ast;
+    vector<string> expected;
+    for (auto& path : paths) {
+      std::ifstream t(path);
+      std::string str((std::istreambuf_iterator<char>(t)),
+                      std::istreambuf_iterator<char>());
+
+      verilog_module vm = parse_module(preprocess_code(str).text);
+      ast.add_module(vm);
+      expected.push_back(vm.to_string());
+    }
+
+    string file = test_ast_path("round-trip");
+    REQUIRE(write_ast_file(file, ast.view()));
+
+    mapped_ast mapped;
+    REQUIRE(mapped.open(file));
+
+    const flat_ast_view& view = mapped.get_view();
+    REQUIRE(view.modules.size() == paths.size());
+    REQUIRE(view.num_nodes() == ast.view().num_nodes());
+
+    for (unsigned i = 0; i < expected.size(); i++) {
+      verilog_module vm = view.to_module(i);
+      REQUIRE(vm.to_string() == expected[i]);
+    }
+
+    remove(file.c_str());
+  }
+
+  TEST_CASE("Invalid binary AST files are rejected") {
+    flat_ast ast;
+    verilog_module vm =
+      parse_module("module m(input a, output b); assign b = ~a; endmodule");
+    ast.add_module(vm);
+
+    string data = serialize_flat_ast(ast.view());
+    string file = test_ast_path("invalid");
+
+    SECTION("Valid data loads") {
+      vector<uint64_t> buf(data.size() / 8 + 1);
+      memcpy(buf.data(), data.data(), data.size());
+
+      flat_ast_view view;
+      REQUIRE(load_flat_ast_view((const char*) buf.data(), data.size(), view));
+      REQUIRE(view.to_module(0).to_string() == vm.to_string());
+    }
+
+    SECTION("Truncated file") {
+      data.resize(data.size() - 1);
+    }
+
+    SECTION("Wrong magic") {
+      data[0] = 'X';
+    }
+
+    SECTION("Wrong version") {
+      ast_file_header header;
+      memcpy(&header, data.data(), sizeof(header));
+      header.version = ast_file_version + 1;
+      memcpy(&data[0], &header, sizeof(header));
+    }
+
+    SECTION("Flipped bit in a section") {
+      data[data.size() - 1] ^= 1;
+    }
+
+    {
+      ofstream out(file, ios::out | ios::binary);
+      out.write(data.data(), data.size());
+    }
+
+    mapped_ast mapped;
+    bool valid = mapped.open(file);
+    REQUIRE(valid == (data == serialize_flat_ast(ast.view())));
+
+    remove(file.c_str());
+
+    mapped_ast missing;
+    REQUIRE(!missing.open(file));
+  }
+
+}
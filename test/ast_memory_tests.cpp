@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include "ast_memory.h"
+#include "macro_def.h"
+#include "parse.h"
+
+#include <fstream>
+
+using namespace std;
+
+namespace vparser {
+
+  TEST_CASE("Memory report counts each node class") {
+    verilog_module vm =
+      parse_module("module m(input a); assign x = a + b; always @(posedge clk) begin y <= x; end endmodule");
+
+    ast_memory_report report = ast_memory(vm);
+
+    REQUIRE(report.modules.count == 1);
+    REQUIRE(report.statements[STATEMENT_DECL].count == 1);
+    REQUIRE(report.statements[STATEMENT_ASSIGN].count == 1);
+    REQUIRE(report.statements[STATEMENT_ALWAYS].count == 1);
+    REQUIRE(report.statements[STATEMENT_BEGIN].count == 1);
+    REQUIRE(report.statements[STATEMENT_NON_BLOCKING_ASSIGN].count == 1);
+    REQUIRE(report.expressions[EXPRESSION_BINOP].count == 1);
+    REQUIRE(report.expressions[EXPRESSION_ID].count == 5);
+
+    REQUIRE(report.expressions[EXPRESSION_BINOP].object_bytes == sizeof(binop_expr));
+    REQUIRE(report.statements[STATEMENT_ALWAYS].object_bytes == sizeof(always_stmt));
+    REQUIRE(report.num_nodes() == 11);
+  }
+
+  TEST_CASE("Memory report counts owned strings and child lists") {
+    string long_name(100, 'n');
+    verilog_module vm =
+      parse_module("module m(); assign " + long_name + " = {a, b, c, d}; endmodule");
+
+    ast_memory_report report = ast_memory(vm);
+
+    // One string too long for the small string buffer
+    REQUIRE(report.expressions[EXPRESSION_ID].payload_bytes == long_name.size() + 1);
+
+    // Four operands spill the concat's inline list
+    REQUIRE(report.expressions[EXPRESSION_CONCAT].payload_bytes >= 4*sizeof(expression*));
+
+    REQUIRE(report.total_bytes() > report.num_nodes()*sizeof(expression));
+  }
+
+  TEST_CASE("Shared nodes are accounted once") {
+    verilog_module vm = parse_module("module m(); assign x = a[i]; endmodule");
+
+    // The slice uses i as both its start and end
+    ast_memory_report report = ast_memory(vm);
+    REQUIRE(report.expressions[EXPRESSION_SLICE].count == 1);
+    REQUIRE(report.expressions[EXPRESSION_ID].count == 3);
+
+    std::ifstream t("./test/samples/sb_unq1.v");
+    std::string str((std::istreambuf_iterator<char>(t)),
+                    std::istreambuf_iterator<char>());
+
+    expression_interner interner;
+    verilog_module interned = parse_module(preprocess_code(str).text, interner);
+
+    ast_memory_report interned_report = ast_memory(interned);
+    uint64_t expression_bytes = 0;
+    for (auto& mem : interned_report.expressions) {
+      expression_bytes += mem.bytes();
+    }
+    REQUIRE(expression_bytes == interner.memory_bytes());
+  }
+
+  TEST_CASE("Memory reports add up and print") {
+    verilog_module a = parse_module("module a(); assign x = y; endmodule");
+    verilog_module b = parse_module("module b(); assign x = y + z; endmodule");
+
+    ast_memory_report total = ast_memory(a);
+    total.add(ast_memory(b));
+
+    ast_memory_accounting accounting;
+    accounting.add(a);
+    accounting.add(b);
+    REQUIRE(accounting.get_report().total_bytes() == total.total_bytes());
+
+    REQUIRE(total.statements[STATEMENT_ASSIGN].count == 2);
+
+    string table = total.to_string();
+    REQUIRE(table.find("assign_stmt") != string::npos);
+    REQUIRE(table.find("binop_expr") != string::npos);
+    REQUIRE(table.find("case_stmt") == string::npos);
+
+    string json = total.to_json();
+    REQUIRE(json.find("\"binop_expr\": {\"count\": 1,") != string::npos);
+    REQUIRE(json.find("\"total_bytes\": " + std::to_string(total.total_bytes())) != string::npos);
+  }
+
+}
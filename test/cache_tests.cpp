@@ -0,0 +1,278 @@
+#include "catch.hpp"
+
+#include "parse_cache.h"
+#include "preprocess_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace vparser {
+
+  string test_cache_dir(const string& name) {
+    return "/tmp/vparser-" + name + "-" + std::to_string(getpid());
+  }
+
+  TEST_CASE("Preprocessing cache hit returns the stored result") {
+    std::ifstream t("./test/samples/memory_core_unq1.v");
+    std::string str((std::istreambuf_iterator<char>(t)),
+		    std::istreambuf_iterator<char>());
+
+    string dir = test_cache_dir("preprocess-cache");
+    preprocess_cache cache(dir);
+
+    preprocessed_verilog first = preprocess_code(str, cache);
+
+    REQUIRE(cache.num_misses() == 1);
+    REQUIRE(cache.num_hits() == 0);
+
+    preprocessed_verilog second = preprocess_code(str, cache);
+
+    REQUIRE(cache.num_hits() == 1);
+
+    SECTION("Cached result matches a fresh preprocess") {
+      REQUIRE(second.text == first.text);
+      REQUIRE(second.source == first.source);
+      REQUIRE(second.defs.size() == 6);
+      REQUIRE(second.map.get_expansions().size() ==
+              first.map.get_expansions().size());
+    }
+
+    SECTION("Different text is a miss") {
+      preprocess_code(str + "\n", cache);
+
+      REQUIRE(cache.num_misses() == 2);
+
+      remove(cache.entry_path(str + "\n").c_str());
+    }
+
+    remove(cache.entry_path(str).c_str());
+    rmdir(dir.c_str());
+  }
+
+  TEST_CASE("Corrupt preprocessing cache entries are misses") {
+    string str = "module m(); endmodule";
+
+    string dir = test_cache_dir("preprocess-cache-corrupt");
+    preprocess_cache cache(dir);
+
+    string path = cache.entry_path(str);
+    {
+      ofstream out(path);
+      out << "VPPC garbage";
+    }
+
+    preprocessed_verilog prep = preprocess_code(str, cache);
+
+    REQUIRE(cache.num_misses() == 1);
+    REQUIRE(prep.text == " module m ( ) ; endmodule");
+
+    remove(path.c_str());
+    rmdir(dir.c_str());
+  }
+
+  string read_sample(const string& path) {
+    std::ifstream t(path);
+    return string((std::istreambuf_iterator<char>(t)),
+                  std::istreambuf_iterator<char>());
+  }
+
+  TEST_CASE("Parse cache hit maps the stored AST") {
+    string str = read_sample("./test/samples/cb_unq1.v");
+
+    string dir = test_cache_dir("parse-cache");
+    parse_cache cache(dir);
+
+    mapped_ast first;
+    REQUIRE(cache.parse(str, first));
+    REQUIRE(cache.num_misses() == 1);
+    REQUIRE(cache.num_hits() == 0);
+
+    mapped_ast second;
+    REQUIRE(cache.parse(str, second));
+    REQUIRE(cache.num_hits() == 1);
+    REQUIRE(cache.hit_rate() == 0.5);
+
+    verilog_module vm = parse_module(preprocess_code(str).text);
+    REQUIRE(second.get_view().to_module(0).to_string() == vm.to_string());
+    REQUIRE(first.get_view().to_module(0).to_string() == vm.to_string());
+
+    remove(cache.entry_path(str).c_str());
+    rmdir(dir.c_str());
+  }
+
+  TEST_CASE("Parse cache does not store files with errors") {
+    string str = "module m(); assign = ; endmodule";
+
+    string dir = test_cache_dir("parse-cache-errors");
+    parse_cache cache(dir);
+
+    mapped_ast ast;
+    REQUIRE(!cache.parse(str, ast));
+    REQUIRE(!cache.parse(str, ast));
+    REQUIRE(cache.num_misses() == 2);
+    REQUIRE(cache.size_bytes() == 0);
+
+    rmdir(dir.c_str());
+  }
+
+  TEST_CASE("Corrupt parse cache entries are misses") {
+    string str = "module m(); endmodule";
+
+    string dir = test_cache_dir("parse-cache-corrupt");
+    parse_cache cache(dir);
+
+    string path = cache.entry_path(str);
+    {
+      ofstream out(path);
+      out << "VPARSAST garbage";
+    }
+
+    mapped_ast ast;
+    REQUIRE(cache.parse(str, ast));
+    REQUIRE(cache.num_misses() == 1);
+    REQUIRE(ast.get_view().to_module(0).get_name() == "m");
+
+    mapped_ast again;
+    REQUIRE(cache.parse(str, again));
+    REQUIRE(cache.num_hits() == 1);
+
+    remove(path.c_str());
+    rmdir(dir.c_str());
+  }
+
+  TEST_CASE("Parse cache entries with a corrupt node id are misses") {
+    string str = "module m(input a, input b, output c); assign c = a & b; endmodule";
+
+    string dir = test_cache_dir("parse-cache-node-id");
+    parse_cache cache(dir);
+
+    mapped_ast first;
+    REQUIRE(cache.parse(str, first));
+    REQUIRE(cache.num_misses() == 1);
+
+    string path = cache.entry_path(str);
+    string data;
+    {
+      ifstream in(path, ios::in | ios::binary);
+      data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Point the operand of the & far past the end of the id array
+    vector<uint64_t> buf(data.size() / 8 + 1);
+    memcpy(buf.data(), data.data(), data.size());
+    flat_ast_view view;
+    REQUIRE(load_flat_ast_view((const char*) buf.data(), data.size(), view));
+    REQUIRE(view.binop_exprs.size() == 1);
+
+    size_t offset =
+      ((const char*) &view.binop_exprs[0].operand0) - ((const char*) buf.data());
+    node_id bad = make_node_id(EXPRESSION_ID, 1000000);
+    memcpy(&data[offset], &bad, sizeof(bad));
+    {
+      ofstream out(path, ios::out | ios::binary | ios::trunc);
+      out.write(data.data(), data.size());
+    }
+
+    mapped_ast reparsed;
+    REQUIRE(cache.parse(str, reparsed));
+    REQUIRE(cache.num_misses() == 2);
+    REQUIRE(cache.num_hits() == 0);
+
+    verilog_module vm = parse_module(preprocess_code(str).text);
+    REQUIRE(reparsed.get_view().to_module(0).to_string() == vm.to_string());
+
+    // The reparse replaced the entry
+    mapped_ast again;
+    REQUIRE(cache.parse(str, again));
+    REQUIRE(cache.num_hits() == 1);
+
+    remove(path.c_str());
+    rmdir(dir.c_str());
+  }
+
+  TEST_CASE("Parse cache evicts the least recently used entries") {
+    vector<string> texts;
+    for (int i = 0; i < 3; i++) {
+      texts.push_back("module m" + std::to_string(i) +
+                      "(input a, output b); assign b = a; endmodule");
+    }
+
+    string dir = test_cache_dir("parse-cache-lru");
+
+    uint64_t entry_bytes = 0;
+    {
+      parse_cache unlimited(dir);
+      mapped_ast ast;
+      REQUIRE(unlimited.parse(texts[0], ast));
+      entry_bytes = unlimited.size_bytes();
+      remove(unlimited.entry_path(texts[0]).c_str());
+    }
+    REQUIRE(entry_bytes > 0);
+
+    // Room for two entries
+    parse_cache cache(dir, 2*entry_bytes + entry_bytes / 2);
+
+    mapped_ast ast;
+    REQUIRE(cache.parse(texts[0], ast));
+    usleep(20000);
+    REQUIRE(cache.parse(texts[1], ast));
+    usleep(20000);
+
+    // A hit makes texts[0] the most recently used
+    REQUIRE(cache.parse(texts[0], ast));
+    REQUIRE(cache.num_hits() == 1);
+    usleep(20000);
+
+    REQUIRE(cache.parse(texts[2], ast));
+    REQUIRE(cache.size_bytes() <= 2*entry_bytes + entry_bytes / 2);
+
+    REQUIRE(ifstream(cache.entry_path(texts[0])).good());
+    REQUIRE(!ifstream(cache.entry_path(texts[1])).good());
+    REQUIRE(ifstream(cache.entry_path(texts[2])).good());
+
+    for (auto& text : texts) {
+      remove(cache.entry_path(text).c_str());
+    }
+    rmdir(dir.c_str());
+  }
+
+  TEST_CASE("Concurrent parse cache writers leave a valid entry") {
+    string str = read_sample("./test/samples/sb_unq1.v");
+
+    string dir = test_cache_dir("parse-cache-concurrent");
+
+    vector<int> ok(4, 0);
+    vector<std::thread> workers;
+    for (int i = 0; i < 4; i++) {
+      workers.push_back(std::thread([&dir, &str, &ok, i]() {
+            parse_cache cache(dir);
+            mapped_ast ast;
+            ok[i] = cache.parse(str, ast) &&
+              (ast.get_view().modules.size() == 1);
+          }));
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    for (int i = 0; i < 4; i++) {
+      REQUIRE(ok[i] == 1);
+    }
+
+    parse_cache cache(dir);
+    mapped_ast ast;
+    REQUIRE(cache.parse(str, ast));
+    REQUIRE(cache.num_hits() == 1);
+
+    remove(cache.entry_path(str).c_str());
+    rmdir(dir.c_str());
+  }
+
+}
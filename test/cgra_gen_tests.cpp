@@ -0,0 +1,81 @@
+#include "catch.hpp"
+
+#include "cgra_gen.h"
+#include "parse.h"
+
+#include <cstdlib>
+#include <fstream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace vparser {
+
+  static std::string generate_to_string(const cgra_options& options) {
+    char* buf = nullptr;
+    size_t len = 0;
+    FILE* f = open_memstream(&buf, &len);
+    {
+      cgra_output out(f);
+      generate_cgra(options, out);
+    }
+    fclose(f);
+
+    std::string text(buf, len);
+    free(buf);
+    return text;
+  }
+
+  TEST_CASE("Generated CGRA text depends only on the seed") {
+    cgra_options options;
+    options.target_bytes = 1 << 16;
+
+    std::string first = generate_to_string(options);
+    REQUIRE(first.size() >= options.target_bytes);
+    REQUIRE(generate_to_string(options) == first);
+
+    options.seed = 2;
+    REQUIRE(generate_to_string(options) != first);
+  }
+
+  TEST_CASE("Every generated CGRA module parses") {
+    std::string dir = "/tmp/vparser-cgra-" + std::to_string(getpid());
+    mkdir(dir.c_str(), 0755);
+
+    cgra_options options;
+    options.target_bytes = 1 << 17;
+    options.long_expression = 200;
+    options.if_chain = 50;
+    options.concat = 100;
+
+    vector<string> paths;
+    {
+      cgra_output out(dir);
+      REQUIRE(generate_cgra(options, out));
+      paths = out.get_paths();
+    }
+
+    REQUIRE(paths.size() > 10);
+
+    int parsed = 0;
+    for (auto& path : paths) {
+      std::ifstream t(path);
+      std::string str((std::istreambuf_iterator<char>(t)),
+                      std::istreambuf_iterator<char>());
+
+      diagnostic_engine diags;
+      verilog_module vm = parse_module(str, diags);
+      if (!diags.has_errors() && (vm.get_name() != "")) {
+        parsed++;
+      }
+
+      remove(path.c_str());
+    }
+    rmdir(dir.c_str());
+
+    REQUIRE(parsed == (int) paths.size());
+  }
+
+}
@@ -0,0 +1,292 @@
+#include "catch.hpp"
+
+#include "macro_def.h"
+#include "parse.h"
+#include "parse_stats.h"
+#include "printer.h"
+#include "skim.h"
+#include "tokenize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+
+using namespace std;
+
+namespace vparser {
+
+  // Worst-case scaling checks. Each test builds inputs of one shape at
+  // growing sizes, times an entry point on them and fits the exponent k
+  // of time ~ n^k on a log-log scale. Over the 16x size range used here
+  // n log n fits k of about 1.1, quadratic behavior fits 2, so anything
+  // above max_exponent is a complexity regression.
+  //
+  // The tests take several seconds and are tagged hidden, so quick runs
+  // of all-tests skip them. ctest runs them as the complexity test, or
+  // run them with
+  //
+  //   ./all-tests "[complexity]"
+  static const double max_exponent = 1.4;
+
+  static const vector<int> scaling_sizes{4000, 8000, 16000, 32000, 64000};
+
+  // Each timing repeats its input for at least this much CPU time, so
+  // clock resolution and per-call noise stay small next to it
+  static const double min_batch_seconds = 0.02;
+
+  // Thread CPU seconds per call of f, the best of three batches. CPU
+  // time leaves out the time other processes hold the core, and taking
+  // the best batch drops the remaining noise, which only ever adds.
+  static double best_seconds(const std::function<void()>& f) {
+    double best = 1e30;
+    for (int batch = 0; batch < 3; batch++) {
+      uint64_t start = thread_cpu_ns();
+      int calls = 0;
+      double elapsed = 0;
+      do {
+        f();
+        calls++;
+        elapsed = (thread_cpu_ns() - start) * 1e-9;
+      } while (elapsed < min_batch_seconds);
+      best = min(best, elapsed / calls);
+    }
+    return best;
+  }
+
+  // Least squares slope of log(time) against log(size)
+  static double fit_exponent(const vector<double>& sizes,
+                             const vector<double>& times) {
+    double n = sizes.size();
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (int i = 0; i < (int) sizes.size(); i++) {
+      double x = log(sizes[i]);
+      double y = log(max(times[i], 1e-9));
+      sx += x;
+      sy += y;
+      sxx += x*x;
+      sxy += x*y;
+    }
+    return (n*sxy - sx*sy) / (n*sxx - sx*sx);
+  }
+
+  // Times run on make(n) for every n in scaling_sizes, only run is
+  // timed. Returns the fitted exponent.
+  static double
+  scaling_exponent(const string& name,
+                   const std::function<string(const int)>& make,
+                   const std::function<void(const string&)>& run) {
+    vector<string> inputs;
+    for (int n : scaling_sizes) {
+      inputs.push_back(make(n));
+    }
+
+    // Warm the allocator and caches on the largest input
+    run(inputs.back());
+
+    vector<double> sizes, times;
+    for (auto& input : inputs) {
+      sizes.push_back(input.size());
+      times.push_back(best_seconds([&run, &input]() { run(input); }));
+    }
+
+    double k = fit_exponent(sizes, times);
+    cout << "Scaling of " << name << ": n^" << k << ", "
+         << times.back()*1e3 << " ms at " << sizes.back() << " bytes" << endl;
+    return k;
+  }
+
+  // Input shapes, n is roughly the number of tokens
+
+  static string long_line(const int n) {
+    string s = "module m(); assign x = ";
+    for (int i = 0; i < n; i++) {
+      s += "a" + std::to_string(i) + " + ";
+    }
+    return s + "b; endmodule\n";
+  }
+
+  static string many_lines(const int n) {
+    string s = "module m();\n";
+    for (int i = 0; i < n / 4; i++) {
+      s += "  assign x" + std::to_string(i) + " = y;\n";
+    }
+    return s + "endmodule\n";
+  }
+
+  static string huge_comment(const int n) {
+    string s = "/* ";
+    for (int i = 0; i < n; i++) {
+      s += "comment ";
+    }
+    s += "*/\n// ";
+    for (int i = 0; i < n; i++) {
+      s += "line ";
+    }
+    return s + "\nmodule m(); assign x = y; endmodule\n";
+  }
+
+  static string many_macros(const int n) {
+    string s;
+    for (int i = 0; i < n / 8; i++) {
+      s += "`define W" + std::to_string(i) + " (w + " + std::to_string(i) + ")\n";
+    }
+    s += "`define ADD(a, b) a + b\n";
+    s += "module m();\n";
+    for (int i = 0; i < n / 8; i++) {
+      s += "  assign x" + std::to_string(i) + " = `ADD(a, y) + `W" + std::to_string(i) + ";\n";
+    }
+    return s + "endmodule\n";
+  }
+
+  // Short if / else chains in many always blocks. A single long chain
+  // prints indented one level deeper per else, so its output grows as
+  // the square of the input.
+  static string many_ifs(const int n) {
+    string s = "module m();\n";
+    for (int i = 0; i < n / 32; i++) {
+      s += "  always @(*) begin if (s == " + std::to_string(i) + ") x = y; "
+        "else if (t) x = z; else x = w; end\n";
+    }
+    return s + "endmodule\n";
+  }
+
+  static string if_chain(const int n) {
+    string s = "module m(); always @(*) begin\n";
+    for (int i = 0; i < n / 8; i++) {
+      s += (i == 0 ? "  if (s == " : "  else if (s == ") + std::to_string(i) + ") x = y;\n";
+    }
+    return s + "  else x = z;\nend endmodule\n";
+  }
+
+  static string big_concat(const int n) {
+    string s = "module m(); assign x = {";
+    for (int i = 0; i < n / 2; i++) {
+      s += (i == 0 ? "a" : ", a") + std::to_string(i);
+    }
+    return s + "}; endmodule\n";
+  }
+
+  static string ternary_chain(const int n) {
+    string s = "module m(); assign x = ";
+    for (int i = 0; i < n / 6; i++) {
+      s += "(s == " + std::to_string(i) + ") ? a" + std::to_string(i) + " : ";
+    }
+    return s + "b; endmodule\n";
+  }
+
+  static string many_instances(const int n) {
+    string s = "module m();\n";
+    for (int i = 0; i < n / 12; i++) {
+      s += "  sub u" + std::to_string(i) + "(.a(x), .b(y[3:0]));\n";
+    }
+    return s + "endmodule\n";
+  }
+
+  // Every statement has an error, each is recorded and skipped
+  static string many_errors(const int n) {
+    string s = "module m();\n";
+    for (int i = 0; i < n / 4; i++) {
+      s += "  assign = y;\n";
+    }
+    return s + "endmodule\n";
+  }
+
+  static string preprocessed(const string& text) {
+    return preprocess_code(text).text;
+  }
+
+  static void require_scaling(const string& name,
+                              const std::function<string(const int)>& make,
+                              const std::function<void(const string&)>& run) {
+    INFO(name);
+    REQUIRE(scaling_exponent(name, make, run) < max_exponent);
+  }
+
+  TEST_CASE("tokenize scales near linearly", "[.][complexity]") {
+    auto run = [](const string& text) { tokenize(text); };
+
+    require_scaling("tokenize long line", long_line, run);
+    require_scaling("tokenize many lines", many_lines, run);
+    require_scaling("tokenize huge comment", huge_comment, run);
+  }
+
+  TEST_CASE("preprocess_code scales near linearly", "[.][complexity]") {
+    auto run = [](const string& text) { preprocess_code(text); };
+
+    require_scaling("preprocess long line", long_line, run);
+    require_scaling("preprocess many lines", many_lines, run);
+    require_scaling("preprocess huge comment", huge_comment, run);
+    require_scaling("preprocess many macros", many_macros, run);
+  }
+
+  TEST_CASE("parse_module scales near linearly", "[.][complexity]") {
+    auto run = [](const string& text) { parse_module(text); };
+    auto make = [](std::function<string(const int)> shape) {
+      return [shape](const int n) { return preprocessed(shape(n)); };
+    };
+
+    require_scaling("parse_module long operator chain", long_line, run);
+    require_scaling("parse_module many statements", many_lines, run);
+    require_scaling("parse_module many macros", make(many_macros), run);
+    require_scaling("parse_module if chain", if_chain, run);
+    require_scaling("parse_module concatenation", big_concat, run);
+    require_scaling("parse_module ternary chain", ternary_chain, run);
+    require_scaling("parse_module instances", many_instances, run);
+  }
+
+  TEST_CASE("Error recovery scales near linearly", "[.][complexity]") {
+    require_scaling("parse_module many errors", many_errors,
+                    [](const string& text) {
+                      diagnostic_engine diags;
+                      parse_module(text, diags);
+                    });
+  }
+
+  TEST_CASE("Expression and statement entry points scale near linearly", "[.][complexity]") {
+    auto chain = [](const int n) {
+      string s = "a";
+      for (int i = 0; i < n / 2; i++) {
+        s += " + a" + std::to_string(i);
+      }
+      return s;
+    };
+
+    require_scaling("parse_expression long chain", chain,
+                    [](const string& text) { parse_expression(text); });
+
+    require_scaling("parse_statement long assign",
+                    [chain](const int n) { return "assign x = " + chain(n) + ";"; },
+                    [](const string& text) { delete parse_statement(text); });
+  }
+
+  TEST_CASE("Printing and skimming scale near linearly", "[.][complexity]") {
+    // Printed into one reused buffer, as printing many modules does.
+    // to_string's fresh buffer and string are new pages on every call,
+    // and faulting them in costs more per byte as the output grows.
+    // Printing does little work per node, so its cost per byte also
+    // steps up once the AST leaves the cache; the sizes here are all
+    // past that step.
+    output_buffer out;
+    vector<double> sizes, times;
+    for (int n : {32000, 64000, 128000, 256000, 512000}) {
+      verilog_module vm = parse_module(many_ifs(n));
+      sizes.push_back(vm.to_string().size());
+      times.push_back(best_seconds([&vm, &out]() {
+            out.clear();
+            ast_printer(out).print(vm);
+          }));
+    }
+    double k = fit_exponent(sizes, times);
+    cout << "Scaling of print many ifs: n^" << k << endl;
+    INFO("print many ifs");
+    REQUIRE(k < max_exponent);
+
+    require_scaling("skim many instances", many_instances,
+                    [](const string& text) {
+                      hierarchy_graph graph;
+                      skim_hierarchy(tokenize(text), graph);
+                    });
+  }
+
+}
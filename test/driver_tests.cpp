@@ -0,0 +1,192 @@
+#include "catch.hpp"
+
+#include "driver.h"
+#include "macro_def.h"
+#include "tokenize.h"
+
+#include <fstream>
+#include <set>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace vparser {
+
+  static vector<string> driver_samples() {
+    vector<string> names{"cb_unq1.v", "cb_unq2.v", "mem_unq1.v",
+        "memory_core_unq1.v", "memory_tile_unq1.v", "pe_tile_new_unq1.v",
+        "sb_unq1.v", "sb_unq2.v", "top.v"};
+    vector<string> paths;
+    for (auto& name : names) {
+      paths.push_back("./test/samples/" + name);
+    }
+    return paths;
+  }
+
+  static string serial_parse(const string& path) {
+    std::ifstream t(path);
+    std::string str((std::istreambuf_iterator<char>(t)),
+                    std::istreambuf_iterator<char>());
+    return parse_module(preprocess_code(str).text).to_string();
+  }
+
+  TEST_CASE("Parallel parse matches parsing each file alone") {
+    vector<string> paths = driver_samples();
+
+    driver_options options;
+    options.num_threads = 4;
+    vector<parsed_file> files = parse_files(paths, options);
+
+    REQUIRE(files.size() == paths.size());
+    for (int i = 0; i < (int) paths.size(); i++) {
+      REQUIRE(files[i].path == paths[i]);
+      REQUIRE(files[i].ok());
+      REQUIRE(files[i].modules.size() == 1);
+      REQUIRE(files[i].modules[0].to_string() == serial_parse(paths[i]));
+      REQUIRE(files[i].stats.parse.calls == 1);
+    }
+  }
+
+  TEST_CASE("Parse batches share one pool") {
+    vector<string> paths = driver_samples();
+
+    afk::thread_pool pool(3);
+    driver_options options;
+    options.pool = &pool;
+
+    // Two batches at once from tasks already on the pool
+    vector<vector<parsed_file> > batches(2);
+    afk::parallel_for(pool, batches.size(), [&paths, &options, &batches](const size_t i) {
+        batches[i] = parse_files(paths, options);
+      }, nullptr, 1);
+
+    for (auto& files : batches) {
+      REQUIRE(files.size() == paths.size());
+      for (int i = 0; i < (int) paths.size(); i++) {
+        REQUIRE(files[i].ok());
+        REQUIRE(files[i].modules[0].to_string() == serial_parse(paths[i]));
+      }
+    }
+  }
+
+  TEST_CASE("Missing files and parse errors stay with their file") {
+    vector<string> paths{"./test/samples/cb_unq1.v", "./test/samples/no_such_file.v"};
+
+    driver_options options;
+    options.num_threads = 2;
+    vector<parsed_file> files = parse_files(paths, options);
+
+    REQUIRE(files[0].ok());
+    REQUIRE(!files[1].read_ok);
+    REQUIRE(!files[1].ok());
+  }
+
+  TEST_CASE("Files with several modules parse each module") {
+    vector<token> toks =
+      tokenize("module a(); endmodule module b(); assign x = y; endmodule");
+    auto ranges = module_token_ranges(toks);
+
+    REQUIRE(ranges.size() == 2);
+    REQUIRE(toks[ranges[0].first + 1].get_text() == "a");
+    REQUIRE(toks[ranges[1].second].get_text() == "endmodule");
+
+    string path = "/tmp/vparser-driver-" + std::to_string(getpid()) + ".v";
+    {
+      ofstream out(path);
+      out << "module a(); endmodule\nmodule b(); assign x = y; endmodule\n";
+    }
+
+    vector<parsed_file> files = parse_files({path}, driver_options());
+    remove(path.c_str());
+
+    REQUIRE(files[0].ok());
+    REQUIRE(files[0].modules.size() == 2);
+    REQUIRE(files[0].modules[1].get_name() == "b");
+    REQUIRE(files[0].modules[1].get_statements().size() == 1);
+  }
+
+  TEST_CASE("Traced parse records spans on every worker") {
+    vector<string> paths = driver_samples();
+
+    trace_recorder trace;
+    driver_options options;
+    options.num_threads = 3;
+    options.trace = &trace;
+    parse_files(paths, options);
+
+    // A thread that got no file has no buffer
+    REQUIRE(trace.get_buffers().size() >= 1);
+    REQUIRE(trace.get_buffers().size() <= 3);
+
+    multiset<string> names;
+    set<string> parsed_modules;
+    for (auto& buf : trace.get_buffers()) {
+      uint64_t last_end = 0;
+      for (auto& ev : buf->get_events()) {
+        names.insert(ev.name);
+        if (string(ev.name) == "parse") {
+          parsed_modules.insert(ev.detail);
+        }
+        if (string(ev.name) == "file") {
+          // Files on one thread do not overlap
+          REQUIRE(ev.start_ns >= last_end);
+          last_end = ev.start_ns + ev.dur_ns;
+        }
+      }
+    }
+
+    REQUIRE(names.count("file") == paths.size());
+    REQUIRE(names.count("read") == paths.size());
+    REQUIRE(names.count("preprocess") == paths.size());
+    REQUIRE(names.count("tokenize") == paths.size());
+    REQUIRE(names.count("parse") == paths.size());
+    REQUIRE(names.count("cache lookup") == 0);
+    REQUIRE(parsed_modules.count("top") == 1);
+
+    string json = trace.to_json();
+    REQUIRE(json.find("\"traceEvents\": [") != string::npos);
+    REQUIRE(json.find("\"ph\": \"X\"") != string::npos);
+    REQUIRE(json.find("\"name\": \"parse worker ") != string::npos);
+    REQUIRE(json.find("\"detail\": \"top\"") != string::npos);
+  }
+
+  TEST_CASE("Traced parse with a cache records lookups") {
+    string dir = "/tmp/vparser-driver-cache-" + std::to_string(getpid());
+    preprocess_cache cache(dir);
+
+    vector<string> paths{"./test/samples/cb_unq1.v", "./test/samples/sb_unq1.v"};
+
+    trace_recorder trace;
+    driver_options options;
+    options.num_threads = 2;
+    options.cache = &cache;
+    options.trace = &trace;
+    parse_files(paths, options);
+    vector<parsed_file> files = parse_files(paths, options);
+
+    REQUIRE(cache.num_misses() == 2);
+    REQUIRE(cache.num_hits() == 2);
+    REQUIRE(files[1].ok());
+    REQUIRE(files[1].modules[0].to_string() == serial_parse(paths[1]));
+
+    int lookups = 0, stores = 0;
+    for (auto& buf : trace.get_buffers()) {
+      for (auto& ev : buf->get_events()) {
+        lookups += string(ev.name) == "cache lookup";
+        stores += string(ev.name) == "cache store";
+      }
+    }
+    REQUIRE(lookups == 4);
+    REQUIRE(stores == 2);
+
+    for (auto& path : paths) {
+      std::ifstream t(path);
+      std::string str((std::istreambuf_iterator<char>(t)),
+                      std::istreambuf_iterator<char>());
+      remove(cache.entry_path(str).c_str());
+    }
+    rmdir(dir.c_str());
+  }
+
+}
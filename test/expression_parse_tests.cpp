@@ -76,12 +76,72 @@ namespace vparser {
     binop_expr* bop =
       static_cast<binop_expr*>(p);
 
-    REQUIRE(bop->get_op() == "==");
+    REQUIRE(bop->get_op() == OP_LOGICAL_OR);
 
     auto lhs = bop->get_op0();
 
     REQUIRE(lhs->get_type() == EXPRESSION_BINOP);
 
+    binop_expr* lhs_bop =
+      static_cast<binop_expr*>(lhs);
+
+    REQUIRE(lhs_bop->get_op() == OP_LOGICAL_AND);
+    REQUIRE(lhs_bop->get_op1()->get_type() == EXPRESSION_BINOP);
+    REQUIRE(static_cast<binop_expr*>(lhs_bop->get_op1())->get_op() == OP_EQ);
+  }
+
+  TEST_CASE("Operators of equal precedence associate to the left") {
+    binop_expr* bop =
+      static_cast<binop_expr*>(parse_expression("a - b + c"));
+
+    REQUIRE(bop->get_op() == OP_ADD);
+    REQUIRE(bop->to_string() == "((a - b) + c)");
+  }
+
+  TEST_CASE("Unary operators bind tighter than binary operators") {
+    expression* expr = parse_expression("~a & b");
+
+    REQUIRE(expr->get_type() == EXPRESSION_BINOP);
+    REQUIRE(expr->to_string() == "((~ a) & b)");
+  }
+
+  TEST_CASE("Operator table spelling and arity") {
+    op_code op;
+
+    REQUIRE(binary_op_code("<<", op));
+    REQUIRE(op == OP_SHL);
+    REQUIRE(get_op_info(op).arity == 2);
+
+    REQUIRE(unary_op_code("~", op));
+    REQUIRE(op == OP_BITWISE_NOT);
+    REQUIRE(op_to_string(op) == "~");
+
+    REQUIRE(!binary_op_code("~", op));
+
+  }
+
+  TEST_CASE("Interned identical subexpressions are the same node") {
+    expression_interner interner;
+
+    auto e0 =
+      static_cast<binop_expr*>(parse_expression("config_addr[31:24] + config_addr[31:24]", interner));
+    auto e1 = parse_expression("config_addr[31:24]", interner);
+
+    REQUIRE(e0->get_op0() == e0->get_op1());
+    REQUIRE(e0->get_op0() == e1);
+
+    auto e2 = parse_expression("config_addr[23:16]", interner);
+    REQUIRE(e2 != e1);
+    REQUIRE(interner.get_id(e2) > interner.get_id(e1));
+
+    auto e3 = parse_expression("1'b0", interner);
+    auto e4 = parse_expression("1'b0", interner);
+    auto e5 = parse_expression("2'b0", interner);
+    REQUIRE(e3 == e4);
+    REQUIRE(e3 != e5);
+
+    REQUIRE(interner.size() < interner.get_num_requests());
+    REQUIRE(interner.memory_bytes() < interner.requested_memory_bytes());
   }
 
   
@@ -0,0 +1,134 @@
+#include "catch.hpp"
+
+#include "parallel.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace afk;
+using namespace std;
+
+namespace vparser {
+
+  TEST_CASE("parallel_for visits every index once") {
+    for (int num_threads : {1, 2, 4}) {
+      thread_pool pool(num_threads);
+      REQUIRE(pool.size() == num_threads);
+
+      vector<atomic<int> > visits(1000);
+      for (auto& v : visits) {
+        v = 0;
+      }
+
+      REQUIRE(parallel_for(pool, visits.size(), [&visits](const size_t i) {
+            visits[i]++;
+          }));
+
+      for (auto& v : visits) {
+        REQUIRE(v == 1);
+      }
+    }
+  }
+
+  TEST_CASE("parallel_for over a container") {
+    thread_pool pool(3);
+    vector<int> elems;
+    for (int i = 0; i < 500; i++) {
+      elems.push_back(i);
+    }
+
+    atomic<int> sum(0);
+    parallel_for(pool, elems, [&sum](const int e) { sum += e; });
+    REQUIRE(sum == 499*500/2);
+  }
+
+  TEST_CASE("parallel_map keeps the order of its input") {
+    thread_pool pool(4);
+    vector<int> elems;
+    for (int i = 0; i < 777; i++) {
+      elems.push_back(i);
+    }
+
+    vector<string> strs =
+      parallel_map(pool, elems, [](const int e) { return std::to_string(e); });
+
+    REQUIRE(strs.size() == elems.size());
+    for (int i = 0; i < (int) elems.size(); i++) {
+      REQUIRE(strs[i] == std::to_string(i));
+    }
+  }
+
+  TEST_CASE("parallel_reduce gives the same result on any pool") {
+    vector<double> elems;
+    for (int i = 1; i <= 10000; i++) {
+      elems.push_back(1.0 / i);
+    }
+
+    auto add = [](const double a, const double b) { return a + b; };
+
+    vector<double> sums;
+    for (int num_threads : {1, 3, 8}) {
+      thread_pool pool(num_threads);
+      sums.push_back(parallel_reduce(pool, elems, 0.0, add));
+    }
+
+    // Bitwise equal, not just close
+    REQUIRE(sums[0] == sums[1]);
+    REQUIRE(sums[0] == sums[2]);
+
+    thread_pool pool(2);
+    size_t num_long =
+      parallel_reduce(pool, elems, (size_t) 0,
+                      [](const size_t n, const double e) { return n + (e > 0.01); },
+                      [](const size_t a, const size_t b) { return a + b; },
+                      7);
+    REQUIRE(num_long == 99);
+
+    REQUIRE(parallel_reduce(pool, vector<int>(), 5, add) == 5);
+  }
+
+  TEST_CASE("Cancelled loops skip what has not started") {
+    thread_pool pool(2);
+    cancellation_token cancel;
+
+    atomic<int> visited(0);
+    bool finished = parallel_for(pool, 10000, [&visited, &cancel](const size_t i) {
+        visited++;
+        if (i == 10) {
+          cancel.cancel();
+        }
+      }, &cancel, 1);
+
+    REQUIRE(!finished);
+    REQUIRE(visited < 10000);
+
+    // A token cancelled before the loop stops every element
+    visited = 0;
+    REQUIRE(!parallel_for(pool, 100, [&visited](const size_t) { visited++; }, &cancel));
+    REQUIRE(visited == 0);
+  }
+
+  TEST_CASE("Exceptions in a loop reach its caller") {
+    thread_pool pool(3);
+    REQUIRE_THROWS_AS(parallel_for(pool, 100, [](const size_t i) {
+          if (i == 42) {
+            throw std::runtime_error("bad element");
+          }
+        }), const std::runtime_error&);
+
+    // The pool still works afterwards
+    atomic<int> visited(0);
+    parallel_for(pool, 100, [&visited](const size_t) { visited++; });
+    REQUIRE(visited == 100);
+  }
+
+  TEST_CASE("Nested loops share the pool without deadlock") {
+    thread_pool pool(2);
+    atomic<int> visited(0);
+    parallel_for(pool, 16, [&pool, &visited](const size_t) {
+        parallel_for(pool, 64, [&visited](const size_t) { visited++; }, nullptr, 1);
+      }, nullptr, 1);
+    REQUIRE(visited == 16*64);
+  }
+
+}
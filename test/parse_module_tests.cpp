@@ -1,11 +1,14 @@
 #include "catch.hpp"
 
+#include "flat_ast.h"
 #include "macro_def.h"
 #include "parse.h"
+#include "skim.h"
 #include "tokenize.h"
 
 #include <fstream>
 #include <iostream>
+#include <thread>
 
 using namespace std;
 
@@ -112,6 +115,43 @@ namespace vparser {
     
   }
 
+  TEST_CASE("Source map for macro expanded tokens") {
+    string str = "`define xassert(condition, message) if(condition) begin $display(message); $finish(1); end\nmodule test_mod();\n `xassert(in == out, \"No way man!!!\")\nendmodule";
+
+    preprocessed_verilog prep =
+      preprocess_code(str);
+
+    REQUIRE(prep.map.get_expansions().size() == 1);
+
+    SECTION("Expanded tokens point at the macro use and definition") {
+      // " module test_mod ( ) ; if ..."
+      source_location loc = prep.locate(5);
+
+      REQUIRE(loc.from_macro());
+      REQUIRE(prep.defs[loc.macro].get_name() == "xassert");
+      REQUIRE(loc.pos.lineNo == 3);
+      REQUIRE(loc.pos.linePos == 2);
+      REQUIRE(loc.def_pos.lineNo == 1);
+    }
+
+    SECTION("Tokens before the expansion keep their own position") {
+      source_location loc = prep.locate(1);
+
+      REQUIRE(!loc.from_macro());
+      REQUIRE(loc.pos.lineNo == 2);
+      REQUIRE(loc.pos.linePos == 8);
+    }
+
+    SECTION("Tokens after the expansion keep their own position") {
+      int last = tokenize(prep.text).size() - 1;
+      source_location loc = prep.locate(last);
+
+      REQUIRE(!loc.from_macro());
+      REQUIRE(loc.pos.lineNo == 4);
+      REQUIRE(loc.pos.linePos == 1);
+    }
+  }
+
   TEST_CASE("Preprocess no argument macro") {
     string str = "`define MV_TO_RAM (phase==1'b0 && (input_count > 2'd1 || (input_count==2'd1 && wen)))\n`MV_TO_RAM";
 
@@ -131,6 +171,59 @@ namespace vparser {
     
   }
 
+  TEST_CASE("Malformed statements are reported and skipped") {
+    string str = "module m(input a, output b);\n assign b = ;\n assign c = a;\n always @(posedge clk) begin\n  x <= ;\n  y <= a;\n end\n foo bar baz;\n assign d = a;\nendmodule";
+
+    diagnostic_engine diags;
+    verilog_module vm = parse_module(str, diags);
+
+    cout << diags.to_string() << endl;
+
+    REQUIRE(diags.num_errors() == 3);
+    REQUIRE(vm.get_port_names().size() == 2);
+
+    SECTION("Statements after each error are still parsed") {
+      REQUIRE(vm.get_statements().size() == 3);
+      REQUIRE(vm.get_statements()[0]->get_type() == STATEMENT_ASSIGN);
+      REQUIRE(vm.get_statements()[1]->get_type() == STATEMENT_ALWAYS);
+      REQUIRE(vm.get_statements()[2]->get_type() == STATEMENT_ASSIGN);
+
+      always_stmt* astmt =
+        static_cast<always_stmt*>(vm.get_statements()[1]);
+      begin_stmt* bstmt =
+        static_cast<begin_stmt*>(astmt->get_statement());
+
+      REQUIRE(bstmt->get_statements().size() == 1);
+    }
+
+    SECTION("Errors have positions and bounded context") {
+      const diagnostic& first = diags.get_diagnostics()[0];
+
+      REQUIRE(first.pos.lineNo == 2);
+      REQUIRE(first.pos.linePos == 13);
+      REQUIRE(first.context.size() <= 123);
+    }
+  }
+
+  TEST_CASE("Truncated module returns partial result") {
+    string str = "module m(input a); assign b = a; always @(posedge clk) begin if (a";
+
+    diagnostic_engine diags;
+    verilog_module vm = parse_module(str, diags);
+
+    REQUIRE(diags.has_errors());
+    REQUIRE(vm.get_name() == "m");
+    REQUIRE(vm.get_statements().size() == 1);
+  }
+
+  TEST_CASE("Non-aborting statement parse returns null on error") {
+    diagnostic_engine diags;
+    statement* stmt = parse_statement("assign = b;", diags);
+
+    REQUIRE(stmt == nullptr);
+    REQUIRE(diags.num_errors() == 1);
+  }
+
   TEST_CASE("Parse module with parameters") {
     string str = "module corebit_const #(parameter value=1) ( output out ); assign out = value; endmodule //corebit_const";
 
@@ -225,6 +318,197 @@ namespace vparser {
 
   }
 
+  TEST_CASE("Lazy module bodies are parsed on first access") {
+    std::ifstream t("./test/samples/cb_unq1.v");
+    std::string str((std::istreambuf_iterator<char>(t)),
+		    std::istreambuf_iterator<char>());
+
+    verilog_module vm = parse_module_lazy(str);
+
+    REQUIRE(vm.get_name() == "cb_unq1");
+    REQUIRE(vm.get_port_names().size() == 16);
+    REQUIRE(!vm.body_parsed());
+
+    SECTION("Body matches an eager parse") {
+      verilog_module eager = parse_module(str);
+
+      REQUIRE(vm.get_statements().size() == 19);
+      REQUIRE(vm.body_parsed());
+      REQUIRE(vm.to_string() == eager.to_string());
+    }
+
+    SECTION("Concurrent first accesses parse the body once") {
+      vector<int> sizes(4, 0);
+      vector<std::thread> threads;
+      for (int i = 0; i < 4; i++) {
+        threads.push_back(std::thread([&vm, &sizes, i]() {
+              sizes[i] = vm.get_statements().size();
+            }));
+      }
+
+      for (auto& th : threads) {
+        th.join();
+      }
+
+      for (auto sz : sizes) {
+        REQUIRE(sz == 19);
+      }
+    }
+  }
+
+  TEST_CASE("Lazy module body errors are collected") {
+    string str = "module m(input a); assign b = ; assign c = a; endmodule";
+
+    diagnostic_engine diags;
+    verilog_module vm = parse_module_lazy(str, diags);
+
+    REQUIRE(!diags.has_errors());
+    REQUIRE(vm.get_statements().size() == 1);
+    REQUIRE(vm.get_body_diagnostics()->num_errors() == 1);
+  }
+
+  TEST_CASE("Skimming finds the same hierarchy as a full parse") {
+    vector<string> paths = {
+      "./test/samples/cb_unq1.v",
+      "./test/samples/memory_core_unq1.v",
+      "./test/samples/memory_tile_unq1.v",
+      "./test/samples/pe_tile_new_unq1.v",
+      "./test/samples/sb_unq1.v",
+      "./test/samples/top.v"};
+
+    for (auto& path : paths) {
+      std::ifstream t(path);
+      std::string str((std::istreambuf_iterator<char>(t)),
+                      std::istreambuf_iterator<char>());
+
+      hierarchy_graph graph = skim_hierarchy(str);
+
+      REQUIRE(graph.modules.size() == 1);
+
+      verilog_module vm = parse_module(preprocess_code(str).text);
+      const skim_module& sm = graph.modules[0];
+
+      REQUIRE(sm.name == vm.get_name());
+      REQUIRE(sm.port_names == vm.get_port_names());
+
+      vector<module_instantiation_stmt*> insts;
+      for (auto stmt : vm.get_statements()) {
+        if (stmt->get_type() == STATEMENT_MODULE_INSTANTIATION) {
+          insts.push_back(static_cast<module_instantiation_stmt*>(stmt));
+        }
+      }
+
+      REQUIRE(sm.instances.size() == insts.size());
+
+      for (unsigned i = 0; i < insts.size(); i++) {
+        REQUIRE(sm.instances[i].module_type == insts[i]->get_module_type());
+        REQUIRE(sm.instances[i].name == insts[i]->get_name());
+
+        auto ports = insts[i]->get_port_assignments();
+        REQUIRE(sm.instances[i].port_names.size() == ports.size());
+        for (unsigned j = 0; j < ports.size(); j++) {
+          REQUIRE(sm.instances[i].port_names[j] == ports[j].first);
+        }
+      }
+    }
+  }
+
+  TEST_CASE("Skimmed hierarchy build order puts children first") {
+    string str = "module top(input clk); mid m0(.clk(clk)); leaf l0(.a(clk)); endmodule\nmodule mid(input clk); leaf #(.W(4)) l1(.a(clk[0])); endmodule\nmodule leaf(input [3:0] a); assign b = a; endmodule";
+
+    hierarchy_graph graph = skim_hierarchy(str);
+
+    REQUIRE(graph.modules.size() == 3);
+    REQUIRE(graph.modules[2].port_names.size() == 1);
+    REQUIRE(graph.modules[2].port_names[0] == "a");
+    REQUIRE(graph.modules[1].instances.size() == 1);
+    REQUIRE(graph.modules[1].instances[0].module == 2);
+
+    vector<int> order = graph.build_order();
+
+    REQUIRE(order.size() == 3);
+    REQUIRE(order[0] == 2);
+    REQUIRE(order[1] == 1);
+    REQUIRE(order[2] == 0);
+  }
+
+  TEST_CASE("Flat AST round trips every sample module") {
+    vector<string> paths = {
+      "./test/samples/cb_unq1.v",
+      "./test/samples/memory_core_unq1.v",
+      "./test/samples/memory_tile_unq1.v",
+      "./test/samples/pe_tile_new_unq1.v",
+      "./test/samples/sb_unq1.v",
+      "./test/samples/top.v"};
+
+    flat_ast ast;
+    vector<string> expected;
+    size_t text_bytes = 0;
+    for (auto& path : paths) {
+      std::ifstream t(path);
+      std::string str((std::istreambuf_iterator<char>(t)),
+                      std::istreambuf_iterator<char>());
+      text_bytes += str.size();
+
+      verilog_module vm = parse_module(preprocess_code(str).text);
+      REQUIRE(ast.add_module(vm) == expected.size());
+      expected.push_back(vm.to_string());
+    }
+
+    flat_ast_view view = ast.view();
+
+    REQUIRE(view.modules.size() == paths.size());
+    REQUIRE(view.num_nodes() > 0);
+    REQUIRE(ast.memory_bytes() < text_bytes);
+
+    for (unsigned i = 0; i < expected.size(); i++) {
+      verilog_module vm = view.to_module(i);
+      REQUIRE(vm.to_string() == expected[i]);
+    }
+  }
+
+  TEST_CASE("Flat AST node ids encode kind and index") {
+    flat_ast ast;
+    expression* e = parse_expression("a + b[3 : 0]");
+    node_id id = ast.add_expression(e);
+
+    flat_ast_view view = ast.view();
+
+    REQUIRE(view.get_expr_type(id) == EXPRESSION_BINOP);
+    REQUIRE(node_index(id) == 0);
+    REQUIRE(view.num_nodes() == 6);
+
+    const flat_binop_expr& b = view.binop_exprs[node_index(id)];
+    REQUIRE(view.get_expr_type(b.operand0) == EXPRESSION_ID);
+    REQUIRE(view.get_expr_type(b.operand1) == EXPRESSION_SLICE);
+
+    expression* round = view.to_expression(id);
+    REQUIRE(round->to_string() == e->to_string());
+
+    REQUIRE(ast.add_expression(nullptr) == null_node);
+  }
+
+  TEST_CASE("Hash-consed parse of top.v prints the same module") {
+    std::ifstream t("./test/samples/top.v");
+    std::string str((std::istreambuf_iterator<char>(t)),
+                    std::istreambuf_iterator<char>());
+    string text = preprocess_code(str).text;
+
+    verilog_module vm = parse_module(text);
+
+    expression_interner interner;
+    verilog_module ivm = parse_module(text, interner);
+
+    REQUIRE(ivm.to_string() == vm.to_string());
+
+    cout << "top.v expressions: " << interner.get_num_requests()
+         << " parsed, " << interner.size() << " unique, "
+         << interner.requested_memory_bytes() << " -> "
+         << interner.memory_bytes() << " bytes" << endl;
+
+    REQUIRE(interner.size() < interner.get_num_requests());
+  }
+
   void parse_verilog_file(const std::string& path) {
     std::ifstream t(path);
     std::string str((std::istreambuf_iterator<char>(t)),
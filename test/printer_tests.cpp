@@ -0,0 +1,87 @@
+#include "catch.hpp"
+
+#include "macro_def.h"
+#include "parse.h"
+#include "printer.h"
+
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace vparser {
+
+  TEST_CASE("Streamed module text matches to_string") {
+    vector<string> samples{"cb_unq1.v", "memory_tile_unq1.v", "sb_unq1.v", "top.v"};
+
+    for (auto& sample : samples) {
+      std::ifstream t("./test/samples/" + sample);
+      std::string str((std::istreambuf_iterator<char>(t)),
+                      std::istreambuf_iterator<char>());
+      verilog_module vm = parse_module(preprocess_code(str).text);
+
+      // A small flush size so the text crosses many flushes
+      stringstream ss;
+      {
+        output_buffer out(ss, 100);
+        ast_printer(out).print(vm);
+      }
+
+      stringstream whole;
+      vm.print(whole);
+
+      REQUIRE(ss.str() == vm.to_string());
+      REQUIRE(whole.str() == vm.to_string());
+    }
+  }
+
+  TEST_CASE("Printer indents nested statements") {
+    statement* s =
+      parse_statement("always @(posedge clk) begin if (a) b <= c; else d <= e; end");
+
+    output_buffer out;
+    ast_printer printer(out);
+    printer.set_level(1);
+    printer.print(s);
+
+    REQUIRE(printer.get_level() == 1);
+    REQUIRE(out.str() ==
+            "  always @(posedge clk)\n"
+            "    begin\n"
+            "      if (a)\n"
+            "        b <= c;      else\n"
+            "        d <= e;\n"
+            "\n"
+            "    end\n");
+    REQUIRE(out.str() == s->to_string(1));
+  }
+
+  TEST_CASE("Printer indents past the constant run of spaces") {
+    string text = "x = 1;";
+    for (int i = 0; i < 40; i++) {
+      text = "if (a) " + text;
+    }
+
+    statement* s = parse_statement(text);
+    string printed = s->to_string(0);
+
+    REQUIRE(printed.find("\n" + string(80, ' ') + "x = 32'd1;") != string::npos);
+  }
+
+  TEST_CASE("Printer reuses its buffer") {
+    expression* e = parse_expression("{a, b[3:0], 4'hf} + ~c");
+
+    output_buffer out;
+    ast_printer printer(out);
+    printer.print(e);
+    string first = out.str();
+
+    out.clear();
+    printer.print(e);
+
+    REQUIRE(out.str() == first);
+    REQUIRE(first == e->to_string());
+    REQUIRE(first == "({ a, (b[ 32'd3 : 32'd0 ]), 4'hf } + (~ c))");
+  }
+
+}
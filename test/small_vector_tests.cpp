@@ -0,0 +1,131 @@
+#include "catch.hpp"
+
+#include "parse.h"
+#include "small_vector.h"
+
+#include <string>
+
+using namespace std;
+
+namespace vparser {
+
+  // Counts heap allocations made through it
+  template<typename T>
+  class counting_allocator {
+  public:
+    typedef T value_type;
+
+    int* num_allocs;
+
+    counting_allocator(int* num_allocs_) : num_allocs(num_allocs_) {}
+
+    template<typename U>
+    counting_allocator(const counting_allocator<U>& other) :
+      num_allocs(other.num_allocs) {}
+
+    T* allocate(const size_t n) {
+      (*num_allocs)++;
+      return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, const size_t n) {
+      std::allocator<T>().deallocate(p, n);
+    }
+  };
+
+  TEST_CASE("Small vector stays inline up to its inline capacity") {
+    small_vector<int, 4> v;
+    for (int i = 0; i < 4; i++) {
+      v.push_back(i);
+    }
+
+    REQUIRE(v.is_inline());
+    REQUIRE(v.size() == 4);
+    REQUIRE(v[3] == 3);
+
+    v.push_back(4);
+
+    REQUIRE(!v.is_inline());
+    REQUIRE(v.size() == 5);
+    for (int i = 0; i < 5; i++) {
+      REQUIRE(v[i] == i);
+    }
+  }
+
+  TEST_CASE("Small vector copies and moves non trivial elements") {
+    small_vector<string, 2> a;
+    a.push_back("a long string that does not fit in the small string buffer");
+    a.emplace_back("b");
+
+    small_vector<string, 2> b = a;
+    REQUIRE(b == a);
+
+    small_vector<string, 2> c = std::move(a);
+    REQUIRE(c == b);
+    REQUIRE(a.size() == 0);
+
+    c.push_back("c");
+    REQUIRE(!c.is_inline());
+
+    const string* heap_elems = c.data();
+    small_vector<string, 2> d = std::move(c);
+    REQUIRE(d.data() == heap_elems);
+    REQUIRE(d.size() == 3);
+    REQUIRE(d[2] == "c");
+    REQUIRE(c.is_inline());
+
+    d.pop_back();
+    b = d;
+    REQUIRE(b.size() == 2);
+    REQUIRE(b[1] == "b");
+  }
+
+  TEST_CASE("Small vector only uses its allocator after spilling") {
+    int num_allocs = 0;
+    counting_allocator<int> alloc(&num_allocs);
+
+    small_vector<int, 2, counting_allocator<int> > v(alloc);
+    v.push_back(1);
+    v.push_back(2);
+
+    REQUIRE(num_allocs == 0);
+
+    v.push_back(3);
+
+    REQUIRE(num_allocs == 1);
+  }
+
+  TEST_CASE("Small vector can push its own elements when full") {
+    string first = "a long string that does not fit in the small string buffer";
+    small_vector<string, 2> v{first, "b"};
+
+    // Spills to the heap, then grows the heap buffer
+    v.push_back(v[0]);
+    v.push_back(v[1]);
+    v.push_back(v[2]);
+    v.emplace_back(v[0]);
+
+    REQUIRE(v.size() == 6);
+    REQUIRE(v[2] == first);
+    REQUIRE(v[3] == "b");
+    REQUIRE(v[4] == first);
+    REQUIRE(v[5] == first);
+  }
+
+  TEST_CASE("Short AST child lists are stored inline") {
+    statement* stmt =
+      parse_statement("always @(posedge clk) begin a <= {b, c}; end");
+
+    auto blk =
+      static_cast<begin_stmt*>(static_cast<always_stmt*>(stmt)->get_statement());
+    REQUIRE(blk->get_statements().size() == 1);
+    REQUIRE(blk->get_statements().is_inline());
+
+    auto assign =
+      static_cast<non_blocking_assign_stmt*>(blk->get_statements()[0]);
+    auto concat = static_cast<concat_expr*>(assign->get_rhs());
+    REQUIRE(concat->get_exprs().size() == 2);
+    REQUIRE(concat->get_exprs().is_inline());
+  }
+
+}
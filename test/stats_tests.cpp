@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include "flat_ast.h"
+#include "macro_def.h"
+#include "tokenize.h"
+#include "visitor.h"
+
+#include <fstream>
+
+using namespace std;
+
+namespace vparser {
+
+  static std::string read_sample(const string& name) {
+    std::ifstream t("./test/samples/" + name);
+    return std::string((std::istreambuf_iterator<char>(t)),
+                       std::istreambuf_iterator<char>());
+  }
+
+  TEST_CASE("Stats follow a file through every phase") {
+    string str = read_sample("memory_core_unq1.v");
+
+    parse_stats stats;
+    preprocessed_verilog prep = preprocess_code(str, stats);
+    verilog_module vm = parse_module(prep.text, stats);
+
+    REQUIRE(stats.preprocess.calls == 1);
+    REQUIRE(stats.preprocess.bytes == str.size());
+    REQUIRE(stats.macro_expansions == prep.map.get_expansions().size());
+    REQUIRE(stats.macro_expansions > 0);
+
+    REQUIRE(stats.tokenize.calls == 1);
+    REQUIRE(stats.tokenize.bytes == prep.text.size());
+    REQUIRE(stats.tokenize.tokens == tokenize(prep.text).size());
+    REQUIRE(stats.preprocess.tokens == stats.tokenize.tokens);
+
+    REQUIRE(stats.parse.calls == 1);
+    REQUIRE(stats.parse.tokens == stats.tokenize.tokens);
+    REQUIRE(stats.parse.wall_ns > 0);
+
+    REQUIRE(stats.max_depth > 1);
+    REQUIRE(stats.ast_bytes > 0);
+  }
+
+  TEST_CASE("Stats count every node by type") {
+    verilog_module vm = parse_module(preprocess_code(read_sample("top.v")).text);
+
+    parse_stats stats;
+    verilog_module counted =
+      parse_module(preprocess_code(read_sample("top.v")).text, stats);
+
+    flat_ast ast;
+    ast.add_module(vm);
+    flat_ast_view view = ast.view();
+
+    REQUIRE(stats.expressions[EXPRESSION_ID] == view.id_exprs.size());
+    REQUIRE(stats.expressions[EXPRESSION_BINOP] == view.binop_exprs.size());
+    REQUIRE(stats.statements[STATEMENT_MODULE_INSTANTIATION] ==
+            view.module_instantiation_stmts.size());
+    REQUIRE(stats.statements[STATEMENT_DECL] == view.decl_stmts.size());
+    REQUIRE(stats.num_expressions() + stats.num_statements() == view.num_nodes());
+  }
+
+  TEST_CASE("Max depth grows with nesting") {
+    parse_stats shallow, deep;
+    parse_module("module m(); assign a = b; endmodule", shallow);
+    parse_module("module m(); assign a = ((((b)))); endmodule", deep);
+
+    REQUIRE(deep.max_depth > shallow.max_depth);
+  }
+
+  TEST_CASE("Stats sum over files and export as JSON") {
+    parse_stats a, b, total;
+    parse_module("module m(); assign a = b + c; endmodule", a);
+    parse_module("module n(); assign d = e; endmodule", b);
+    total.add(a);
+    total.add(b);
+
+    REQUIRE(total.parse.calls == 2);
+    REQUIRE(total.statements[STATEMENT_ASSIGN] == 2);
+    REQUIRE(total.expressions[EXPRESSION_BINOP] == 1);
+    REQUIRE(total.num_expressions() == 6);
+
+    string json = total.to_json();
+    REQUIRE(json.find("\"parse\": {\"calls\": 2,") != string::npos);
+    REQUIRE(json.find("\"binop\": 1") != string::npos);
+    REQUIRE(json.find("\"assign\": 2") != string::npos);
+    REQUIRE(json.find("\"max_depth\": ") != string::npos);
+
+    total.clear();
+    REQUIRE(total.num_expressions() == 0);
+    REQUIRE(total.parse.calls == 0);
+  }
+
+}
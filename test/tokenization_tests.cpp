@@ -30,6 +30,16 @@ namespace vparser {
     REQUIRE(toks[1].get_text() == "&&");
   }
 
+  TEST_CASE("Unsupported characters are reported and skipped") {
+    string test_str = "assign a = b;\n assign c = d %% e;";
+    diagnostic_engine diags;
+    vector<token> tokens = tokenize(test_str, diags);
+
+    REQUIRE(diags.num_errors() == 2);
+    REQUIRE(diags.get_diagnostics()[0].pos.lineNo == 2);
+    REQUIRE(tokens.size() == 11);
+  }
+
   TEST_CASE("Comment line") {
     string test_str = " \n // Hello this is a comment string // asdf\n asdf //";
     vector<token> tokens = tokenize(test_str);
@@ -0,0 +1,183 @@
+#include "catch.hpp"
+
+#include "flat_ast.h"
+#include "macro_def.h"
+#include "visitor.h"
+
+#include <fstream>
+
+using namespace std;
+
+namespace vparser {
+
+  class node_counter : public ast_visitor<node_counter> {
+  public:
+    int num_exprs;
+    int num_stmts;
+    int num_ids;
+    int num_instances;
+
+    node_counter() :
+      num_exprs(0), num_stmts(0), num_ids(0), num_instances(0) {}
+
+    visit_result pre_expression(const expression*) {
+      num_exprs++;
+      return VISIT_CONTINUE;
+    }
+
+    visit_result pre_statement(const statement*) {
+      num_stmts++;
+      return VISIT_CONTINUE;
+    }
+
+    visit_result pre_id(const id_expr* e) {
+      num_ids++;
+      return pre_expression(e);
+    }
+
+    visit_result pre_module_instantiation(const module_instantiation_stmt* s) {
+      num_instances++;
+      return pre_statement(s);
+    }
+  };
+
+  class first_instance_finder : public ast_visitor<first_instance_finder> {
+  public:
+    int num_seen;
+    const module_instantiation_stmt* found;
+
+    first_instance_finder() : num_seen(0), found(nullptr) {}
+
+    visit_result pre_module_instantiation(const module_instantiation_stmt* s) {
+      num_seen++;
+      found = s;
+      return VISIT_STOP;
+    }
+  };
+
+  // Records the node types in post order
+  class post_order_recorder : public ast_visitor<post_order_recorder> {
+  public:
+    vector<expression_type> order;
+
+    visit_result post_expression(const expression* e) {
+      order.push_back(e->get_type());
+      return VISIT_CONTINUE;
+    }
+  };
+
+  class always_skipper : public ast_visitor<always_skipper> {
+  public:
+    int num_assigns;
+
+    always_skipper() : num_assigns(0) {}
+
+    visit_result pre_always(const always_stmt*) {
+      return VISIT_SKIP_CHILDREN;
+    }
+
+    visit_result pre_non_blocking_assign(const non_blocking_assign_stmt*) {
+      num_assigns++;
+      return VISIT_CONTINUE;
+    }
+  };
+
+  class id_renamer : public ast_mutator<id_renamer> {
+  public:
+    string from, to;
+
+    id_renamer(const string& from_, const string& to_) :
+      from(from_), to(to_) {}
+
+    expression* rewrite_id(id_expr* e) {
+      return e->get_name() == from ? new id_expr(to) : e;
+    }
+  };
+
+  verilog_module parse_sample(const string& path) {
+    std::ifstream t(path);
+    std::string str((std::istreambuf_iterator<char>(t)),
+                    std::istreambuf_iterator<char>());
+    return parse_module(preprocess_code(str).text);
+  }
+
+  TEST_CASE("Visitor counts match the flat AST node counts") {
+    verilog_module vm = parse_sample("./test/samples/top.v");
+
+    node_counter counter;
+    REQUIRE(counter.walk(vm));
+
+    flat_ast ast;
+    ast.add_module(vm);
+    flat_ast_view view = ast.view();
+
+    REQUIRE(counter.num_exprs + counter.num_stmts == (int) view.num_nodes());
+    REQUIRE(counter.num_ids == (int) view.id_exprs.size());
+    REQUIRE(counter.num_instances ==
+            (int) view.module_instantiation_stmts.size());
+  }
+
+  TEST_CASE("Visitor stops at the first module instantiation") {
+    verilog_module vm = parse_sample("./test/samples/top.v");
+
+    first_instance_finder finder;
+    REQUIRE(!finder.walk(vm));
+    REQUIRE(finder.num_seen == 1);
+    REQUIRE(finder.found != nullptr);
+  }
+
+  TEST_CASE("Visitor post order visits operands first") {
+    expression* e = parse_expression("a + ~b");
+
+    post_order_recorder rec;
+    REQUIRE(rec.walk(e));
+
+    REQUIRE(rec.order.size() == 4);
+    REQUIRE(rec.order[0] == EXPRESSION_ID);
+    REQUIRE(rec.order[1] == EXPRESSION_ID);
+    REQUIRE(rec.order[2] == EXPRESSION_UNOP);
+    REQUIRE(rec.order[3] == EXPRESSION_BINOP);
+  }
+
+  TEST_CASE("Visitor skips children") {
+    verilog_module vm =
+      parse_module("module m(input clk); always @(posedge clk) begin a <= b; end endmodule");
+
+    always_skipper skipper;
+    REQUIRE(skipper.walk(vm));
+    REQUIRE(skipper.num_assigns == 0);
+  }
+
+  TEST_CASE("Mutator rebuilds only changed subtrees") {
+    statement* s = parse_statement("assign y = (a + b[c]) & d;");
+
+    id_renamer renamer("a", "x");
+    statement* r = renamer.rewrite(s);
+
+    REQUIRE(r != s);
+    REQUIRE(r->to_string(0) == "assign y = ((x + (b[ c : c ])) & d);");
+
+    auto old_rhs = static_cast<binop_expr*>(static_cast<assign_stmt*>(s)->get_rhs());
+    auto new_rhs = static_cast<binop_expr*>(static_cast<assign_stmt*>(r)->get_rhs());
+    REQUIRE(new_rhs != old_rhs);
+    REQUIRE(new_rhs->get_op1() == old_rhs->get_op1());
+
+    id_renamer unused("q", "x");
+    REQUIRE(unused.rewrite(s) == s);
+  }
+
+  TEST_CASE("Mutator rewrites a module in place") {
+    verilog_module vm = parse_sample("./test/samples/cb_unq1.v");
+    string before = vm.to_string();
+
+    id_renamer renamer("config_data", "cfg_data");
+    renamer.rewrite(vm);
+
+    // The port list still uses the old name
+    string after = vm.to_string();
+    REQUIRE(before.find("cfg_data") == string::npos);
+    REQUIRE(after.find("cfg_data") != string::npos);
+    REQUIRE(vm.get_port_names() == parse_sample("./test/samples/cb_unq1.v").get_port_names());
+  }
+
+}